@@ -0,0 +1,135 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/yacap.h"
+#include "allocator.h"
+
+
+static void *
+_counted_alloc(size_t size, void *userptr) {
+    struct allocator_counter *c = userptr;
+
+    if (c->stats) {
+        c->stats->allocations++;
+        c->stats->allocated += size;
+    }
+
+    return allocator_alloc(c->next, size);
+}
+
+
+/* only the growth is counted as allocated */
+static void *
+_counted_realloc(void *ptr, size_t oldsize, size_t size, void *userptr) {
+    struct allocator_counter *c = userptr;
+
+    if (c->stats) {
+        c->stats->reallocations++;
+        if (size > oldsize) {
+            c->stats->allocated += size - oldsize;
+        }
+    }
+
+    return allocator_realloc(c->next, ptr, oldsize, size);
+}
+
+
+static void
+_counted_free(void *ptr, void *userptr) {
+    struct allocator_counter *c = userptr;
+
+    allocator_free(c->next, ptr);
+}
+
+
+void
+allocator_counter_init(struct allocator_counter *c,
+        const struct yacap_allocator *next, struct yacap_stats *stats) {
+    c->allocator.alloc = _counted_alloc;
+    c->allocator.realloc = _counted_realloc;
+    c->allocator.free = _counted_free;
+    c->allocator.userptr = c;
+    c->next = next;
+    c->stats = stats;
+}
+
+
+void *
+allocator_alloc(const struct yacap_allocator *a, size_t size) {
+    if (a == NULL) {
+        return malloc(size);
+    }
+
+    return a->alloc(size, a->userptr);
+}
+
+
+void *
+allocator_calloc(const struct yacap_allocator *a, size_t count, size_t size) {
+    void *ptr;
+
+    if (a == NULL) {
+        return calloc(count, size);
+    }
+
+    if (size && (count > (SIZE_MAX / size))) {
+        return NULL;
+    }
+
+    ptr = a->alloc(count * size, a->userptr);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+
+    return ptr;
+}
+
+
+void *
+allocator_realloc(const struct yacap_allocator *a, void *ptr, size_t oldsize,
+        size_t size) {
+    if (a == NULL) {
+        return realloc(ptr, size);
+    }
+
+    /* the user's realloc never sees a NULL pointer */
+    if (ptr == NULL) {
+        return a->alloc(size, a->userptr);
+    }
+
+    return a->realloc(ptr, oldsize, size, a->userptr);
+}
+
+
+void
+allocator_free(const struct yacap_allocator *a, void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    if (a == NULL) {
+        free(ptr);
+        return;
+    }
+
+    a->free(ptr, a->userptr);
+}
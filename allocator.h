@@ -0,0 +1,62 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+
+#include <stddef.h>
+
+#include "include/yacap.h"
+
+
+/* an allocator which counts the calls into the stats and forwards them to
+ * the next one, the libc allocator when next is NULL. nothing is counted
+ * while stats is NULL. */
+struct allocator_counter {
+    struct yacap_allocator allocator;
+    const struct yacap_allocator *next;
+    struct yacap_stats *stats;
+};
+
+
+void
+allocator_counter_init(struct allocator_counter *c,
+        const struct yacap_allocator *next, struct yacap_stats *stats);
+
+
+/* the libc allocator is used when a is NULL */
+void *
+allocator_alloc(const struct yacap_allocator *a, size_t size);
+
+
+void *
+allocator_calloc(const struct yacap_allocator *a, size_t count, size_t size);
+
+
+/* ptr may be NULL, oldsize is the bytes of ptr in use */
+void *
+allocator_realloc(const struct yacap_allocator *a, void *ptr, size_t oldsize,
+        size_t size);
+
+
+void
+allocator_free(const struct yacap_allocator *a, void *ptr);
+
+
+#endif  // ALLOCATOR_H_
@@ -16,130 +16,381 @@
  *
  *  Author: Vahid Mardani <vahid.mardani@gmail.com>
  */
-#include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
-#include <limits.h>
 
 #include "arghint.h"
 
 
-#define ISSET(i, b) (i & (1 << (b)))
-#define SETBIT(i, b) (i |= (1 << (b)))
-#define MAXBITS 32
-#define MAXARGS (MAXBITS - 2)
-#define ARGSMASK (~(3 << MAXARGS))
+#define NFA_STATES ARGHINT_STATES
+#define NFA_EDGES ARGHINT_EDGES
+#define NFA_NESTING 32
+#define SETWORDS (NFA_STATES / 64)
+#define ISSET(s, i) ((s)[(i) / 64] & ((uint64_t)1 << ((i) % 64)))
+#define SETBIT(s, i) ((s)[(i) / 64] |= ((uint64_t)1 << ((i) % 64)))
+#define ISDOTS(p) (((p)[0] == '.') && ((p)[1] == '.') && ((p)[2] == '.'))
+#define ISEND(c) (((c) == ' ') || ((c) == ']') || ((c) == '\n') || \
+        ((c) == 0))
 
 
-int
-arghint_validate(size_t count, int pattern) {
-    int argspat = pattern & ARGSMASK;
+typedef uint64_t stateset[SETWORDS];
+
+
+static int
+_state(struct arghint_nfa *n) {
+    if (n->states == NFA_STATES) {
+        n->overflow = true;
+        return -1;
+    }
+
+    return n->states++;
+}
+
+
+static int
+_edge(struct arghint_nfa *n, int from, int to, bool word) {
+    if (n->edges == NFA_EDGES) {
+        n->overflow = true;
+        return -1;
+    }
+
+    n->edge[n->edges++] = (struct arghint_edge) {from, to, word};
+    return 0;
+}
+
 
-    if (count > MAXARGS) {
-        if (ISSET(pattern, 31)) {
-            return 0;
+/* FOO, [FOO BAR] and FOO... sequences until the end of the usage form or
+ * the group. returns the last state. */
+static int
+_sequence(struct arghint_nfa *n, int cur) {
+    int start;
+    int end;
+    int depth;
+
+    while (true) {
+        while (*n->p == ' ') {
+            n->p++;
+        }
+
+        if ((*n->p == 0) || (*n->p == '\n') || (*n->p == ']')) {
+            return cur;
+        }
+
+        start = cur;
+        if (*n->p == '[') {
+            /* the groups are parsed recursively */
+            if (n->nesting == NFA_NESTING) {
+                n->overflow = true;
+                return -1;
+            }
+
+            n->p++;
+            n->nesting++;
+            if (((cur = _sequence(n, cur)) == -1) ||
+                    (*n->p != ']')) {
+                return -1;
+            }
+            n->p++;
+            n->nesting--;
+
+            /* the group may be skipped */
+            if (((end = _state(n)) == -1) || _edge(n, cur, end, false) ||
+                    _edge(n, start, end, false)) {
+                return -1;
+            }
+            cur = end;
+        }
+        else if (ISDOTS(n->p)) {
+            /* bare ..., any number of positionals */
+            n->p += 3;
+            if (_edge(n, cur, cur, true)) {
+                return -1;
+            }
+            if (!ISEND(*n->p)) {
+                return -1;
+            }
+            continue;
+        }
+        else if ((*n->p == '-') && (!ISEND(n->p[1]))) {
+            /* options, e.g. -l, --foo[=BAR] or -v..., are not counted */
+            depth = 0;
+            while (*n->p && (*n->p != '\n') &&
+                    (depth || ((*n->p != ' ') && (*n->p != ']')))) {
+                depth += (*n->p == '[') - (*n->p == ']');
+                n->p++;
+            }
+            continue;
         }
         else {
+            while ((!ISEND(*n->p)) && (*n->p != '[') && (!ISDOTS(n->p))) {
+                n->p++;
+            }
+
+            if (((cur = _state(n)) == -1) || _edge(n, start, cur, true)) {
+                return -1;
+            }
+        }
+
+        /* repeat the last word or group */
+        if (ISDOTS(n->p)) {
+            n->p += 3;
+            if (_edge(n, cur, start, false)) {
+                return -1;
+            }
+        }
+
+        if (!ISEND(*n->p) && (*n->p != '[')) {
             return -1;
         }
     }
+}
 
-    if (ISSET(argspat, count)) {
-        return 0;
-    }
 
-    if ((argspat == 0) || (count == 0)) {
-        return -1;
+static void
+_closure(const struct arghint_nfa *n, stateset s) {
+    int i;
+    bool changed = true;
+    const struct arghint_edge *e;
+
+    while (changed) {
+        changed = false;
+        for (i = 0; i < n->edges; i++) {
+            e = n->edge + i;
+            if ((!e->word) && ISSET(s, e->from) && (!ISSET(s, e->to))) {
+                SETBIT(s, e->to);
+                changed = true;
+            }
+        }
     }
+}
+
 
-    int lastbit = (MAXBITS - __builtin_clz(pattern & ARGSMASK)) - 1;
-    if ((count > lastbit) && ISSET(pattern, 31)) {
-        return 0;
+static void
+_step(const struct arghint_nfa *n, const stateset s, stateset out) {
+    int i;
+    const struct arghint_edge *e;
+
+    memset(out, 0, sizeof(stateset));
+    for (i = 0; i < n->edges; i++) {
+        e = n->edge + i;
+        if (e->word && ISSET(s, e->from)) {
+            SETBIT(out, e->to);
+        }
     }
 
-    return -1;
+    _closure(n, out);
 }
 
 
-int
-arghint_parse(const char *args) {
-    char *arghint;
-    char *dots;
-    char *strtokstate;
-    char *tok;
-    size_t toklen;
-    int counter = 0;
-    int bits = 0;
-    int opens = 0;
+static bool
+_intersects(const stateset a, const stateset b) {
     int i;
 
-    if ((args == NULL) || (strlen(args) == 0)) {
-        SETBIT(bits, counter);
-        return bits;
+    for (i = 0; i < SETWORDS; i++) {
+        if (a[i] & b[i]) {
+            return true;
+        }
     }
 
-    arghint = strdup(args);
-    if (arghint == NULL) {
-        return -1;
-    }
+    return false;
+}
 
-    tok = strtok_r(arghint, " ", &strtokstate);
-    if ((tok == NULL) || (strlen(tok) == 0)) {
-        free(arghint);
-        goto failed;
-    }
 
+/* newline separated usage forms, e.g: "FOO [BAR]...\nBAZ QUX" */
+static int
+_parse(struct arghint_nfa *n, const char *args) {
+    int start;
+    int end;
+    const char *form;
+    bool blank = true;
+
+    memset(n, 0, sizeof(struct arghint_nfa));
+    n->p = args? args: "";
     do {
-        toklen = strlen(tok);
-        if (tok[0] == '[') {
-            SETBIT(bits, counter);
-            opens++;
+        if (*n->p == '\n') {
+            n->p++;
         }
-        counter++;
-        if (counter > MAXARGS) {
-            goto failed;
+
+        form = n->p;
+        if (((start = _state(n)) == -1) ||
+                ((end = _sequence(n, start)) == -1) || (*n->p == ']')) {
+            return -1;
         }
 
-        i = toklen - 1;
-        if ((tok[i] != ']') && (i > 3) && (tok[i - 3] == ']')) {
-            i -= 3;
+        /* blank lines are not forms, unless all are */
+        while ((form < n->p) && (*form == ' ')) {
+            form++;
         }
-        while ((i > 0) && (tok[i] == ']')) {
-            opens--;
-            i--;
+
+        if (form == n->p) {
+            continue;
         }
 
-        dots = strstr(tok, "...");
-        if (dots) {
-            if ((toklen - (dots - tok)) > 3) {
-                goto failed;
-            }
+        SETBIT(n->starts, start);
+        SETBIT(n->finals, end);
+        blank = false;
+    } while (*n->p);
 
-            if (tok == dots) {
-                SETBIT(bits, counter - 1);
-            }
-            else {
-                SETBIT(bits, counter);
+    if (blank) {
+        SETBIT(n->starts, 0);
+        SETBIT(n->finals, 0);
+    }
+
+    return 0;
+}
+
+
+static void
+_start(const struct arghint_nfa *n, stateset s) {
+    memcpy(s, n->starts, sizeof(stateset));
+    _closure(n, s);
+}
+
+
+static void
+_advance(const struct arghint_nfa *n, stateset s) {
+    stateset next;
+
+    _step(n, s, next);
+    memcpy(s, next, sizeof(stateset));
+}
+
+
+#define SETEQ(a, b) (memcmp(a, b, sizeof(stateset)) == 0)
+
+
+/* the automaton is deterministic over a single symbol, so the subset
+ * construction is a walk which ends in a cycle. the cycle is found by
+ * brent's algorithm, so the sets are not remembered. */
+static enum arghint_status
+_compile(struct arghint *h, const char *args, struct arghint_nfa *n) {
+    int i;
+    int power = 1;
+    int length = 1;
+    int loop = 0;
+    stateset tortoise;
+    stateset hare;
+
+    memset(h, 0, sizeof(struct arghint));
+    if (_parse(n, args)) {
+        return n->overflow? ARGHINT_TOOCOMPLEX: ARGHINT_MALFORMED;
+    }
+
+    /* the length of the cycle */
+    _start(n, tortoise);
+    memcpy(hare, tortoise, sizeof(stateset));
+    _advance(n, hare);
+    while (!SETEQ(tortoise, hare)) {
+        if (power == length) {
+            if (power > ARGHINT_STATES) {
+                return ARGHINT_TOOCOMPLEX;
             }
 
-            SETBIT(bits, 31);
-            // bits |= 1 << 31;
-            goto terminate;
+            memcpy(tortoise, hare, sizeof(stateset));
+            power *= 2;
+            length = 0;
+        }
+
+        _advance(n, hare);
+        length++;
+    }
+
+    /* where it starts */
+    _start(n, tortoise);
+    memcpy(hare, tortoise, sizeof(stateset));
+    for (i = 0; i < length; i++) {
+        _advance(n, hare);
+    }
+
+    while (!SETEQ(tortoise, hare)) {
+        _advance(n, tortoise);
+        _advance(n, hare);
+        loop++;
+    }
+
+    if ((loop + length) > ARGHINT_STATES) {
+        return ARGHINT_TOOCOMPLEX;
+    }
+
+    h->count = loop + length;
+    h->loop = loop;
+    _start(n, tortoise);
+    for (i = 0; i < h->count; i++) {
+        if (_intersects(tortoise, n->finals)) {
+            SETBIT(h->accept, i);
+        }
+
+        _advance(n, tortoise);
+    }
+
+    return ARGHINT_OK;
+}
+
+
+enum arghint_status
+arghint_compile(struct arghint *h, const char *args) {
+    struct arghint_nfa n;
+
+    return _compile(h, args, &n);
+}
+
+
+#define LOAD(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+
+
+/* a seqlock, the seq is odd while the cache is written and zero until it's
+ * written once */
+enum arghint_status
+arghint_cached(struct arghint *h, struct yacap_arghint *cache,
+        const char *args, struct arghint_nfa *nfa) {
+    int i;
+    bool hit;
+    enum arghint_status status;
+    unsigned int seq = __atomic_load_n(&cache->seq, __ATOMIC_ACQUIRE);
+
+    if (seq && !(seq & 1)) {
+        hit = LOAD(cache->args) == args;
+        status = LOAD(cache->status);
+        h->count = LOAD(cache->count);
+        h->loop = LOAD(cache->loop);
+        for (i = 0; i < SETWORDS; i++) {
+            h->accept[i] = LOAD(cache->accept[i]);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (hit && (LOAD(cache->seq) == seq)) {
+            return status;
         }
+    }
 
-        tok = strtok_r(NULL, " ", &strtokstate);
-    } while (tok && strlen(tok));
+    status = _compile(h, args, nfa);
+    if ((seq & 1) || !__atomic_compare_exchange_n(&cache->seq, &seq,
+                seq + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return status;
+    }
 
-    if (opens) {
-        goto failed;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    STORE(cache->args, args);
+    STORE(cache->status, status);
+    STORE(cache->count, h->count);
+    STORE(cache->loop, h->loop);
+    for (i = 0; i < SETWORDS; i++) {
+        STORE(cache->accept[i], h->accept[i]);
     }
+    __atomic_store_n(&cache->seq, seq + 2, __ATOMIC_RELEASE);
+    return status;
+}
 
-    SETBIT(bits, counter);
 
-terminate:
-    free(arghint);
-    return bits;
+/* O(1), the state of the count is computed directly */
+int
+arghint_validate(const struct arghint *h, size_t count) {
+    size_t state = count;
+
+    if (count >= (size_t)h->count) {
+        state = h->loop + (count - h->loop) % (h->count - h->loop);
+    }
 
-failed:
-    free(arghint);
-    return -1;
+    return ISSET(h->accept, state)? 0: -1;
 }
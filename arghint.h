@@ -20,12 +20,78 @@
 #define ARGHINT_H_
 
 
-int
-arghint_validate(size_t count, int pattern);
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "include/yacap.h"
+
+
+#define ARGHINT_STATES 128
+#define ARGHINT_EDGES 256
+
+
+/* the positionals hint compiled into an automaton over the count of the
+ * positionals. positionals are not told apart, so the automaton is a chain
+ * of states, the state n + 1 follows n and the last one is followed by the
+ * loop state. */
+struct arghint {
+    uint64_t accept[ARGHINT_STATES / 64];
+    int count;
+    int loop;
+};
+
+
+/* the hint is first turned into a nondeterministic automaton, one state per
+ * word boundary, words are edges consuming a positional. */
+struct arghint_edge {
+    unsigned char from;
+    unsigned char to;
+    bool word;
+};
+
+
+struct arghint_nfa {
+    const char *p;
+    bool overflow;
+    int nesting;
+    int states;
+    int edges;
+    struct arghint_edge edge[ARGHINT_EDGES];
+    uint64_t starts[ARGHINT_STATES / 64];
+    uint64_t finals[ARGHINT_STATES / 64];
+};
+
+
+enum arghint_status {
+    ARGHINT_OK = 0,
+
+    /* the hint is not enforced */
+    ARGHINT_MALFORMED = -1,
+
+    /* the hint needs more than ARGHINT_STATES states */
+    ARGHINT_TOOCOMPLEX = -2,
+};
+
+
+/* words starting with a dash are options and consume no positionals. the
+ * memory is bounded whatever the hint is, the validation is a constant time
+ * lookup */
+enum arghint_status
+arghint_compile(struct arghint *h, const char *args);
+
+
+/* arghint_compile() once per args of the command, the result is kept in
+ * the cache. concurrent parses of a tree don't wait for each other, they
+ * compile it on their own until one of them has stored it. the automaton is
+ * built in the caller's nfa, so it's off the stack. */
+enum arghint_status
+arghint_cached(struct arghint *h, struct yacap_arghint *cache,
+        const char *args, struct arghint_nfa *nfa);
 
 
 int
-arghint_parse(const char *args);
+arghint_validate(const struct arghint *h, size_t count);
 
 
 #endif  // ARGHINT_H_
@@ -0,0 +1,137 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include "include/yacap.h"
+#include "config.h"
+
+
+#define ENTRIES 10000
+#define ITERATIONS 1000
+
+
+static double
+_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+static char *
+_name(const char *prefix, int i) {
+    char *name = malloc(32);
+
+    snprintf(name, 32, "%s%05d", prefix, i);
+    return name;
+}
+
+
+static double
+_measure(struct yacap *cli, int iterations, int argc, const char **argv) {
+    int i;
+    double start = _now();
+
+    for (i = 0; i < iterations; i++) {
+        if (yacap_parse(cli, argc, argv, NULL) != YACAP_OK_EXIT) {
+            return -1;
+        }
+    }
+
+    return (_now() - start) / iterations;
+}
+
+
+/* usage: bench_complete [ENTRIES [ITERATIONS]]
+ * half of the entries are sub-commands of the root, the other half are the
+ * options of the first sub-command. */
+int
+main(int argc, const char **argv) {
+    int i;
+    int fd;
+    int stdoutfd;
+    int entries = argc > 1? atoi(argv[1]): ENTRIES;
+    int iterations = argc > 2? atoi(argv[2]): ITERATIONS;
+    int half = entries / 2;
+    struct yacap_command **commands;
+    struct yacap_option *options;
+    const char *subcommand[] = {"bench", "--complete", "cmd01234"};
+    const char *option[] = {"bench", "--complete", "cmd00000", "--opt0123"};
+    const char *all[] = {"bench", "--complete", "cmd00000", "--"};
+    double elapsed[3];
+
+    commands = calloc(half + 1, sizeof(struct yacap_command *));
+    options = calloc(half + 1, sizeof(struct yacap_option));
+    if ((commands == NULL) || (options == NULL)) {
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < half; i++) {
+        commands[i] = calloc(1, sizeof(struct yacap_command));
+        commands[i]->name = _name("cmd", i);
+        memcpy(&options[i], &(struct yacap_option) {
+            .name = _name("opt", i),
+            .key = 1000 + i,
+            .arg = NULL,
+            .flags = 0,
+            .help = NULL,
+        }, sizeof(struct yacap_option));
+    }
+
+    memcpy(commands[0], &(struct yacap_command) {
+        .name = commands[0]->name,
+        .options = options,
+    }, sizeof(struct yacap_command));
+
+    struct yacap cli = {
+        .commands = commands,
+        .flags = YACAP_NO_CLOG | YACAP_COMPLETE,
+    };
+
+    stdoutfd = dup(STDOUT_FILENO);
+    fd = open("/dev/null", O_WRONLY);
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+
+    elapsed[0] = _measure(&cli, iterations, 3, subcommand);
+    elapsed[1] = _measure(&cli, iterations, 4, option);
+    elapsed[2] = _measure(&cli, iterations, 4, all);
+
+    dup2(stdoutfd, STDOUT_FILENO);
+    close(stdoutfd);
+
+    printf("complete: entries=%d iterations=%d subcommand=%.1fus "
+            "option=%.1fus alloptions=%.1fus\n", half * 2, iterations,
+            elapsed[0], elapsed[1], elapsed[2]);
+
+    for (i = 0; i < half; i++) {
+        free((char *)commands[i]->name);
+        free(commands[i]);
+        free((char *)options[i].name);
+    }
+    free(commands);
+    free(options);
+    return EXIT_SUCCESS;
+}
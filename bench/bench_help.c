@@ -0,0 +1,336 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+
+#include "include/yacap.h"
+#include "config.h"
+
+
+/* renders the help and usage pages of a command of 10 to 10k options with
+ * help strings of 50 to 5k characters, into /dev/null and into a pipe. */
+
+
+#define ITERATIONS 1000
+#define BYTES_MAX (64 * 1024 * 1024)
+#define LOREM "Lorem merol ipsum dolor sit amet, consectetur adipiscing " \
+    "elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. "
+
+
+enum page {
+    HELP,
+    USAGE,
+};
+
+
+enum target {
+    DEVNULL,
+    PIPE,
+};
+
+
+static const char *_pagenames[] = {"help", "usage"};
+static const char *_targetnames[] = {"null", "pipe"};
+
+
+/* write(2) and writev(2) calls of the renders, the library's calls are
+ * bound to these ones instead of the libc's */
+static unsigned long _syscalls;
+
+
+ssize_t
+write(int fd, const void *buf, size_t count) {
+    _syscalls++;
+    return syscall(SYS_write, fd, buf, count);
+}
+
+
+ssize_t
+writev(int fd, const struct iovec *iov, int iovcnt) {
+    _syscalls++;
+    return syscall(SYS_writev, fd, iov, iovcnt);
+}
+
+
+static double
+_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+static char *
+_help_new(int len) {
+    int i;
+    char *help;
+
+    help = malloc(len + 1);
+    if (help == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < len; i++) {
+        help[i] = LOREM[i % (sizeof(LOREM) - 1)];
+    }
+    help[len] = 0;
+    return help;
+}
+
+
+static struct yacap_option *
+_options_new(int count, const char *help) {
+    int i;
+    char *name;
+    struct yacap_option *options;
+
+    options = calloc(count + 1, sizeof(struct yacap_option));
+    if (options == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < count; i++) {
+        name = malloc(32);
+        snprintf(name, 32, "option%05d", i);
+        struct yacap_option o = {
+            .name = name,
+            .key = 1000 + i,
+            .arg = (i % 2)? "VALUE": NULL,
+            .flags = 0,
+            .help = help,
+        };
+        memcpy(&options[i], &o, sizeof(o));
+    }
+
+    return options;
+}
+
+
+static void
+_options_free(struct yacap_option *options) {
+    struct yacap_option *o = options;
+
+    while (o->name) {
+        free((char *)o->name);
+        o++;
+    }
+
+    free(options);
+}
+
+
+static void
+_render(const struct yacap *c, enum page page) {
+    if (page == HELP) {
+        yacap_help_print(c);
+    }
+    else {
+        yacap_usage_print(c);
+    }
+}
+
+
+/* reads and drops everything until the write end is closed */
+static pid_t
+_drain(int *writefd) {
+    pid_t pid;
+    int fds[2];
+    char buff[65536];
+
+    if (pipe(fds)) {
+        return -1;
+    }
+
+    pid = fork();
+    if (pid == -1) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        close(fds[1]);
+        while (read(fds[0], buff, sizeof(buff)) > 0) {
+        }
+        _exit(0);
+    }
+
+    close(fds[0]);
+    *writefd = fds[1];
+    return pid;
+}
+
+
+static int
+_measure(const struct yacap *c, enum page page, enum target target,
+        int options, int helplen, int iterations) {
+    int i;
+    int fd;
+    int stdoutfd;
+    off_t bytes;
+    double start;
+    double elapsed;
+    unsigned long syscalls;
+    pid_t pid = 0;
+
+    /* measure the output size once */
+    fflush(stdout);
+    stdoutfd = dup(STDOUT_FILENO);
+    fd = memfd_create("help", 0);
+    dup2(fd, STDOUT_FILENO);
+    _render(c, page);
+    bytes = lseek(fd, 0, SEEK_END);
+    close(fd);
+
+    if ((bytes * iterations) > BYTES_MAX) {
+        iterations = (BYTES_MAX / bytes) > 3? BYTES_MAX / bytes: 3;
+    }
+
+    if (target == DEVNULL) {
+        fd = open("/dev/null", O_WRONLY);
+    }
+    else {
+        pid = _drain(&fd);
+    }
+
+    if ((fd == -1) || (pid == -1)) {
+        dup2(stdoutfd, STDOUT_FILENO);
+        close(stdoutfd);
+        return -1;
+    }
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+
+    _syscalls = 0;
+    start = _now();
+    for (i = 0; i < iterations; i++) {
+        _render(c, page);
+    }
+    elapsed = _now() - start;
+    syscalls = _syscalls;
+
+    dup2(stdoutfd, STDOUT_FILENO);
+    close(stdoutfd);
+    if (pid) {
+        waitpid(pid, NULL, 0);
+    }
+
+    printf("%s: sink=%s options=%d helplen=%d iterations=%d bytes=%ld "
+            "render=%.2fus throughput=%.2fMB/s syscalls=%.2f\n",
+            _pagenames[page], _targetnames[target], options, helplen,
+            iterations, (long)bytes, elapsed / iterations,
+            (bytes * iterations) / elapsed, (double)syscalls / iterations);
+    return 0;
+}
+
+
+/* the usage does not depend on the help strings, it's rendered only once
+ * per option count */
+static int
+_case(int count, int helplen, int iterations, bool usage) {
+    int ret = -1;
+    char *help;
+    struct yacap_option *options;
+    struct yacap *cli;
+    const char *args[] = {"bench"};
+
+    help = _help_new(helplen);
+    options = help? _options_new(count, help): NULL;
+    cli = calloc(1, sizeof(struct yacap));
+    if ((options == NULL) || (cli == NULL)) {
+        goto terminate;
+    }
+
+    cli->flags = YACAP_NO_CLOG;
+    if (yacap_parse(cli, 1, args, NULL) != YACAP_OK) {
+        goto terminate;
+    }
+
+    /* the optiondb refuses more than YACAP_OPTIONS_MAX options, while the
+     * help walks the command's vector itself, so attach it after the
+     * parse */
+    memcpy((void *)&cli->options, &options, sizeof(options));
+
+    if (_measure(cli, HELP, DEVNULL, count, helplen, iterations) ||
+            _measure(cli, HELP, PIPE, count, helplen, iterations) ||
+            (usage && (
+                _measure(cli, USAGE, DEVNULL, count, helplen, iterations) ||
+                _measure(cli, USAGE, PIPE, count, helplen, iterations)))) {
+        goto terminate;
+    }
+
+    ret = 0;
+
+terminate:
+    if (cli) {
+        yacap_dispose(cli);
+        free(cli);
+    }
+    if (options) {
+        _options_free(options);
+    }
+    free(help);
+    return ret;
+}
+
+
+/* usage: bench_help [OPTIONS [ITERATIONS [HELPLEN]]], the whole matrix is
+ * measured by default */
+int
+main(int argc, const char **argv) {
+    int o;
+    int h;
+    int iterations = argc > 2? atoi(argv[2]): ITERATIONS;
+    int counts[] = {10, 100, 1000, 10000, 0};
+    int helplens[] = {50, 500, 5000, 0};
+
+    if (iterations < 1) {
+        iterations = ITERATIONS;
+    }
+
+    if (argc > 1) {
+        counts[0] = atoi(argv[1]);
+        counts[1] = 0;
+    }
+
+    if (argc > 3) {
+        helplens[0] = atoi(argv[3]);
+        helplens[1] = 0;
+    }
+
+    for (o = 0; counts[o]; o++) {
+        for (h = 0; helplens[h]; h++) {
+            if (_case(counts[o], helplens[h], iterations, h == 0)) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "include/yacap.h"
+#include "config.h"
+
+
+#define COMMANDS 250
+#define OPTIONS 20
+
+
+static double
+_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+static char *
+_text(const char *format, int i, int j) {
+    char *text = malloc(128);
+
+    snprintf(text, 128, format, i, j);
+    return text;
+}
+
+
+static ssize_t
+_writer(const char *data, size_t len, void *userptr) {
+    size_t *total = userptr;
+
+    *total += len;
+    return len;
+}
+
+
+/* usage: bench_helpsearch [COMMANDS]
+ * searching a keyword across the tree versus rendering the help pages of
+ * all the sub-commands, which is what grepping the --help outputs does. */
+int
+main(int argc, const char **argv) {
+    int i;
+    int j;
+    int hits;
+    int count = argc > 1? atoi(argv[1]): COMMANDS;
+    size_t total = 0;
+    double start;
+    double elapsed[3];
+    struct yacap_command **commands;
+    struct yacap_option *options;
+    const char *args[] = {"bench", NULL};
+    struct yacap_sink sink = {
+        .type = YACAP_SINK_CALLBACK,
+        .callback = {_writer, &total},
+    };
+
+    commands = calloc(count + 1, sizeof(struct yacap_command *));
+    if (commands == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < count; i++) {
+        options = calloc(OPTIONS + 1, sizeof(struct yacap_option));
+        commands[i] = calloc(1, sizeof(struct yacap_command));
+        memcpy(commands[i], &(struct yacap_command) {
+            .name = _text("cmd%04d", i, 0),
+            .header = _text("Manage the resource number %d of %d, create, "
+                    "update or remove it", i, count),
+            .options = options,
+        }, sizeof(struct yacap_command));
+        for (j = 0; j < OPTIONS; j++) {
+            memcpy(&options[j], &(struct yacap_option) {
+                .name = _text("opt%04d-%02d", i, j),
+                .key = 1000 + j,
+                .arg = "VALUE",
+                .flags = 0,
+                .help = _text("Set the property %d of the resource %d to "
+                        "VALUE, the previous value is overwritten", j, i),
+            }, sizeof(struct yacap_option));
+        }
+    }
+
+    struct yacap cli = {
+        .commands = commands,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    /* grep over all the help pages */
+    start = _now();
+    for (i = 0; i < count; i++) {
+        args[1] = commands[i]->name;
+        if (yacap_parse(&cli, 2, args, NULL) != YACAP_OK) {
+            return EXIT_FAILURE;
+        }
+        yacap_help_render(&cli, &sink);
+        yacap_dispose(&cli);
+    }
+    elapsed[0] = _now() - start;
+
+    /* the first search builds the index */
+    if (yacap_parse(&cli, 1, args, NULL) != YACAP_OK) {
+        return EXIT_FAILURE;
+    }
+
+    start = _now();
+    hits = yacap_helpsearch_render(&cli, "overwritten", &sink);
+    elapsed[1] = _now() - start;
+
+    start = _now();
+    yacap_helpsearch_render(&cli, "cmd0123 property", &sink);
+    elapsed[2] = _now() - start;
+    yacap_dispose(&cli);
+
+    printf("helpsearch: commands=%d options=%d hits=%d allpages=%.1fus "
+            "firstsearch=%.1fus nextsearch=%.1fus\n", count,
+            count * OPTIONS, hits, elapsed[0], elapsed[1], elapsed[2]);
+
+    for (i = 0; i < count; i++) {
+        for (j = 0; j < OPTIONS; j++) {
+            free((char *)commands[i]->options[j].name);
+            free((char *)commands[i]->options[j].help);
+        }
+        free((struct yacap_option *)commands[i]->options);
+        free((char *)commands[i]->name);
+        free((char *)commands[i]->header);
+        free(commands[i]);
+    }
+    free(commands);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,390 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <spawn.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "include/yacap.h"
+#include "startup.h"
+
+
+/* fork/execs the programs repeatedly and breaks their time to the
+ * entrypoint down using the timestamps they report through a pipe, see
+ * startup.h:
+ *
+ * loader:   exec to main(), the dynamic loader and the relocations
+ * parse:    yacap_parse(), excluding the init hooks
+ * init:     the init hooks
+ * dispatch: yacap_parse() return to the entrypoint
+ * entry:    exec to the entrypoint, all the above */
+
+
+#define ITERATIONS 200
+#define WORDS_MAX 256
+
+
+enum phase {
+    LOADER,
+    PARSE,
+    INIT,
+    DISPATCH,
+    ENTRY,
+    PHASES,
+};
+
+
+static const char *_phasenames[] = {
+    "loader", "parse", "init", "dispatch", "entry"
+};
+
+
+/* argv lines to replay, argv[0] is replaced by the program */
+struct corpus {
+    char *text;
+    char ***lines;
+    int count;
+};
+
+
+static struct settings {
+    int iterations;
+    const char *corpus;
+    const char *programs[WORDS_MAX];
+    int programscount;
+} _settings = {
+    .iterations = ITERATIONS,
+};
+
+
+extern char **environ;
+
+
+static double
+_usec(const struct timespec *ts) {
+    return ts->tv_sec * 1e6 + ts->tv_nsec / 1e3;
+}
+
+
+static int
+_cmp(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+static int
+_corpus_load(struct corpus *c, const char *filename) {
+    FILE *f;
+    long size;
+    char *line;
+    char *word;
+    char *lineptr;
+    char *wordptr;
+    int argc;
+
+    f = fopen(filename, "r");
+    if (f == NULL) {
+        perror(filename);
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    c->text = malloc(size + 1);
+    c->lines = malloc((size / 2 + 1) * sizeof(char **));
+    if ((c->text == NULL) || (c->lines == NULL)) {
+        fclose(f);
+        return -1;
+    }
+    c->text[fread(c->text, 1, size, f)] = 0;
+    fclose(f);
+
+    for (line = strtok_r(c->text, "\n", &lineptr); line;
+            line = strtok_r(NULL, "\n", &lineptr)) {
+        c->lines[c->count] = malloc((WORDS_MAX + 1) * sizeof(char *));
+        if (c->lines[c->count] == NULL) {
+            return -1;
+        }
+
+        argc = 0;
+        for (word = strtok_r(line, " ", &wordptr); word && (argc < WORDS_MAX);
+                word = strtok_r(NULL, " ", &wordptr)) {
+            c->lines[c->count][argc++] = word;
+        }
+        c->lines[c->count++][argc] = NULL;
+    }
+
+    return 0;
+}
+
+
+static void
+_corpus_free(struct corpus *c) {
+    int i;
+
+    for (i = 0; i < c->count; i++) {
+        free(c->lines[i]);
+    }
+    free(c->lines);
+    free(c->text);
+}
+
+
+/* 1 when the program rejected the command line */
+static int
+_spawn(char **argv, double *phases) {
+    pid_t pid;
+    int fds[2];
+    int status;
+    ssize_t bytes;
+    size_t len = 0;
+    struct timespec start;
+    struct startupstamps stamps;
+    posix_spawn_file_actions_t actions;
+
+    if (pipe(fds)) {
+        return -1;
+    }
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+            O_WRONLY, 0);
+
+    STARTUP_STAMP(&start);
+    status = posix_spawn(&pid, argv[0], &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (status) {
+        close(fds[0]);
+        return -1;
+    }
+
+    while ((len < sizeof(stamps)) &&
+            ((bytes = read(fds[0], (char *)&stamps + len,
+                           sizeof(stamps) - len)) > 0)) {
+        len += bytes;
+    }
+    close(fds[0]);
+    waitpid(pid, NULL, 0);
+    if (len != sizeof(stamps)) {
+        return -1;
+    }
+
+    if (stamps.entry.tv_sec == 0 && stamps.entry.tv_nsec == 0) {
+        return 1;
+    }
+
+    phases[LOADER] = _usec(&stamps.main) - _usec(&start);
+    phases[INIT] = stamps.initns / 1e3;
+    phases[PARSE] = _usec(&stamps.parsed) - _usec(&stamps.main) -
+        phases[INIT];
+    phases[DISPATCH] = _usec(&stamps.entry) - _usec(&stamps.parsed);
+    phases[ENTRY] = _usec(&stamps.entry) - _usec(&start);
+    return 0;
+}
+
+
+static int
+_measure(const char *path, struct corpus *corpus) {
+    int i;
+    int p;
+    int n = 0;
+    int status;
+    int rejected = 0;
+    int iterations = _settings.iterations;
+    double phases[PHASES];
+    double *samples[PHASES] = {NULL};
+    char *bare[] = {(char *)path, NULL};
+    char **argv;
+    int ret = -1;
+
+    for (p = 0; p < PHASES; p++) {
+        samples[p] = malloc(iterations * sizeof(double));
+        if (samples[p] == NULL) {
+            goto terminate;
+        }
+    }
+
+    for (i = 0; i < iterations; i++) {
+        argv = bare;
+        if (corpus->count) {
+            argv = corpus->lines[i % corpus->count];
+            argv[0] = (char *)path;
+        }
+
+        status = _spawn(argv, phases);
+        if (status == -1) {
+            fprintf(stderr, "cannot execute: %s\n", path);
+            goto terminate;
+        }
+
+        if (status) {
+            rejected++;
+            continue;
+        }
+
+        for (p = 0; p < PHASES; p++) {
+            samples[p][n] = phases[p];
+        }
+        n++;
+    }
+
+    printf("startup: %s iterations=%d rejected=%d\n", basename((char *)path),
+            iterations, rejected);
+    for (p = 0; n && (p < PHASES); p++) {
+        qsort(samples[p], n, sizeof(double), _cmp);
+        printf("startup: %s %-8s min=%.1fus p50=%.1fus p90=%.1fus "
+                "p99=%.1fus\n", basename((char *)path), _phasenames[p],
+                samples[p][0], samples[p][n / 2], samples[p][(n * 9) / 10],
+                samples[p][(n * 99) / 100]);
+    }
+    ret = 0;
+
+terminate:
+    for (p = 0; p < PHASES; p++) {
+        free(samples[p]);
+    }
+    return ret;
+}
+
+
+static enum yacap_eatstatus
+_settings_eat(const struct yacap_option *opt, const char *value,
+        struct settings *s) {
+    if (opt == NULL) {
+        s->programs[s->programscount++] = value;
+        return YACAP_EAT_OK;
+    }
+
+    switch (opt->key) {
+        case 'n':
+            s->iterations = atoi(value);
+            break;
+        case 'c':
+            s->corpus = value;
+            break;
+        default:
+            return YACAP_EAT_UNRECOGNIZED;
+    }
+
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap _cli = {
+    .args = "[PROGRAM]...",
+    .header = "Measure the time to the entrypoint of the programs, broken "
+        "down into the loader, the parse, the init hooks and the dispatch. "
+        "The bench_startup_* siblings which are built are measured when no "
+        "program is given.",
+    .options = (const struct yacap_option[]) {
+        {"iterations", 'n', "N", 0, "Executions of each program, "
+            "default: 200"},
+        {"corpus", 'c', "FILE", 0, "Replay the command lines of FILE, one "
+            "per execution, see yacap_gentree"},
+        {NULL}
+    },
+    .eat = (yacap_eater_t)_settings_eat,
+    .userptr = &_settings,
+    .flags = YACAP_NO_CLOG,
+};
+
+
+int
+main(int argc, const char **argv) {
+    int i;
+    int status;
+    const char *dir;
+    char self[PATH_MAX];
+    char path[PATH_MAX + 64];
+    ssize_t len;
+    struct corpus corpus = {NULL};
+    const char *siblings[] = {
+        "bench_startup_pointers",
+        "bench_startup_tables",
+        "bench_startup_gentree_pointers",
+        "bench_startup_gentree_tables",
+        "bench_startup_gentree_pointers_shared",
+        "bench_startup_gentree_tables_shared",
+        NULL
+    };
+
+    status = yacap_parse(&_cli, argc, argv, NULL);
+    yacap_dispose(&_cli);
+    if (status != YACAP_OK) {
+        return (status == YACAP_OK_EXIT)? EXIT_SUCCESS: EXIT_FAILURE;
+    }
+
+    status = EXIT_FAILURE;
+    if (_settings.iterations < 1) {
+        _settings.iterations = ITERATIONS;
+    }
+
+    if (_settings.corpus && _corpus_load(&corpus, _settings.corpus)) {
+        goto terminate;
+    }
+
+    for (i = 0; i < _settings.programscount; i++) {
+        if (_measure(_settings.programs[i], &corpus)) {
+            goto terminate;
+        }
+    }
+
+    if (_settings.programscount) {
+        status = EXIT_SUCCESS;
+        goto terminate;
+    }
+
+    len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len == -1) {
+        goto terminate;
+    }
+    self[len] = 0;
+    dir = dirname(self);
+
+    /* the variants which are not built are skipped */
+    for (i = 0; siblings[i]; i++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, siblings[i]);
+        if (access(path, X_OK)) {
+            continue;
+        }
+
+        if (_measure(path, &corpus)) {
+            goto terminate;
+        }
+    }
+
+    status = EXIT_SUCCESS;
+
+terminate:
+    _corpus_free(&corpus);
+    return status;
+}
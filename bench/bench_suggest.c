@@ -0,0 +1,137 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "include/yacap.h"
+#include "config.h"
+
+
+#define COMMANDS 10000
+#define OPTIONS 200
+#define ITERATIONS 1000
+
+
+static double
+_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+static char *
+_name(const char *prefix, int i) {
+    char *name = malloc(32);
+
+    snprintf(name, 32, "%s%05d", prefix, i);
+    return name;
+}
+
+
+static double
+_measure(struct yacap *cli, int iterations, const char *arg,
+        const char *expected) {
+    int i;
+    double start;
+    const char *argv[] = {"bench", arg};
+
+    start = _now();
+    for (i = 0; i < iterations; i++) {
+        if (yacap_parse(cli, 2, argv, NULL) >= YACAP_OK) {
+            return -1;
+        }
+        yacap_dispose(cli);
+    }
+
+    if (expected && ((cli->error->suggestion == NULL) ||
+                strcmp(expected, cli->error->suggestion))) {
+        return -1;
+    }
+
+    return (_now() - start) / iterations;
+}
+
+
+/* usage: bench_suggest [COMMANDS [ITERATIONS]]
+ * a root command with OPTIONS options and COMMANDS sub-commands, the
+ * parse of a mistyped name is measured against a name which is not near
+ * to anything. */
+int
+main(int argc, const char **argv) {
+    int i;
+    int count = argc > 1? atoi(argv[1]): COMMANDS;
+    int iterations = argc > 2? atoi(argv[2]): ITERATIONS;
+    struct yacap_command **commands;
+    struct yacap_option *options;
+    struct yacap_error e;
+    double elapsed[4];
+
+    commands = calloc(count + 1, sizeof(struct yacap_command *));
+    options = calloc(OPTIONS + 1, sizeof(struct yacap_option));
+    if ((commands == NULL) || (options == NULL)) {
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < count; i++) {
+        commands[i] = calloc(1, sizeof(struct yacap_command));
+        commands[i]->name = _name("cmd", i);
+    }
+
+    for (i = 0; i < OPTIONS; i++) {
+        memcpy(&options[i], &(struct yacap_option) {
+            .name = _name("opt", i),
+            .key = 1000 + i,
+            .arg = NULL,
+            .flags = 0,
+            .help = NULL,
+        }, sizeof(struct yacap_option));
+    }
+
+    struct yacap cli = {
+        .commands = commands,
+        .options = options,
+        .flags = YACAP_NO_CLOG,
+        .error = &e,
+    };
+
+    elapsed[0] = _measure(&cli, iterations, "cmdx01234", "cmd01234");
+    elapsed[1] = _measure(&cli, iterations, "zzzzzzzz", NULL);
+    elapsed[2] = _measure(&cli, iterations, "--optx00120", "opt00120");
+    elapsed[3] = _measure(&cli, iterations, "--zzzzzzzz", NULL);
+
+    printf("suggest: commands=%d options=%d iterations=%d "
+            "command=%.1fus nocommand=%.1fus option=%.1fus "
+            "nooption=%.1fus\n", count, OPTIONS, iterations,
+            elapsed[0], elapsed[1], elapsed[2], elapsed[3]);
+
+    for (i = 0; i < count; i++) {
+        free((char *)commands[i]->name);
+        free(commands[i]);
+    }
+    for (i = 0; i < OPTIONS; i++) {
+        free((char *)options[i].name);
+    }
+    free(commands);
+    free(options);
+    return EXIT_SUCCESS;
+}
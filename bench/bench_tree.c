@@ -0,0 +1,344 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include "include/yacap.h"
+#include "config.h"
+
+
+/* parse, help rendering and completion over a tree and an argv corpus
+ * generated by yacap_gentree, see gentree.c */
+extern struct yacap gentree;
+
+
+/* the tree is generated with --hooks, see CMakeLists.txt */
+int
+gentree_init(struct yacap_command *cmd) {
+    return 0;
+}
+
+
+int
+gentree_main(const struct yacap *c, const struct yacap_command *cmd) {
+    return 0;
+}
+
+
+#define ROUNDS 5
+#define WORDS_MAX 256
+
+
+struct corpus {
+    char *text;
+    const char ***lines;
+    int *argcs;
+    int count;
+    long words;
+};
+
+
+static double
+_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+static int
+_cmp(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+static ssize_t
+_writer(const char *data, size_t len, void *userptr) {
+    size_t *total = userptr;
+
+    *total += len;
+    return len;
+}
+
+
+static int
+_corpus_load(struct corpus *c, const char *filename) {
+    FILE *f;
+    long size;
+    char *line;
+    char *word;
+    char *saveptr;
+    char *lineptr;
+    const char *argv[WORDS_MAX];
+    int argc;
+
+    memset(c, 0, sizeof(struct corpus));
+    f = fopen(filename, "r");
+    if (f == NULL) {
+        perror(filename);
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    c->text = malloc(size + 1);
+    c->lines = malloc((size / 2 + 1) * sizeof(char **));
+    c->argcs = malloc((size / 2 + 1) * sizeof(int));
+    if ((c->text == NULL) || (c->lines == NULL) || (c->argcs == NULL)) {
+        fclose(f);
+        return -1;
+    }
+    c->text[fread(c->text, 1, size, f)] = 0;
+    fclose(f);
+
+    for (line = strtok_r(c->text, "\n", &lineptr); line;
+            line = strtok_r(NULL, "\n", &lineptr)) {
+        argc = 0;
+        for (word = strtok_r(line, " ", &saveptr); word && (argc < WORDS_MAX);
+                word = strtok_r(NULL, " ", &saveptr)) {
+            argv[argc++] = word;
+        }
+
+        c->lines[c->count] = malloc((argc + 1) * sizeof(char *));
+        if (c->lines[c->count] == NULL) {
+            return -1;
+        }
+        memcpy(c->lines[c->count], argv, argc * sizeof(char *));
+        c->lines[c->count][argc] = NULL;
+        c->argcs[c->count++] = argc;
+        c->words += argc;
+    }
+
+    return 0;
+}
+
+
+static void
+_corpus_free(struct corpus *c) {
+    int i;
+
+    for (i = 0; i < c->count; i++) {
+        free(c->lines[i]);
+    }
+    free(c->lines);
+    free(c->argcs);
+    free(c->text);
+}
+
+
+static void
+_tree_count(const struct yacap_command *cmd, int *commands, int *options) {
+    struct yacap_command * const *sub;
+    const struct yacap_option *o;
+
+    (*commands)++;
+    if (cmd->optiontable) {
+        *options += cmd->optiontable->count;
+    }
+    for (o = cmd->options; o && o->name; o++) {
+        (*options)++;
+    }
+
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        _tree_count(*sub, commands, options);
+    }
+}
+
+
+static int
+_parse(struct corpus *c, int rounds) {
+    int i;
+    int r;
+    int n = 0;
+    double start;
+    double total = 0;
+    double *samples = malloc(c->count * rounds * sizeof(double));
+
+    if (samples == NULL) {
+        return -1;
+    }
+
+    for (r = 0; r < rounds; r++) {
+        for (i = 0; i < c->count; i++) {
+            start = _now();
+            if (yacap_parse(&gentree, c->argcs[i], c->lines[i], NULL) !=
+                    YACAP_OK) {
+                fprintf(stderr, "rejected line %d\n", i + 1);
+                yacap_dispose(&gentree);
+                free(samples);
+                return -1;
+            }
+            yacap_dispose(&gentree);
+            samples[n] = _now() - start;
+            total += samples[n++];
+        }
+    }
+
+    qsort(samples, n, sizeof(double), _cmp);
+    printf("parse: lines=%d words=%ld p50=%.2fus p99=%.2fus max=%.2fus "
+            "throughput=%.0fwords/s\n", c->count, c->words, samples[n / 2],
+            samples[(n * 99) / 100], samples[n - 1],
+            c->words * rounds / (total / 1e6));
+    free(samples);
+    return 0;
+}
+
+
+/* the help page of each command, with the command path as argv */
+static int
+_help(const struct yacap_command *cmd, const char **argv, int argc,
+        double *elapsed, size_t *bytes, int *pages) {
+    double start;
+    struct yacap_command * const *sub;
+    struct yacap_sink sink = {
+        .type = YACAP_SINK_CALLBACK,
+        .callback = {_writer, bytes},
+    };
+
+    /* required positionals are missing, the chain is parsed anyway */
+    start = _now();
+    if ((yacap_parse(&gentree, argc, argv, NULL) != YACAP_OK) &&
+            (gentree.error->code != YACAP_ERR_POSITIONALCOUNT)) {
+        yacap_dispose(&gentree);
+        return -1;
+    }
+    yacap_help_render(&gentree, &sink);
+    yacap_dispose(&gentree);
+    *elapsed += _now() - start;
+    (*pages)++;
+
+    if (argc == WORDS_MAX) {
+        return 0;
+    }
+
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        argv[argc] = (*sub)->name;
+        if (_help(*sub, argv, argc + 1, elapsed, bytes, pages)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+#ifdef YACAP_USE_COMPLETION
+
+/* the candidates of the word after each line, printed to /dev/null */
+static int
+_complete(struct corpus *c) {
+    int i;
+    int fd;
+    int stdoutfd;
+    double start;
+    double elapsed;
+    const char *argv[WORDS_MAX + 3];
+
+    fflush(stdout);
+    stdoutfd = dup(STDOUT_FILENO);
+    fd = open("/dev/null", O_WRONLY);
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+
+    start = _now();
+    for (i = 0; i < c->count; i++) {
+        argv[0] = c->lines[i][0];
+        argv[1] = "--complete";
+        memcpy(argv + 2, c->lines[i] + 1, (c->argcs[i] - 1) * sizeof(char *));
+        argv[c->argcs[i] + 1] = "";
+        yacap_parse(&gentree, c->argcs[i] + 2, argv, NULL);
+        yacap_dispose(&gentree);
+    }
+    elapsed = _now() - start;
+
+    dup2(stdoutfd, STDOUT_FILENO);
+    close(stdoutfd);
+
+    printf("complete: lines=%d mean=%.2fus\n", c->count,
+            elapsed / c->count);
+    return 0;
+}
+
+#endif
+
+
+/* usage: bench_tree CORPUS [ROUNDS] */
+int
+main(int argc, const char **argv) {
+    int commands = 0;
+    int options = 0;
+    int pages = 0;
+    size_t bytes = 0;
+    double elapsed = 0;
+    int rounds = argc > 2? atoi(argv[2]): ROUNDS;
+    const char *path[WORDS_MAX] = {"gentree"};
+    struct corpus corpus;
+    struct yacap_error error;
+    int status = EXIT_FAILURE;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s CORPUS [ROUNDS]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (rounds < 1) {
+        rounds = ROUNDS;
+    }
+
+    if (_corpus_load(&corpus, argv[1])) {
+        goto terminate;
+    }
+
+    _tree_count((const struct yacap_command *)&gentree, &commands, &options);
+    printf("tree: commands=%d options=%d\n", commands, options);
+
+    if (_parse(&corpus, rounds)) {
+        goto terminate;
+    }
+
+    gentree.error = &error;
+    if (_help((const struct yacap_command *)&gentree, path, 1, &elapsed,
+                &bytes, &pages)) {
+        goto terminate;
+    }
+    gentree.error = NULL;
+    printf("help: pages=%d bytes=%zu mean=%.2fus throughput=%.2fMB/s\n",
+            pages, bytes, elapsed / pages, bytes / elapsed);
+
+#ifdef YACAP_USE_COMPLETION
+    if (_complete(&corpus)) {
+        goto terminate;
+    }
+#endif
+
+    status = EXIT_SUCCESS;
+
+terminate:
+    _corpus_free(&corpus);
+    return status;
+}
@@ -0,0 +1,126 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "counters.h"
+
+
+#define CACHEREADMISS(c) ((c) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+
+static const struct {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} _events[COUNTER_EVENTS] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"l1d_misses", PERF_TYPE_HW_CACHE, CACHEREADMISS(PERF_COUNT_HW_CACHE_L1D)},
+    {"llc_misses", PERF_TYPE_HW_CACHE, CACHEREADMISS(PERF_COUNT_HW_CACHE_LL)},
+};
+
+
+int
+counters_open(struct counters *c) {
+    int i;
+    int count = 0;
+    struct perf_event_attr attr;
+
+    for (i = 0; i < COUNTER_EVENTS; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = _events[i].type;
+        attr.config = _events[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+            PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        c->fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (c->fds[i] != -1) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+
+void
+counters_close(struct counters *c) {
+    int i;
+
+    for (i = 0; i < COUNTER_EVENTS; i++) {
+        if (c->fds[i] != -1) {
+            close(c->fds[i]);
+            c->fds[i] = -1;
+        }
+    }
+}
+
+
+void
+counters_start(struct counters *c) {
+    int i;
+
+    for (i = 0; i < COUNTER_EVENTS; i++) {
+        if (c->fds[i] != -1) {
+            ioctl(c->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(c->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+
+/* the values are scaled up when the events were multiplexed */
+void
+counters_stop(struct counters *c, uint64_t values[COUNTER_EVENTS]) {
+    int i;
+    uint64_t v[3];
+
+    for (i = 0; i < COUNTER_EVENTS; i++) {
+        if (c->fds[i] != -1) {
+            ioctl(c->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    for (i = 0; i < COUNTER_EVENTS; i++) {
+        values[i] = COUNTER_NONE;
+        if ((c->fds[i] == -1) || (read(c->fds[i], v, sizeof(v)) !=
+                    sizeof(v)) || (v[2] == 0)) {
+            continue;
+        }
+
+        values[i] = (v[2] < v[1])? (uint64_t)((double)v[0] * v[1] / v[2]):
+            v[0];
+    }
+}
+
+
+const char *
+counters_name(enum counterevent e) {
+    return _events[e].name;
+}
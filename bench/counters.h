@@ -0,0 +1,69 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef BENCH_COUNTERS_H_
+#define BENCH_COUNTERS_H_
+
+
+#include <stdint.h>
+
+
+/* hardware counters of the calling thread, user space only, see
+ * perf_event_open(2) */
+enum counterevent {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_BRANCHMISSES,
+    COUNTER_L1DMISSES,
+    COUNTER_LLCMISSES,
+    COUNTER_EVENTS,
+};
+
+
+/* the value of the events which could not be opened */
+#define COUNTER_NONE UINT64_MAX
+
+
+struct counters {
+    int fds[COUNTER_EVENTS];
+};
+
+
+/* the number of the events available, an unavailable event is skipped, the
+ * others are still counted */
+int
+counters_open(struct counters *c);
+
+
+void
+counters_close(struct counters *c);
+
+
+void
+counters_start(struct counters *c);
+
+
+void
+counters_stop(struct counters *c, uint64_t values[COUNTER_EVENTS]);
+
+
+const char *
+counters_name(enum counterevent e);
+
+
+#endif  // BENCH_COUNTERS_H_
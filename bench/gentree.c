@@ -0,0 +1,665 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "include/yacap.h"
+#include "config.h"
+
+
+/* emits a C translation unit of a synthetic command tree which defines
+ * `struct yacap gentree`, and optionally an argv corpus of the tree, one
+ * command line per line, words separated by a space. every line of the
+ * corpus is accepted by the tree. */
+
+
+#define BUILTINS 8
+#define NAMESIZE 48
+#define ROOTKEYS "abcdefgijklmnoprstuwxyz"
+#define LEVELKEYS "ABCDEFGHIJKLMNOPRSTUWXYZ"
+#define NUMERICKEY 1000
+
+
+static const char *_vocabulary[] = {
+    "address", "route", "link", "metric", "table", "device", "filter",
+    "policy", "tunnel", "neighbor", "rule", "monitor", "prefix", "gateway",
+    "scope", "protocol", "weight", "priority", "label", "source", "target",
+    "timeout", "buffer", "cache", "queue", "limit", "rate", "mode", "state",
+    "group", "member", "port", "channel", "domain", "zone", "record",
+    "entry", "index", "counter", "session", "token", "secret", "cert",
+    "user", "role", "access", "backup", "restore", "snapshot", "volume",
+    "image", "node", "cluster", "service", "config", "profile", "level",
+    "format", "output", "input", "stream", "event", "trigger", "schedule",
+};
+#define VOCABULARY (sizeof(_vocabulary) / sizeof(char *))
+
+
+/* hints and the positionals count each one accepts */
+static const struct {
+    const char *hint;
+    int min;
+    int max;
+} _hints[] = {
+    {NULL, 0, 0},
+    {"[FILE]", 0, 1},
+    {"NAME", 1, 1},
+    {"[NAME]...", 0, 3},
+    {"NAME VALUE", 2, 2},
+};
+#define HINTS (sizeof(_hints) / sizeof(_hints[0]))
+
+
+struct node {
+    char name[NAMESIZE];
+    char *header;
+    int parent;
+    int depth;
+    int firstchild;
+    int children;
+    int firstoption;
+    int options;
+    int hint;
+};
+
+
+struct genoption {
+    char name[NAMESIZE];
+    char *help;
+    int key;
+    bool value;
+    bool multiple;
+};
+
+
+struct tree {
+    struct node *nodes;
+    int count;
+    struct genoption *options;
+    int optionscount;
+};
+
+
+static struct settings {
+    int commands;
+    int depth;
+    int fanout;
+    int options;
+    int rootoptions;
+    int helpwords;
+    int lines;
+    int words;
+    unsigned int seed;
+    bool tables;
+    bool hooks;
+    const char *output;
+    const char *corpus;
+} _settings = {
+    .commands = 300,
+    .depth = 4,
+    .options = 20,
+    .rootoptions = 40,
+    .helpwords = 20,
+    .lines = 1000,
+    .words = 10,
+    .seed = 1,
+};
+
+
+static uint64_t _seed;
+
+
+static int
+_random(int n) {
+    _seed = _seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return n? (int)((_seed >> 33) % n): 0;
+}
+
+
+static const char *
+_word() {
+    return _vocabulary[_random(VOCABULARY)];
+}
+
+
+static char *
+_sentence(int words) {
+    int i;
+    char *text;
+    size_t len = 0;
+    size_t size = words * 12 + 2;
+
+    text = malloc(size);
+    if (text == NULL) {
+        return NULL;
+    }
+
+    text[0] = 0;
+    for (i = 0; i < words; i++) {
+        len += snprintf(text + len, size - len, "%s%s", i? " ": "", _word());
+    }
+    text[0] = toupper(text[0]);
+    snprintf(text + len, size - len, ".");
+    return text;
+}
+
+
+/* the smallest fanout which fits the commands within the depth */
+static int
+_fanout(int commands, int depth) {
+    int f;
+    int l;
+    long capacity;
+    long level;
+
+    for (f = 1; ; f++) {
+        capacity = 0;
+        level = 1;
+        for (l = 0; l < depth; l++) {
+            level *= f;
+            capacity += level;
+        }
+
+        if (capacity >= commands) {
+            return f;
+        }
+    }
+}
+
+
+/* keys are unique along any path, lowercase letters for the root options,
+ * uppercase ones for the first level and numbers for the rest. */
+static int
+_key(int depth, int i, int id) {
+    if ((depth == 0) && (i < (int)strlen(ROOTKEYS))) {
+        return ROOTKEYS[i];
+    }
+
+    if ((depth == 1) && (i < (int)strlen(LEVELKEYS))) {
+        return LEVELKEYS[i];
+    }
+
+    return NUMERICKEY + id;
+}
+
+
+static int
+_tree_build(struct tree *t) {
+    int i;
+    int j;
+    int p;
+    int fanout;
+    struct node *n;
+    struct genoption *o;
+    int total = _settings.rootoptions + _settings.commands * _settings.options;
+
+    t->count = _settings.commands + 1;
+    t->nodes = calloc(t->count, sizeof(struct node));
+    t->options = calloc(total, sizeof(struct genoption));
+    if ((t->nodes == NULL) || (t->options == NULL)) {
+        return -1;
+    }
+
+    /* breadth first, each one takes the fanout children in order */
+    fanout = _settings.fanout? _settings.fanout:
+        _fanout(_settings.commands, _settings.depth);
+    p = 0;
+    for (i = 1; i < t->count; i++) {
+        while ((t->nodes[p].children == fanout) ||
+                (t->nodes[p].depth == _settings.depth)) {
+            p++;
+            if (p == i) {
+                fprintf(stderr, "the depth %d with fanout %d can't hold %d "
+                        "commands\n", _settings.depth, fanout,
+                        _settings.commands);
+                return -1;
+            }
+        }
+
+        n = &t->nodes[i];
+        n->parent = p;
+        n->depth = t->nodes[p].depth + 1;
+        if (t->nodes[p].children++ == 0) {
+            t->nodes[p].firstchild = i;
+        }
+    }
+
+    t->optionscount = 0;
+    for (i = 0; i < t->count; i++) {
+        n = &t->nodes[i];
+        if (i) {
+            snprintf(n->name, sizeof(n->name), "%s%d", _word(), i);
+        }
+        n->header = _sentence(_settings.helpwords);
+        n->hint = _random(HINTS);
+        if (i == 0) {
+            /* so the bare program name is accepted too */
+            n->hint = 0;
+        }
+        n->firstoption = t->optionscount;
+        n->options = i? _settings.options: _settings.rootoptions;
+
+        for (j = 0; j < n->options; j++) {
+            o = &t->options[t->optionscount];
+            snprintf(o->name, sizeof(o->name), "%s-%s%d", _word(), _word(),
+                    t->optionscount);
+            o->key = _key(n->depth, j, t->optionscount);
+            o->value = _random(2);
+            o->multiple = _random(4) == 0;
+            o->help = _sentence(_settings.helpwords);
+            t->optionscount++;
+        }
+    }
+
+    return 0;
+}
+
+
+static void
+_tree_free(struct tree *t) {
+    int i;
+
+    for (i = 0; t->nodes && (i < t->count); i++) {
+        free(t->nodes[i].header);
+    }
+
+    for (i = 0; t->options && (i < t->optionscount); i++) {
+        free(t->options[i].help);
+    }
+
+    free(t->nodes);
+    free(t->options);
+}
+
+
+static void
+_key_write(FILE *f, int key) {
+    if (key < NUMERICKEY) {
+        fprintf(f, "'%c'", key);
+    }
+    else {
+        fprintf(f, "%d", key);
+    }
+}
+
+
+static void
+_options_write(FILE *f, struct tree *t, int id) {
+    int i;
+    struct node *n = &t->nodes[id];
+    struct genoption *o;
+
+    if (n->options == 0) {
+        return;
+    }
+
+    if (_settings.tables) {
+        fprintf(f, "#define _OPTIONS%d(O, t) \\\n", id);
+        for (i = 0; i < n->options; i++) {
+            o = &t->options[n->firstoption + i];
+            fprintf(f, "    O(t, o%d, \"%s\", ", i, o->name);
+            _key_write(f, o->key);
+            fprintf(f, ", \"%s\", %s, \"%s\")%s\n", o->value? "VALUE": "",
+                    o->multiple? "YACAP_OPTION_MULTIPLE": "0", o->help,
+                    (i < (n->options - 1))? " \\": "");
+        }
+        fprintf(f, "YACAP_OPTIONTABLE(_table%d, _OPTIONS%d);\n\n\n", id, id);
+        return;
+    }
+
+    fprintf(f, "static struct yacap_option _options%d[] = {\n", id);
+    for (i = 0; i < n->options; i++) {
+        o = &t->options[n->firstoption + i];
+        fprintf(f, "    {\"%s\", ", o->name);
+        _key_write(f, o->key);
+        fprintf(f, ", %s, %s, \"%s\"},\n", o->value? "\"VALUE\"": "NULL",
+                o->multiple? "YACAP_OPTION_MULTIPLE": "0", o->help);
+    }
+    fprintf(f, "    {NULL}\n};\n\n\n");
+}
+
+
+static void
+_command_write(FILE *f, struct tree *t, int id) {
+    int i;
+    struct node *n = &t->nodes[id];
+
+    if (id) {
+        fprintf(f, "static struct yacap_command _command%d = {\n", id);
+        fprintf(f, "    .name = \"%s\",\n", n->name);
+    }
+    else {
+        fprintf(f, "struct yacap gentree = {\n");
+        fprintf(f, "    .flags = YACAP_NO_CLOG | YACAP_COMPLETE,\n");
+        fprintf(f, "    .maxdepth = %d,\n", _settings.depth + 1);
+    }
+
+    if (_hints[n->hint].hint) {
+        fprintf(f, "    .args = \"%s\",\n", _hints[n->hint].hint);
+    }
+    fprintf(f, "    .header = \"%s\",\n", n->header);
+    fprintf(f, "    .eat = _eat,\n");
+    if (_settings.hooks) {
+        if (id) {
+            fprintf(f, "    .init = gentree_init,\n");
+        }
+        fprintf(f, "    .entrypoint = gentree_main,\n");
+    }
+    if (n->options && _settings.tables) {
+        fprintf(f, "    .optiontable = &_table%d,\n", id);
+    }
+    else if (n->options) {
+        fprintf(f, "    .options = _options%d,\n", id);
+    }
+
+    if (n->children) {
+        fprintf(f, "    .commands = (struct yacap_command * const[]) {\n");
+        for (i = 0; i < n->children; i++) {
+            fprintf(f, "        &_command%d,\n", n->firstchild + i);
+        }
+        fprintf(f, "        NULL\n    },\n");
+    }
+    fprintf(f, "};\n\n\n");
+}
+
+
+/* children first, they are referenced by their parents */
+static int
+_tree_write(FILE *f, struct tree *t) {
+    int i;
+
+    fprintf(f, "/* generated by yacap_gentree, do not edit\n"
+            " * commands=%d depth=%d options=%d root-options=%d seed=%u */\n"
+            "#include <stddef.h>\n\n#include <yacap.h>\n\n\n"
+            "static enum yacap_eatstatus\n"
+            "_eat(const struct yacap_option *opt, const char *value, "
+            "void *userptr) {\n"
+            "    return YACAP_EAT_OK;\n}\n\n\n", _settings.commands,
+            _settings.depth, _settings.options, _settings.rootoptions,
+            _settings.seed);
+
+    if (_settings.hooks) {
+        fprintf(f, "/* defined by the program */\n"
+                "int\ngentree_init(struct yacap_command *cmd);\n\n\n"
+                "int\ngentree_main(const struct yacap *c, "
+                "const struct yacap_command *cmd);\n\n\n");
+    }
+
+    for (i = t->count - 1; i >= 0; i--) {
+        _options_write(f, t, i);
+        _command_write(f, t, i);
+    }
+
+    return ferror(f)? -1: 0;
+}
+
+
+/* a random command, a few options of it's path and it's positionals */
+static void
+_line_write(FILE *f, struct tree *t, bool *used) {
+    int i;
+    int k;
+    int words;
+    int count;
+    int depth = 0;
+    int chain = 0;
+    int path[_settings.depth + 1];
+    int first[_settings.depth + 1];
+    int options[_settings.depth + 1];
+    bool cluster = false;
+    struct genoption *o;
+    struct node *n = &t->nodes[_random(t->count)];
+
+    for (k = n - t->nodes; ; k = t->nodes[k].parent) {
+        path[depth++] = k;
+        if (k == 0) {
+            break;
+        }
+    }
+
+    fprintf(f, "gentree");
+    for (i = depth - 1; i >= 0; i--) {
+        k = path[i];
+        if (k) {
+            fprintf(f, " %s", t->nodes[k].name);
+        }
+        first[chain] = t->nodes[k].firstoption;
+        options[chain++] = t->nodes[k].options;
+    }
+
+    memset(used, 0, t->optionscount * sizeof(bool));
+    words = _random(_settings.words * 2 + 1);
+    for (i = 0; i < words; i++) {
+        k = _random(chain);
+        if (options[k] == 0) {
+            continue;
+        }
+
+        o = &t->options[first[k] + _random(options[k])];
+        if (used[o - t->options] && !o->multiple) {
+            continue;
+        }
+        used[o - t->options] = true;
+
+        /* adjacent short flags are clustered sometimes, e.g. -abc */
+        if ((o->key < NUMERICKEY) && _random(2)) {
+            if (cluster && (!o->value) && _random(2)) {
+                fprintf(f, "%c", o->key);
+            }
+            else {
+                fprintf(f, " -%c", o->key);
+            }
+
+            cluster = !o->value;
+            if (o->value) {
+                fprintf(f, "%sv%d", _random(2)? "": " ", _random(1000));
+            }
+            continue;
+        }
+
+        fprintf(f, " --%s", o->name);
+        cluster = false;
+        if (o->value) {
+            fprintf(f, "%sv%d", _random(2)? "=": " ", _random(1000));
+        }
+    }
+
+    count = _hints[n->hint].min +
+        _random(_hints[n->hint].max - _hints[n->hint].min + 1);
+    for (i = 0; i < count; i++) {
+        fprintf(f, " file%d.txt", _random(1000));
+    }
+    fprintf(f, "\n");
+}
+
+
+static int
+_corpus_write(FILE *f, struct tree *t) {
+    int i;
+    bool *used = malloc(t->optionscount * sizeof(bool) + 1);
+
+    if (used == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < _settings.lines; i++) {
+        _line_write(f, t, used);
+    }
+
+    free(used);
+    return ferror(f)? -1: 0;
+}
+
+
+static enum yacap_eatstatus
+_settings_eat(const struct yacap_option *opt, const char *value,
+        struct settings *s) {
+    if (opt == NULL) {
+        return YACAP_EAT_UNRECOGNIZED;
+    }
+
+    switch (opt->key) {
+        case 'c':
+            s->commands = atoi(value);
+            break;
+        case 'd':
+            s->depth = atoi(value);
+            break;
+        case 'f':
+            s->fanout = atoi(value);
+            break;
+        case 'n':
+            s->options = atoi(value);
+            break;
+        case 'r':
+            s->rootoptions = atoi(value);
+            break;
+        case 'w':
+            s->helpwords = atoi(value);
+            break;
+        case 'l':
+            s->lines = atoi(value);
+            break;
+        case 'W':
+            s->words = atoi(value);
+            break;
+        case 's':
+            s->seed = strtoul(value, NULL, 10);
+            break;
+        case 't':
+            s->tables = true;
+            break;
+        case 'k':
+            s->hooks = true;
+            break;
+        case 'o':
+            s->output = value;
+            break;
+        case 'C':
+            s->corpus = value;
+            break;
+        default:
+            return YACAP_EAT_UNRECOGNIZED;
+    }
+
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap _cli = {
+    .header = "Generate a C translation unit of a synthetic command tree "
+        "which defines `struct yacap gentree`, and a matching argv corpus.",
+    .options = (const struct yacap_option[]) {
+        {"Shape:", 0, 0, 0, NULL},
+        {"commands", 'c', "N", 0, "Number of sub-commands, default: 300"},
+        {"depth", 'd', "N", 0, "Maximum depth of the sub-commands, "
+            "default: 4"},
+        {"fanout", 'f', "N", 0, "Sub-commands per command, by default the "
+            "smallest one which fits the commands within the depth"},
+        {"options", 'n', "N", 0, "Options per sub-command, default: 20"},
+        {"root-options", 'r', "N", 0, "Options of the root, default: 40"},
+        {"help-words", 'w', "N", 0, "Words of the help strings and the "
+            "headers, default: 20"},
+        {"seed", 's', "N", 0, "Random seed, default: 1"},
+        {"tables", 't', NULL, 0, "Emit relocation-free option tables "
+            "instead of option vectors"},
+        {"hooks", 'k', NULL, 0, "Set the init hook and the entrypoint of "
+            "the commands to gentree_init() and gentree_main(), which the "
+            "program defines"},
+        {"Corpus:", 0, 0, 0, NULL},
+        {"lines", 'l', "N", 0, "Command lines of the corpus, default: 1000"},
+        {"words", 'W', "N", 0, "Average options per command line, "
+            "default: 10"},
+        {"Output:", 0, 0, 0, NULL},
+        {"output", 'o', "FILE", 0, "Write the C source to FILE instead of "
+            "the standard output"},
+        {"corpus", 'C', "FILE", 0, "Write the corpus to FILE"},
+        {NULL}
+    },
+    .eat = (yacap_eater_t)_settings_eat,
+    .userptr = &_settings,
+    .flags = YACAP_NO_CLOG,
+};
+
+
+int
+main(int argc, const char **argv) {
+    FILE *f;
+    struct tree tree = {NULL};
+    int status;
+
+    status = yacap_parse(&_cli, argc, argv, NULL);
+    yacap_dispose(&_cli);
+    if (status != YACAP_OK) {
+        return (status == YACAP_OK_EXIT)? EXIT_SUCCESS: EXIT_FAILURE;
+    }
+
+    /* the options of any path must fit the optiondb */
+    if ((_settings.commands < 0) || (_settings.depth < 1) ||
+            (_settings.fanout < 0) || (_settings.options < 0) ||
+            (_settings.rootoptions < 0) || (_settings.lines < 0) ||
+            (_settings.words < 0)) {
+        fprintf(stderr, "invalid shape\n");
+        return EXIT_FAILURE;
+    }
+
+    if ((_settings.rootoptions + _settings.depth * _settings.options +
+                BUILTINS) > YACAP_OPTIONS_MAX) {
+        fprintf(stderr, "the options of a path exceed YACAP_OPTIONS_MAX "
+                "(%d)\n", YACAP_OPTIONS_MAX);
+        return EXIT_FAILURE;
+    }
+
+    status = EXIT_FAILURE;
+    _seed = _settings.seed;
+    if (_tree_build(&tree)) {
+        goto terminate;
+    }
+
+    f = _settings.output? fopen(_settings.output, "w"): stdout;
+    if (f == NULL) {
+        perror(_settings.output);
+        goto terminate;
+    }
+
+    if (_tree_write(f, &tree) || ((f != stdout) && fclose(f))) {
+        goto terminate;
+    }
+
+    if (_settings.corpus) {
+        f = fopen(_settings.corpus, "w");
+        if (f == NULL) {
+            perror(_settings.corpus);
+            goto terminate;
+        }
+
+        if (_corpus_write(f, &tree) || fclose(f)) {
+            goto terminate;
+        }
+    }
+
+    status = EXIT_SUCCESS;
+
+terminate:
+    _tree_free(&tree);
+    return status;
+}
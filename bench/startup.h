@@ -0,0 +1,48 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef BENCH_STARTUP_H_
+#define BENCH_STARTUP_H_
+
+
+#include <time.h>
+
+
+/* the measured programs write these to the stdout at once, just before
+ * exit, see bench_startup.c */
+struct startupstamps {
+    /* main() entered */
+    struct timespec main;
+
+    /* yacap_parse() returned */
+    struct timespec parsed;
+
+    /* the entrypoint called, zero when it's not */
+    struct timespec entry;
+
+    /* total time within the init hooks */
+    long long initns;
+    int inits;
+};
+
+
+#define STARTUP_STAMP(ts) clock_gettime(CLOCK_MONOTONIC, ts)
+#define STARTUP_NSEC(ts) ((ts)->tv_sec * 1000000000LL + (ts)->tv_nsec)
+
+
+#endif  // BENCH_STARTUP_H_
@@ -0,0 +1,71 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "include/yacap.h"
+#include "startup.h"
+
+
+/* see gentree.c */
+extern struct yacap gentree;
+static struct startupstamps _stamps;
+
+
+int
+gentree_init(struct yacap_command *cmd) {
+    struct timespec start;
+    struct timespec end;
+
+    STARTUP_STAMP(&start);
+    STARTUP_STAMP(&end);
+    _stamps.initns += STARTUP_NSEC(&end) - STARTUP_NSEC(&start);
+    _stamps.inits++;
+    return 0;
+}
+
+
+int
+gentree_main(const struct yacap *c, const struct yacap_command *cmd) {
+    STARTUP_STAMP(&_stamps.entry);
+    return 0;
+}
+
+
+/* reports the startup timestamps to stdout, see bench_startup.c */
+int
+main(int argc, const char **argv) {
+    int ret;
+    const struct yacap_command *cmd = NULL;
+
+    STARTUP_STAMP(&_stamps.main);
+    ret = yacap_parse(&gentree, argc, argv, &cmd);
+    STARTUP_STAMP(&_stamps.parsed);
+    if ((ret == YACAP_OK) && cmd && cmd->entrypoint) {
+        ret = cmd->entrypoint(&gentree, cmd);
+    }
+
+    if (write(STDOUT_FILENO, &_stamps, sizeof(_stamps)) !=
+            sizeof(_stamps)) {
+        ret = -1;
+    }
+
+    yacap_dispose(&gentree);
+    return ret == YACAP_OK? EXIT_SUCCESS: EXIT_FAILURE;
+}
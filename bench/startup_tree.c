@@ -0,0 +1,130 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "include/yacap.h"
+#include "startup.h"
+
+
+/* 250 commands, 20 options each */
+#define HELP "Lorem merol ipsum dolor sit amet, consectetur adipiscing elit "
+#define D10(M, p, ...) \
+    M(p ## 0, __VA_ARGS__) M(p ## 1, __VA_ARGS__) M(p ## 2, __VA_ARGS__) \
+    M(p ## 3, __VA_ARGS__) M(p ## 4, __VA_ARGS__) M(p ## 5, __VA_ARGS__) \
+    M(p ## 6, __VA_ARGS__) M(p ## 7, __VA_ARGS__) M(p ## 8, __VA_ARGS__) \
+    M(p ## 9, __VA_ARGS__)
+#define C10(M, p) \
+    M(p ## 0) M(p ## 1) M(p ## 2) M(p ## 3) M(p ## 4) \
+    M(p ## 5) M(p ## 6) M(p ## 7) M(p ## 8) M(p ## 9)
+#define OPTIONS(M, ...) D10(M, a, __VA_ARGS__) D10(M, b, __VA_ARGS__)
+#define COMMANDS(M) \
+    C10(M, c0) C10(M, c1) C10(M, c2) C10(M, c3) C10(M, c4) \
+    C10(M, c5) C10(M, c6) C10(M, c7) C10(M, c8) C10(M, c9) \
+    C10(M, c10) C10(M, c11) C10(M, c12) C10(M, c13) C10(M, c14) \
+    C10(M, c15) C10(M, c16) C10(M, c17) C10(M, c18) C10(M, c19) \
+    C10(M, c20) C10(M, c21) C10(M, c22) C10(M, c23) C10(M, c24)
+
+
+static enum yacap_eatstatus
+_eat(const struct yacap_option *opt, const char *value, void *userptr) {
+    return YACAP_EAT_OK;
+}
+
+
+#ifdef STARTUP_TABLES
+
+#define TABLEOPTION(id, O, t) \
+    O(t, id, #id, __COUNTER__ + 1000, "VALUE", 0, HELP #id)
+#define TREE_OPTIONS(O, t) OPTIONS(TABLEOPTION, O, t)
+#define COMMAND(c) \
+    YACAP_OPTIONTABLE(c ## _options, TREE_OPTIONS); \
+    static struct yacap_command c = { \
+        .name = #c, \
+        .eat = _eat, \
+        .optiontable = &c ## _options, \
+    };
+
+#else
+
+#define VECTOROPTION(id, _) \
+    {#id, __COUNTER__ + 1000, "VALUE", 0, HELP #id},
+#define COMMAND(c) \
+    static struct yacap_option c ## _options[] = { \
+        OPTIONS(VECTOROPTION, _) \
+        {NULL} \
+    }; \
+    static struct yacap_command c = { \
+        .name = #c, \
+        .eat = _eat, \
+        .options = c ## _options, \
+    };
+
+#endif
+
+
+#define COMMANDREF(c) &c,
+
+
+COMMANDS(COMMAND)
+
+
+static struct startupstamps _stamps;
+
+
+static int
+_main(const struct yacap *c, const struct yacap_command *cmd) {
+    STARTUP_STAMP(&_stamps.entry);
+    return 0;
+}
+
+
+static struct yacap cli = {
+    .eat = _eat,
+    .entrypoint = _main,
+    .flags = YACAP_NO_CLOG,
+    .commands = (struct yacap_command * const[]) {
+        COMMANDS(COMMANDREF)
+        NULL
+    },
+};
+
+
+/* reports the startup timestamps to stdout, see bench_startup.c */
+int
+main(int argc, const char **argv) {
+    int ret;
+    const struct yacap_command *cmd = NULL;
+
+    STARTUP_STAMP(&_stamps.main);
+    ret = yacap_parse(&cli, argc, argv, &cmd);
+    STARTUP_STAMP(&_stamps.parsed);
+    if ((ret == YACAP_OK) && cmd && cmd->entrypoint) {
+        ret = cmd->entrypoint(&cli, cmd);
+    }
+
+    if (write(STDOUT_FILENO, &_stamps, sizeof(_stamps)) !=
+            sizeof(_stamps)) {
+        ret = -1;
+    }
+
+    yacap_dispose(&cli);
+    return ret == YACAP_OK? EXIT_SUCCESS: EXIT_FAILURE;
+}
@@ -0,0 +1,816 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <malloc.h>
+#include <libgen.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "include/yacap.h"
+#include "arghint.h"
+#include "counters.h"
+
+
+/* searches the inputs which cost the most per byte, in instructions, heap
+ * or time, for the parser, the positionals hint and the help, and replays
+ * the recorded ones as regression benchmarks, see bench/worstcase/. with
+ * YACAP_LIBFUZZER it's a libFuzzer target instead, whose first byte
+ * chooses the entry point. */
+
+
+#define INPUT_MAX 4096
+#define POOLSIZE 8
+#define ITERATIONS 10000
+#define WORDS_MAX 1024
+#define REPEATS 5
+#define MIN(x, y) ((x) < (y)? (x): (y))
+#define MAX(x, y) ((x) > (y)? (x): (y))
+
+
+enum target {
+    TARGET_PARSE,
+    TARGET_ARGHINT,
+    TARGET_HELP,
+    TARGETS,
+};
+
+
+enum metric {
+    METRIC_INSTRUCTIONS,
+    METRIC_HEAP,
+    METRIC_TIME,
+};
+
+
+static const char *_targetnames[] = {"parse", "arghint", "help"};
+static const char *_metricnames[] = {"instructions", "heap", "ns"};
+
+
+struct input {
+    uint8_t data[INPUT_MAX];
+    size_t len;
+    double cost;
+};
+
+
+static struct settings {
+    enum target target;
+    enum metric metric;
+    int iterations;
+    int maxlen;
+    unsigned int seed;
+    const char *output;
+    const char *files[WORDS_MAX];
+    int filescount;
+} _settings = {
+    .target = TARGET_PARSE,
+    .metric = METRIC_INSTRUCTIONS,
+    .iterations = ITERATIONS,
+    .maxlen = 512,
+    .seed = 1,
+};
+
+
+/* the grammar of the parse target */
+static struct yacap_option _rootoptions[] = {
+    {"alpha", 'a', NULL, 0, "Alpha flag"},
+    {"beta", 'b', "BETA", 0, "Beta option"},
+    {"gamma", 'g', "[GAMMA]", YACAP_OPTION_MULTIPLE, "Gamma option"},
+    {"delta", 'd', NULL, YACAP_OPTION_MULTIPLE, "Delta flag"},
+    {"epsilon", 'e', "EPSILON", YACAP_OPTION_MULTIPLE, "Epsilon option"},
+    {NULL}
+};
+
+
+static struct yacap_option _oneoptions[] = {
+    {"zeta", 'z', NULL, YACAP_OPTION_MULTIPLE, "Zeta flag"},
+    {NULL}
+};
+
+
+static struct yacap_option _twooptions[] = {
+    {"eta", 'E', "ETA", 0, "Eta option"},
+    {NULL}
+};
+
+
+static enum yacap_eatstatus
+_eat(const struct yacap_option *opt, const char *value, int *eaten) {
+    (*eaten)++;
+    return YACAP_EAT_OK;
+}
+
+
+static int _eaten;
+
+
+static struct yacap_command _three = {
+    .name = "three",
+    .args = "[FILE]...",
+    .eat = (yacap_eater_t)_eat,
+    .userptr = &_eaten,
+};
+
+
+static struct yacap_command _two = {
+    .name = "two",
+    .args = "NAME [VALUE]",
+    .options = _twooptions,
+    .eat = (yacap_eater_t)_eat,
+    .userptr = &_eaten,
+    .commands = (struct yacap_command *const[]) {&_three, NULL},
+};
+
+
+static struct yacap_command _one = {
+    .name = "one",
+    .options = _oneoptions,
+    .eat = (yacap_eater_t)_eat,
+    .userptr = &_eaten,
+    .commands = (struct yacap_command *const[]) {&_two, NULL},
+};
+
+
+static struct yacap_error _error;
+static struct yacap _grammar = {
+    .args = "[FILE]",
+    .options = _rootoptions,
+    .eat = (yacap_eater_t)_eat,
+    .userptr = &_eaten,
+    .commands = (struct yacap_command *const[]) {&_one, NULL},
+    .flags = YACAP_NO_CLOG,
+    .error = &_error,
+};
+
+
+/* fragments the mutations insert */
+static const char *_dictionary[] = {
+    "-", "--", "=", " ", "a", "\n", "-abd", "-gx", "--alpha", "--beta=",
+    "--gamma", "--eps", "one", "two", "three", "-zzzz", "[A]", "...", "NAME",
+    "[", "]", "--help", "--usage", "--complete", "aaaaaaaa",
+};
+
+
+static const char *_seeds[TARGETS][4] = {
+    {"-ab x\nfile", "--alpha\n--beta=x\none\n-z\ntwo\nname", "-dddd\n--gm",
+        "--complete\n--al"},
+    {"[FOO]", "NAME [VALUE]...", "A B [C] [D]...", "..."},
+    {"header\nfoo Foo flag", "header\nfoo=VALUE Foo option\nbar",
+        "\nGroup: Options\n- \nfoo", "a a a a a a"},
+};
+
+
+/* heap bytes requested while counting, the libc allocator is interposed
+ * by this executable, libFuzzer has its own */
+#ifndef YACAP_LIBFUZZER
+
+static bool _counting;
+static size_t _heap;
+
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+
+void *
+malloc(size_t size) {
+    _heap += _counting? size: 0;
+    return __libc_malloc(size);
+}
+
+
+void *
+calloc(size_t count, size_t size) {
+    _heap += _counting? count * size: 0;
+    return __libc_calloc(count, size);
+}
+
+
+void *
+realloc(void *ptr, size_t size) {
+    size_t old = ptr? malloc_usable_size(ptr): 0;
+
+    _heap += (_counting && (size > old))? size - old: 0;
+    return __libc_realloc(ptr, size);
+}
+
+
+void
+free(void *ptr) {
+    __libc_free(ptr);
+}
+
+#endif
+
+
+static uint32_t
+_random() {
+    _settings.seed = _settings.seed * 1103515245 + 12345;
+    return _settings.seed >> 8;
+}
+
+
+static double
+_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static ssize_t
+_discard(const char *data, size_t len, void *userptr) {
+    return len;
+}
+
+
+/* a target run, prepared and cleaned up apart from the measurement */
+struct run {
+    char *text;
+    const char *argv[WORDS_MAX + 1];
+    int argc;
+    struct yacap_option *options;
+    struct yacap *cli;
+};
+
+
+/* the input as newline separated words */
+static void
+_words(struct run *r, char *text) {
+    char *next;
+
+    r->argc = 0;
+    r->argv[r->argc++] = "fuzz";
+    while (text && (r->argc < WORDS_MAX)) {
+        next = strchr(text, '\n');
+        if (next) {
+            *next++ = 0;
+        }
+        r->argv[r->argc++] = text;
+        text = next;
+    }
+    r->argv[r->argc] = NULL;
+}
+
+
+static int
+_prepare(struct run *r, enum target target, const uint8_t *data,
+        size_t len) {
+    int i;
+    char *sp;
+    char *eq;
+    struct yacap_option *o;
+    const char *argv[] = {"fuzz"};
+
+    memset(r, 0, sizeof(*r));
+    r->text = malloc(len + 1);
+    if (r->text == NULL) {
+        return -1;
+    }
+
+    /* embedded nulls terminate the words, or the hint */
+    if (len) {
+        memcpy(r->text, data, len);
+    }
+    r->text[len] = 0;
+    if (target == TARGET_PARSE) {
+        for (i = 0; i < (int)len; i++) {
+            r->text[i] = r->text[i]? r->text[i]: '\n';
+        }
+        _words(r, r->text);
+        return 0;
+    }
+
+    if (target == TARGET_ARGHINT) {
+        return 0;
+    }
+
+    /* help: the header, then a "name[=ARG] help" option per line */
+    _words(r, r->text);
+    r->options = calloc(r->argc, sizeof(struct yacap_option));
+    r->cli = calloc(1, sizeof(struct yacap));
+    if ((r->options == NULL) || (r->cli == NULL)) {
+        return -1;
+    }
+
+    for (i = 2, o = r->options; i < r->argc; i++, o++) {
+        sp = strchr(r->argv[i], ' ');
+        if (sp) {
+            *sp++ = 0;
+        }
+        eq = strchr(r->argv[i], '=');
+        if (eq) {
+            *eq++ = 0;
+        }
+        memcpy(o, &(struct yacap_option) {
+            .name = r->argv[i][0]? r->argv[i]: "-",
+            .key = (i % 3)? 1000 + i: 0,
+            .arg = eq,
+            .help = sp,
+        }, sizeof(struct yacap_option));
+    }
+
+    memcpy(r->cli, &(struct yacap) {
+        .header = (r->argc > 1)? r->argv[1]: NULL,
+        .flags = YACAP_NO_CLOG,
+        .error = &_error,
+    }, sizeof(struct yacap));
+
+    if (yacap_parse(r->cli, 1, argv, NULL) != YACAP_OK) {
+        return -1;
+    }
+
+    /* the optiondb checks are left out, only the page is rendered */
+    memcpy((void *)&r->cli->options, &r->options, sizeof(r->options));
+    return 0;
+}
+
+
+static void
+_execute(struct run *r, enum target target) {
+    int i;
+    struct arghint hint;
+    struct yacap_sink sink = {
+        .type = YACAP_SINK_CALLBACK,
+        .callback = {_discard, NULL},
+    };
+
+    switch (target) {
+        case TARGET_PARSE:
+            yacap_parse(&_grammar, r->argc, r->argv, NULL);
+            yacap_dispose(&_grammar);
+            break;
+
+        case TARGET_ARGHINT:
+            if (arghint_compile(&hint, r->text) == 0) {
+                for (i = 0; i < 64; i++) {
+                    arghint_validate(&hint, i);
+                }
+            }
+            break;
+
+        case TARGET_HELP:
+            yacap_help_render(r->cli, &sink);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+static void
+_cleanup(struct run *r) {
+    if (r->cli) {
+        yacap_dispose(r->cli);
+    }
+    free(r->cli);
+    free(r->options);
+    free(r->text);
+}
+
+
+#ifdef YACAP_LIBFUZZER
+
+
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    struct run r;
+    enum target target;
+
+    if (size == 0) {
+        return 0;
+    }
+
+    target = data[0] % TARGETS;
+    if (_prepare(&r, target, data + 1, size - 1) == 0) {
+        _execute(&r, target);
+    }
+    _cleanup(&r);
+    return 0;
+}
+
+
+#else
+
+
+static struct counters _counters;
+
+
+/* the stdout is /dev/null while measuring */
+static FILE *_report;
+
+
+/* the cost of the input by the metric, -1 when it can not be measured */
+static double
+_measure(enum target target, enum metric metric, const uint8_t *data,
+        size_t len) {
+    int i;
+    double start;
+    double cost = -1;
+    struct run r;
+    uint64_t values[COUNTER_EVENTS];
+
+    if (_prepare(&r, target, data, len)) {
+        _cleanup(&r);
+        return -1;
+    }
+
+    switch (metric) {
+        case METRIC_INSTRUCTIONS:
+            counters_start(&_counters);
+            _execute(&r, target);
+            counters_stop(&_counters, values);
+            if (values[COUNTER_INSTRUCTIONS] != COUNTER_NONE) {
+                cost = values[COUNTER_INSTRUCTIONS];
+            }
+            break;
+
+        case METRIC_HEAP:
+            _heap = 0;
+            _counting = true;
+            _execute(&r, target);
+            _counting = false;
+            cost = _heap;
+            break;
+
+        case METRIC_TIME:
+            for (i = 0; i < REPEATS; i++) {
+                start = _now();
+                _execute(&r, target);
+                start = _now() - start;
+                if ((cost < 0) || (start < cost)) {
+                    cost = start;
+                }
+            }
+            break;
+    }
+
+    _cleanup(&r);
+    return cost;
+}
+
+
+static void
+_mutate(struct input *in, const struct input *pool) {
+    size_t at;
+    size_t n;
+    size_t max = _settings.maxlen;
+    const char *word;
+    const struct input *other;
+
+    at = in->len? _random() % (in->len + 1): 0;
+    switch (_random() % 6) {
+        case 0:
+            /* insert a byte */
+            if (in->len < max) {
+                memmove(in->data + at + 1, in->data + at, in->len - at);
+                in->data[at] = _random() % 128;
+                in->len++;
+            }
+            break;
+
+        case 1:
+            /* delete a range */
+            n = (at < in->len)? 1 + _random() % (in->len - at): 0;
+            memmove(in->data + at, in->data + at + n, in->len - at - n);
+            in->len -= n;
+            break;
+
+        case 2:
+            /* repeat a range, for the pathological repetitions */
+            n = (at < in->len)? 1 + _random() % (in->len - at): 0;
+            n = (in->len + n > max)? max - in->len: n;
+            memmove(in->data + at + n, in->data + at, in->len - at);
+            in->len += n;
+            break;
+
+        case 3:
+            /* replace a byte */
+            if (at < in->len) {
+                in->data[at] = _random() % 128;
+            }
+            break;
+
+        case 4:
+            /* insert a fragment */
+            word = _dictionary[_random() % (sizeof(_dictionary) /
+                    sizeof(char *))];
+            n = strlen(word);
+            if ((in->len + n) <= max) {
+                memmove(in->data + at + n, in->data + at, in->len - at);
+                memcpy(in->data + at, word, n);
+                in->len += n;
+            }
+            break;
+
+        case 5:
+            /* splice another input */
+            other = pool + _random() % POOLSIZE;
+            n = MIN(other->len, max - at);
+            memcpy(in->data + at, other->data, n);
+            in->len = MAX(in->len, at + n);
+            break;
+    }
+}
+
+
+/* the cost per byte above the cost of an empty input, the inputs shorter
+ * than an eighth of the maximum length are scored as that long. the fixed
+ * costs, e.g. of the entry points or a --help, would favor the shortest
+ * inputs otherwise. */
+static double _base;
+#define SCORE(cost, len) (((cost) - _base) / \
+        MAX((int)(len), MAX(_settings.maxlen / 8, 1)))
+
+
+static int
+_search(struct input *pool) {
+    int i;
+    int j;
+    int worst;
+    double cost;
+    struct input candidate;
+    enum target t = _settings.target;
+
+    _base = _measure(t, _settings.metric, NULL, 0);
+    if (_base < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < POOLSIZE; i++) {
+        pool[i].len = strlen(_seeds[t][i % 4]);
+        memcpy(pool[i].data, _seeds[t][i % 4], pool[i].len);
+        cost = _measure(t, _settings.metric, pool[i].data, pool[i].len);
+        if (cost < 0) {
+            return -1;
+        }
+        pool[i].cost = SCORE(cost, pool[i].len);
+    }
+
+    for (i = 0; i < _settings.iterations; i++) {
+        candidate = pool[_random() % POOLSIZE];
+        for (j = 1 + _random() % 4; j; j--) {
+            _mutate(&candidate, pool);
+        }
+
+        cost = _measure(t, _settings.metric, candidate.data, candidate.len);
+        candidate.cost = SCORE(cost, candidate.len);
+
+        /* replace the cheapest one, unless it's already there */
+        worst = 0;
+        for (j = 0; j < POOLSIZE; j++) {
+            if ((pool[j].len == candidate.len) && (memcmp(pool[j].data,
+                            candidate.data, candidate.len) == 0)) {
+                break;
+            }
+            if (pool[j].cost < pool[worst].cost) {
+                worst = j;
+            }
+        }
+
+        if ((j == POOLSIZE) && (candidate.cost > pool[worst].cost)) {
+            pool[worst] = candidate;
+        }
+    }
+
+    return 0;
+}
+
+
+static int
+_record(const struct input *pool) {
+    int i;
+    FILE *f;
+    char path[1024];
+
+    for (i = 0; i < POOLSIZE; i++) {
+        fprintf(_report, "worstcase: %s #%d bytes=%zu %s_per_byte=%.2f\n",
+                _targetnames[_settings.target], i, pool[i].len,
+                _metricnames[_settings.metric], pool[i].cost);
+
+        if (_settings.output == NULL) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s-%d", _settings.output,
+                _targetnames[_settings.target], i);
+        f = fopen(path, "w");
+        if ((f == NULL) || (fwrite(pool[i].data, 1, pool[i].len, f) !=
+                    pool[i].len)) {
+            perror(path);
+            if (f) {
+                fclose(f);
+            }
+            return -1;
+        }
+        fclose(f);
+    }
+
+    return 0;
+}
+
+
+/* the target is the file name up to the dash, e.g. parse-3 */
+static int
+_replay(const char *filename) {
+    int m;
+    int t;
+    FILE *f;
+    size_t len;
+    double cost;
+    char path[1024];
+    const char *name;
+    uint8_t data[INPUT_MAX];
+
+    snprintf(path, sizeof(path), "%s", filename);
+    name = basename(path);
+    for (t = 0; t < TARGETS; t++) {
+        len = strlen(_targetnames[t]);
+        if ((strncmp(name, _targetnames[t], len) == 0) &&
+                (name[len] == '-')) {
+            break;
+        }
+    }
+
+    f = fopen(filename, "r");
+    if ((t == TARGETS) || (f == NULL)) {
+        fprintf(stderr, "%s: invalid input\n", filename);
+        if (f) {
+            fclose(f);
+        }
+        return -1;
+    }
+
+    len = fread(data, 1, sizeof(data), f);
+    fclose(f);
+
+    fprintf(_report, "worstcase: %s bytes=%zu", name, len);
+    for (m = 0; m <= METRIC_TIME; m++) {
+        _base = _measure(t, m, NULL, 0);
+        cost = _measure(t, m, data, len);
+        if ((cost >= 0) && (_base >= 0)) {
+            fprintf(_report, " %s=%.0f %s_per_byte=%.2f", _metricnames[m],
+                    cost, _metricnames[m], SCORE(cost, len));
+        }
+    }
+    fprintf(_report, "\n");
+    return 0;
+}
+
+
+static enum yacap_eatstatus
+_settings_eat(const struct yacap_option *opt, const char *value,
+        struct settings *s) {
+    int i;
+
+    if (opt == NULL) {
+        if (s->filescount == WORDS_MAX) {
+            return YACAP_EAT_UNRECOGNIZED;
+        }
+        s->files[s->filescount++] = value;
+        return YACAP_EAT_OK;
+    }
+
+    switch (opt->key) {
+        case 't':
+            for (i = 0; i < TARGETS; i++) {
+                if (strcmp(value, _targetnames[i]) == 0) {
+                    s->target = i;
+                    return YACAP_EAT_OK;
+                }
+            }
+            return YACAP_EAT_UNRECOGNIZED;
+        case 'm':
+            for (i = 0; i <= METRIC_TIME; i++) {
+                if (strcmp(value, _metricnames[i]) == 0) {
+                    s->metric = i;
+                    return YACAP_EAT_OK;
+                }
+            }
+            return YACAP_EAT_UNRECOGNIZED;
+        case 'n':
+            s->iterations = atoi(value);
+            break;
+        case 'l':
+            s->maxlen = MIN(MAX(atoi(value), 1), INPUT_MAX);
+            break;
+        case 's':
+            s->seed = atoi(value);
+            break;
+        case 'o':
+            s->output = value;
+            break;
+        default:
+            return YACAP_EAT_UNRECOGNIZED;
+    }
+
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap _cli = {
+    .args = "[INPUT]...",
+    .header = "Search the inputs of the parser, the positionals hint or the "
+        "help, which cost the most instructions, heap bytes or time per "
+        "byte. Given the recorded INPUTs, named TARGET-N, replay and measure "
+        "them instead.",
+    .options = (const struct yacap_option[]) {
+        {"target", 't', "TARGET", 0, "parse, arghint or help, default: "
+            "parse"},
+        {"metric", 'm', "METRIC", 0, "instructions, heap or ns, default: "
+            "instructions, which needs perf_event_open(2)"},
+        {"iterations", 'n', "N", 0, "Mutations to try, default: 10000"},
+        {"length", 'l', "BYTES", 0, "Maximum input length, default: 512"},
+        {"seed", 's', "SEED", 0, "Random seed, default: 1"},
+        {"output", 'o', "DIR", 0, "Record the worst inputs into DIR"},
+        {NULL}
+    },
+    .eat = (yacap_eater_t)_settings_eat,
+    .userptr = &_settings,
+    .flags = YACAP_NO_CLOG,
+};
+
+
+int
+main(int argc, const char **argv) {
+    int i;
+    int fd;
+    int status;
+    struct input *pool = NULL;
+
+    status = yacap_parse(&_cli, argc, argv, NULL);
+    yacap_dispose(&_cli);
+    if (status != YACAP_OK) {
+        return (status == YACAP_OK_EXIT)? EXIT_SUCCESS: EXIT_FAILURE;
+    }
+
+    status = EXIT_FAILURE;
+    if ((counters_open(&_counters) == 0) &&
+            (_settings.metric == METRIC_INSTRUCTIONS)) {
+        fprintf(stderr, "perf_event_open(2) is not permitted, using the "
+                "heap metric\n");
+        _settings.metric = METRIC_HEAP;
+    }
+
+    /* --help and --usage in the inputs print */
+    fflush(stdout);
+    fd = open("/dev/null", O_WRONLY);
+    _report = fdopen(dup(STDOUT_FILENO), "w");
+    if ((fd == -1) || (_report == NULL) || (dup2(fd, STDOUT_FILENO) == -1)) {
+        goto terminate;
+    }
+    close(fd);
+
+    if (_settings.filescount) {
+        for (i = 0; i < _settings.filescount; i++) {
+            if (_replay(_settings.files[i])) {
+                goto terminate;
+            }
+        }
+        status = EXIT_SUCCESS;
+        goto terminate;
+    }
+
+    pool = malloc(POOLSIZE * sizeof(struct input));
+    if ((pool == NULL) || _search(pool) || _record(pool)) {
+        goto terminate;
+    }
+
+    status = EXIT_SUCCESS;
+
+terminate:
+    if (_report) {
+        fclose(_report);
+    }
+    free(pool);
+    counters_close(&_counters);
+    return status;
+}
+
+
+#endif
@@ -0,0 +1,931 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include "include/yacap.h"
+#include "config.h"
+#include "optiondb.h"
+#include "tokenizer.h"
+#include "arghint.h"
+#include "counters.h"
+
+
+/* yacap_parse() throughput and latency across a matrix of command lines,
+ * see the bench target in bench/CMakeLists.txt. */
+
+
+#define DEPTH_MAX 16
+#define CLUSTERLEN 4
+#define CLUSTERS 16
+#define ITERATIONS_MIN 3
+#define ITERATIONS_MAX 100000
+#define SHORTKEYS "abcdefgijklmnoprstuwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+#define BUILTINS 8
+
+
+struct benchcase {
+    int argc;
+    int options;
+
+    /* percent of the words which are clusters of short flags, e.g. -abcd */
+    int cluster;
+
+    /* --name value instead of --name=value */
+    bool separate;
+    int depth;
+};
+
+
+struct result {
+    char name[128];
+    int iterations;
+    double min;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    double throughput;
+};
+
+
+/* a parse broken down into its phases, measured apart, except the eat
+ * which is the rest of the parse: the _eat() dispatch, the eaters, the
+ * state and the optiondb setup */
+enum phase {
+    PHASE_PARSE,
+    PHASE_TOKENIZE,
+    PHASE_LOOKUP,
+    PHASE_ARGHINT,
+    PHASE_EAT,
+    PHASES,
+};
+
+
+static const char *_phasenames[] = {
+    "parse", "tokenize", "lookup", "arghint", "eat"
+};
+
+
+/* per parse */
+struct phaseresult {
+    double ns;
+    double values[COUNTER_EVENTS];
+};
+
+
+struct phasecontext {
+    int argc;
+    const char **argv;
+    struct yacap *cli;
+    struct optiondb db;
+    struct arghint hint;
+    int positionals;
+
+    /* the lookups the tokenizer does, a word is looked up once, or per
+     * flag when it's a cluster */
+    struct lookup {
+        const char *name;
+        int len;
+        int key;
+    } *lookups;
+    int lookupscount;
+};
+
+
+typedef void (*phase_t)(struct phasecontext *p);
+
+
+static struct settings {
+    const char *matrix;
+    const char *filter;
+    const char *output;
+    const char *compare;
+    const char *counters;
+    int time;
+    int threshold;
+    bool list;
+} _settings = {
+    .matrix = "quick",
+    .time = 200,
+    .threshold = 10,
+};
+
+
+/* around this case, one parameter at a time */
+static const struct benchcase _base = {1000, 64, 25, false, 1};
+static const int _argcs[] = {10, 100, 1000, 10000, 100000, 1000000};
+static const int _optioncounts[] = {8, 32, 64, 240};
+static const int _clusters[] = {0, 25, 50, 100};
+static const int _depths[] = {1, 2, 4, 8, 16};
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+
+/* NULL unless --counters is given */
+static struct counters *_counters;
+static FILE *_countersfile;
+
+
+static double
+_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static uint64_t
+_random(uint64_t *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *state >> 33;
+}
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    int *eaten = userptr;
+
+    (*eaten)++;
+    return YACAP_EAT_OK;
+}
+
+
+static void
+_casename(char *out, size_t size, const struct benchcase *c) {
+    snprintf(out, size, "argc=%d,options=%d,cluster=%d,style=%s,depth=%d",
+            c->argc, c->options, c->cluster, c->separate? "separate": "eq",
+            c->depth);
+}
+
+
+static void
+_options_free(struct yacap_option *options) {
+    struct yacap_option *o;
+
+    for (o = options; o->name; o++) {
+        free((char *)o->name);
+    }
+    free(options);
+}
+
+
+/* the first half of the options are flags, the rest take a value */
+static struct yacap_option *
+_options_new(int count) {
+    int i;
+    char *name;
+    struct yacap_option *options;
+    int flags = count / 2;
+
+    options = calloc(count + 1, sizeof(struct yacap_option));
+    if (options == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < count; i++) {
+        name = malloc(16);
+        if (name == NULL) {
+            _options_free(options);
+            return NULL;
+        }
+
+        snprintf(name, 16, "%s%03d", i < flags? "flag": "value", i);
+        memcpy(&options[i], &(struct yacap_option) {
+            .name = name,
+            .key = (i < (int)strlen(SHORTKEYS))? SHORTKEYS[i]: 1000 + i,
+            .arg = i < flags? NULL: "VALUE",
+            .flags = YACAP_OPTION_MULTIPLE,
+            .help = NULL,
+        }, sizeof(struct yacap_option));
+    }
+
+    return options;
+}
+
+
+/* words are drawn from a few distinct strings, argv only holds pointers */
+struct words {
+    char clusters[CLUSTERS][CLUSTERLEN + 2];
+    char (*longs)[32];
+    char (*equals)[40];
+};
+
+
+static const char **
+_argv_new(const struct benchcase *c, const struct yacap_option *options,
+        struct words *w) {
+    int i;
+    int j;
+    int k;
+    int r;
+    int opt;
+    int flags = c->options / 2;
+    int keys = flags < (int)strlen(SHORTKEYS)? flags: strlen(SHORTKEYS);
+    uint64_t seed = 0xdeadbeef;
+    const char **argv;
+
+    argv = malloc((c->argc + 1) * sizeof(char *));
+    w->longs = malloc(c->options * sizeof(*w->longs));
+    w->equals = malloc(c->options * sizeof(*w->equals));
+    if ((argv == NULL) || (w->longs == NULL) || (w->equals == NULL)) {
+        free(argv);
+        free(w->longs);
+        free(w->equals);
+        return NULL;
+    }
+
+    for (i = 0; i < CLUSTERS; i++) {
+        w->clusters[i][0] = '-';
+        for (j = 0; j < CLUSTERLEN; j++) {
+            w->clusters[i][j + 1] = keys? SHORTKEYS[_random(&seed) % keys]:
+                'h';
+        }
+        w->clusters[i][CLUSTERLEN + 1] = 0;
+    }
+
+    for (i = 0; i < c->options; i++) {
+        snprintf(w->longs[i], sizeof(*w->longs), "--%s", options[i].name);
+        snprintf(w->equals[i], sizeof(*w->equals), "--%s=foo",
+                options[i].name);
+    }
+
+    k = 0;
+    argv[k++] = "bench";
+    for (i = 1; (i < c->depth) && (k < c->argc); i++) {
+        argv[k++] = "sub";
+    }
+
+    while (k < c->argc) {
+        r = _random(&seed) % 100;
+        opt = _random(&seed) % c->options;
+        if (keys && (r < c->cluster)) {
+            argv[k++] = w->clusters[_random(&seed) % CLUSTERS];
+        }
+        else if ((r % 10) == 0) {
+            argv[k++] = "positional";
+        }
+        else if (opt < flags) {
+            argv[k++] = w->longs[opt];
+        }
+        else if (!c->separate) {
+            argv[k++] = w->equals[opt];
+        }
+        else if ((k + 1) < c->argc) {
+            argv[k++] = w->longs[opt];
+            argv[k++] = "foo";
+        }
+        else {
+            argv[k++] = "positional";
+        }
+    }
+    argv[k] = NULL;
+    return argv;
+}
+
+
+static int
+_cmp(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+static double
+_percentile(const double *sorted, int count, int p) {
+    return sorted[(p * (count - 1) + 50) / 100];
+}
+
+
+static void
+_phase_parse(struct phasecontext *p) {
+    yacap_parse(p->cli, p->argc, p->argv, NULL);
+    yacap_dispose(p->cli);
+}
+
+
+static void
+_phase_tokenize(struct phasecontext *p) {
+    struct token tok;
+    struct tokenizer *t;
+    enum tokenizer_status status;
+
+    t = tokenizer_new(p->argc, p->argv, &p->db, NULL);
+    do {
+        status = tokenizer_next(t, &tok);
+    } while ((status != YACAP_TOK_END) && (status != YACAP_TOK_ERROR));
+    tokenizer_dispose(t);
+}
+
+
+static void
+_phase_lookup(struct phasecontext *p) {
+    int i;
+
+    for (i = 0; i < p->lookupscount; i++) {
+        if (p->lookups[i].name) {
+            optiondb_findbyname(&p->db, p->lookups[i].name,
+                    p->lookups[i].len);
+        }
+        else {
+            optiondb_findbykey(&p->db, p->lookups[i].key);
+        }
+    }
+}
+
+
+static void
+_phase_arghint(struct phasecontext *p) {
+    arghint_validate(&p->hint, p->positionals);
+}
+
+
+static void
+_phase_measure(struct phasecontext *p, phase_t phase, int reps,
+        struct phaseresult *r) {
+    int i;
+    double start;
+    uint64_t values[COUNTER_EVENTS];
+
+    counters_start(_counters);
+    start = _now();
+    for (i = 0; i < reps; i++) {
+        phase(p);
+    }
+    r->ns = (_now() - start) / reps;
+    counters_stop(_counters, values);
+
+    for (i = 0; i < COUNTER_EVENTS; i++) {
+        r->values[i] = (values[i] == COUNTER_NONE)? -1:
+            (double)values[i] / reps;
+    }
+}
+
+
+static double
+_remainder(double total, double a, double b) {
+    if (total < 0) {
+        return -1;
+    }
+
+    return (total > (a + b))? total - a - b: 0;
+}
+
+
+/* lookups of the long options and the short flags of the argv, the values
+ * and the positionals are not looked up */
+static int
+_lookups(struct phasecontext *p) {
+    int i;
+    const char *w;
+    const char *eq;
+
+    p->lookups = malloc(p->argc * CLUSTERLEN * sizeof(struct lookup));
+    if (p->lookups == NULL) {
+        return -1;
+    }
+
+    p->lookupscount = 0;
+    p->positionals = 0;
+    for (i = 1; i < p->argc; i++) {
+        w = p->argv[i];
+        if ((w[0] != '-') || (w[1] == 0)) {
+            p->positionals++;
+            continue;
+        }
+
+        if (w[1] == '-') {
+            eq = strchr(w + 2, '=');
+            p->lookups[p->lookupscount].name = w + 2;
+            p->lookups[p->lookupscount++].len = eq? eq - (w + 2):
+                (int)strlen(w + 2);
+            continue;
+        }
+
+        for (w++; *w; w++) {
+            p->lookups[p->lookupscount].name = NULL;
+            p->lookups[p->lookupscount++].key = *w;
+        }
+    }
+
+    return 0;
+}
+
+
+static int
+_phases(const char *name, int argc, const char **argv, struct yacap *cli,
+        const struct yacap_option *options, int reps) {
+    int i;
+    int e;
+    struct phaseresult r[PHASES];
+    struct phasecontext ctx = {
+        .argc = argc,
+        .argv = argv,
+        .cli = cli,
+    };
+    struct phasecontext *p = &ctx;
+    phase_t phases[] = {
+        _phase_parse, _phase_tokenize, _phase_lookup, _phase_arghint
+    };
+
+    if (optiondb_init(&p->db, NULL)) {
+        return -1;
+    }
+
+    if (optiondb_insertvector(&p->db, options, NULL) ||
+            arghint_compile(&p->hint, cli->args) || _lookups(p)) {
+        optiondb_dispose(&p->db);
+        return -1;
+    }
+
+    for (i = 0; i < PHASE_EAT; i++) {
+        _phase_measure(p, phases[i], reps, &r[i]);
+    }
+
+    r[PHASE_EAT].ns = _remainder(r[PHASE_PARSE].ns, r[PHASE_TOKENIZE].ns,
+            r[PHASE_ARGHINT].ns);
+    for (e = 0; e < COUNTER_EVENTS; e++) {
+        r[PHASE_EAT].values[e] = _remainder(r[PHASE_PARSE].values[e],
+                r[PHASE_TOKENIZE].values[e], r[PHASE_ARGHINT].values[e]);
+    }
+
+    for (i = 0; i < PHASES; i++) {
+        fprintf(_countersfile, "%s\t%s\t%.0f", name, _phasenames[i],
+                r[i].ns);
+        for (e = 0; e < COUNTER_EVENTS; e++) {
+            if (r[i].values[e] < 0) {
+                fprintf(_countersfile, "\t-");
+            }
+            else {
+                fprintf(_countersfile, "\t%.0f", r[i].values[e]);
+            }
+        }
+        fprintf(_countersfile, "\n");
+    }
+
+    optiondb_dispose(&p->db);
+    free(p->lookups);
+    return 0;
+}
+
+
+static int
+_run(const struct benchcase *c, struct result *r) {
+    int i;
+    int n;
+    int eaten = 0;
+    int status = -1;
+    double start;
+    double budget;
+    double *samples;
+    const char **argv;
+    struct words words;
+    struct yacap_option *options;
+    struct yacap_command chain[DEPTH_MAX];
+    struct yacap_command *subcommands[DEPTH_MAX][2];
+
+    options = _options_new(c->options);
+    samples = malloc(ITERATIONS_MAX * sizeof(double));
+    if ((options == NULL) || (samples == NULL)) {
+        goto failed;
+    }
+
+    argv = _argv_new(c, options, &words);
+    if (argv == NULL) {
+        goto failed;
+    }
+
+    /* bench sub sub ..., the options belong to the last command */
+    for (i = 0; i < (c->depth - 1); i++) {
+        memcpy(&chain[i], &(struct yacap_command) {
+            .name = "sub",
+            .args = "...",
+            .options = (i == (c->depth - 2))? options: NULL,
+            .eat = _eater,
+            .userptr = &eaten,
+            .commands = (i < (c->depth - 2))? subcommands[i + 1]: NULL,
+        }, sizeof(struct yacap_command));
+        subcommands[i][0] = &chain[i];
+        subcommands[i][1] = NULL;
+    }
+
+    struct yacap cli = {
+        .options = (c->depth == 1)? options: NULL,
+        .args = "...",
+        .eat = _eater,
+        .userptr = &eaten,
+        .commands = (c->depth > 1)? subcommands[0]: NULL,
+        .flags = YACAP_NO_CLOG,
+        .maxdepth = c->depth,
+    };
+
+    /* warm up, and check the line is accepted at all */
+    if (yacap_parse(&cli, c->argc, argv, NULL) != YACAP_OK) {
+        yacap_dispose(&cli);
+        fprintf(stderr, "%s: rejected\n", r->name);
+        goto done;
+    }
+    yacap_dispose(&cli);
+
+    budget = _now() + _settings.time * 1e6;
+    for (n = 0; n < ITERATIONS_MAX; n++) {
+        if ((n >= ITERATIONS_MIN) && (_now() > budget)) {
+            break;
+        }
+
+        start = _now();
+        yacap_parse(&cli, c->argc, argv, NULL);
+        yacap_dispose(&cli);
+        samples[n] = _now() - start;
+    }
+
+    qsort(samples, n, sizeof(double), _cmp);
+    r->iterations = n;
+    r->min = samples[0];
+    r->p50 = _percentile(samples, n, 50);
+    r->p90 = _percentile(samples, n, 90);
+    r->p99 = _percentile(samples, n, 99);
+    r->max = samples[n - 1];
+    start = 0;
+    for (i = 0; i < n; i++) {
+        start += samples[i];
+    }
+    r->throughput = (double)c->argc * n / (start / 1e9);
+    status = 0;
+
+    if (_countersfile && _phases(r->name, c->argc, argv, &cli, options, n)) {
+        status = -1;
+    }
+
+done:
+    free(words.longs);
+    free(words.equals);
+    free(argv);
+
+failed:
+    if (options) {
+        _options_free(options);
+    }
+    free(samples);
+    return status;
+}
+
+
+static int
+_matrix(struct benchcase *cases, int size) {
+    int i;
+    int a;
+    int o;
+    int l;
+    int s;
+    int d;
+    int count = 0;
+    struct benchcase c;
+
+#define ADD(x) if (count < size) cases[count++] = (x)
+
+    if (strcmp(_settings.matrix, "full") == 0) {
+        for (a = 0; a < COUNT(_argcs); a++)
+        for (o = 0; o < COUNT(_optioncounts); o++)
+        for (l = 0; l < COUNT(_clusters); l++)
+        for (s = 0; s < 2; s++)
+        for (d = 0; d < COUNT(_depths); d++) {
+            c = (struct benchcase) {_argcs[a], _optioncounts[o],
+                _clusters[l], s, _depths[d]};
+            ADD(c);
+        }
+        return count;
+    }
+
+    if (strcmp(_settings.matrix, "quick")) {
+        return -1;
+    }
+
+    for (i = 0; i < COUNT(_argcs); i++) {
+        c = _base;
+        c.argc = _argcs[i];
+        ADD(c);
+    }
+
+    for (i = 0; i < COUNT(_optioncounts); i++) {
+        c = _base;
+        c.options = _optioncounts[i];
+        if (c.options != _base.options) {
+            ADD(c);
+        }
+    }
+
+    for (i = 0; i < COUNT(_clusters); i++) {
+        c = _base;
+        c.cluster = _clusters[i];
+        if (c.cluster != _base.cluster) {
+            ADD(c);
+        }
+    }
+
+    c = _base;
+    c.separate = true;
+    ADD(c);
+
+    for (i = 0; i < COUNT(_depths); i++) {
+        c = _base;
+        c.depth = _depths[i];
+        if (c.depth != _base.depth) {
+            ADD(c);
+        }
+    }
+
+#undef ADD
+    return count;
+}
+
+
+static void
+_header(FILE *f) {
+    fprintf(f, "case\titerations\tmin_ns\tp50_ns\tp90_ns\tp99_ns\tmax_ns\t"
+            "args_per_sec\n");
+}
+
+
+static void
+_write(FILE *f, const struct result *r) {
+    fprintf(f, "%s\t%d\t%.0f\t%.0f\t%.0f\t%.0f\t%.0f\t%.0f\n", r->name,
+            r->iterations, r->min, r->p50, r->p90, r->p99, r->max,
+            r->throughput);
+}
+
+
+/* loaded at once, it may be the output file as well */
+static char *
+_load(const char *filename) {
+    FILE *f;
+    long size;
+    char *text = NULL;
+
+    f = fopen(filename, "r");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    if ((fseek(f, 0, SEEK_END) == 0) && ((size = ftell(f)) >= 0) &&
+            (fseek(f, 0, SEEK_SET) == 0) && (text = malloc(size + 1))) {
+        text[fread(text, 1, size, f)] = 0;
+    }
+
+    fclose(f);
+    return text;
+}
+
+
+/* the median latency of the case in a previous results file, -1 when it's
+ * missing */
+static double
+_baseline(const char *text, const char *name) {
+    int i;
+    size_t len = strlen(name);
+    const char *line = text;
+
+    while (line && *line) {
+        if ((strncmp(line, name, len) == 0) && (line[len] == '\t')) {
+            /* case, iterations, min, p50 */
+            for (i = 0; (i < 3) && line; i++) {
+                line = strchr(line + 1, '\t');
+            }
+            return line? atof(line + 1): -1;
+        }
+
+        line = strchr(line, '\n');
+        if (line) {
+            line++;
+        }
+    }
+
+    return -1;
+}
+
+
+static enum yacap_eatstatus
+_settings_eat(const struct yacap_option *opt, const char *value,
+        void *userptr) {
+    struct settings *s = userptr;
+
+    if (opt == NULL) {
+        return YACAP_EAT_UNRECOGNIZED;
+    }
+
+    switch (opt->key) {
+        case 'm':
+            s->matrix = value;
+            break;
+        case 'f':
+            s->filter = value;
+            break;
+        case 'o':
+            s->output = value;
+            break;
+        case 'c':
+            s->compare = value;
+            break;
+        case 'p':
+            s->counters = value;
+            break;
+        case 't':
+            s->time = atoi(value);
+            break;
+        case 'T':
+            s->threshold = atoi(value);
+            break;
+        case 'l':
+            s->list = true;
+            break;
+        default:
+            return YACAP_EAT_UNRECOGNIZED;
+    }
+
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap _cli = {
+    .header = "Measure yacap_parse() throughput and latency percentiles. "
+        "Results are written as tab separated values, one case per line.",
+    .options = (const struct yacap_option[]) {
+        {"matrix", 'm', "MATRIX", 0, "Quick: vary each parameter around "
+            "a base case, full: all the combinations. default: quick"},
+        {"filter", 'f', "TEXT", 0, "Run the cases whose names contain "
+            "TEXT"},
+        {"time", 't', "MS", 0, "Time budget of each case, default: 200"},
+        {"output", 'o', "FILE", 0, "Write the results to FILE as well"},
+        {"compare", 'c', "BASELINE", 0, "Compare the median latencies "
+            "with a previous results file, fail on regressions"},
+        {"threshold", 'T', "PERCENT", 0, "Allowed regression of the "
+            "median latency, default: 10"},
+        {"counters", 'p', "FILE", 0, "Break the parse down into the "
+            "tokenize, lookup, arghint and eat phases and write their time "
+            "and hardware counters, per parse, to FILE. The counters are "
+            "left out where perf_event_open(2) is not permitted"},
+        {"list", 'l', NULL, 0, "List the cases and exit"},
+        {NULL}
+    },
+    .eat = _settings_eat,
+    .userptr = &_settings,
+    .flags = YACAP_NO_CLOG,
+};
+
+
+int
+main(int argc, const char **argv) {
+    int i;
+    int count;
+    int regressions = 0;
+    double base;
+    double delta;
+    struct result r;
+    struct benchcase *cases;
+    FILE *output = NULL;
+    char *baseline = NULL;
+    struct counters counters;
+    int status;
+
+    status = yacap_parse(&_cli, argc, argv, NULL);
+    if (status != YACAP_OK) {
+        yacap_dispose(&_cli);
+        return (status == YACAP_OK_EXIT)? EXIT_SUCCESS: EXIT_FAILURE;
+    }
+
+    status = EXIT_FAILURE;
+    cases = malloc(4096 * sizeof(struct benchcase));
+    count = cases? _matrix(cases, 4096): -1;
+    if (count == -1) {
+        fprintf(stderr, "invalid matrix: %s\n", _settings.matrix);
+        goto terminate;
+    }
+
+    if (_settings.compare && ((baseline = _load(_settings.compare)) ==
+                NULL)) {
+        perror(_settings.compare);
+        goto terminate;
+    }
+
+    if (_settings.output && ((output = fopen(_settings.output, "w")) ==
+                NULL)) {
+        perror(_settings.output);
+        goto terminate;
+    }
+
+    if (_settings.counters && (!_settings.list)) {
+        _countersfile = fopen(_settings.counters, "w");
+        if (_countersfile == NULL) {
+            perror(_settings.counters);
+            goto terminate;
+        }
+
+        _counters = &counters;
+        if (counters_open(_counters) == 0) {
+            fprintf(stderr, "counters: perf_event_open: %s, only the time "
+                    "is reported\n", strerror(errno));
+        }
+
+        fprintf(_countersfile, "case\tphase\tns");
+        for (i = 0; i < COUNTER_EVENTS; i++) {
+            fprintf(_countersfile, "\t%s", counters_name(i));
+        }
+        fprintf(_countersfile, "\n");
+    }
+
+    if (!_settings.list) {
+        _header(stdout);
+        if (output) {
+            _header(output);
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        memset(&r, 0, sizeof(r));
+        _casename(r.name, sizeof(r.name), &cases[i]);
+        if (_settings.filter && (strstr(r.name, _settings.filter) == NULL)) {
+            continue;
+        }
+
+        if (_settings.list) {
+            printf("%s\n", r.name);
+            continue;
+        }
+
+        if ((cases[i].options + BUILTINS) > YACAP_OPTIONS_MAX) {
+            fprintf(stderr, "%s: skipped, options are limited to %d\n",
+                    r.name, YACAP_OPTIONS_MAX - BUILTINS);
+            continue;
+        }
+
+        if (_run(&cases[i], &r)) {
+            goto terminate;
+        }
+
+        _write(stdout, &r);
+        fflush(stdout);
+        if (output) {
+            _write(output, &r);
+        }
+
+        if (baseline == NULL) {
+            continue;
+        }
+
+        base = _baseline(baseline, r.name);
+        if (base <= 0) {
+            fprintf(stderr, "%s: not in the baseline\n", r.name);
+            continue;
+        }
+
+        delta = (r.p50 - base) * 100 / base;
+        if (delta > _settings.threshold) {
+            fprintf(stderr, "%s: p50 %.0fns -> %.0fns, %+.1f%%\n", r.name,
+                    base, r.p50, delta);
+            regressions++;
+        }
+    }
+
+    if (baseline) {
+        fprintf(stderr, "%d regression(s) over %d%%\n", regressions,
+                _settings.threshold);
+    }
+
+    status = regressions? EXIT_FAILURE: EXIT_SUCCESS;
+
+terminate:
+    if (_countersfile) {
+        counters_close(_counters);
+        fclose(_countersfile);
+    }
+    if (output) {
+        fclose(output);
+    }
+    free(baseline);
+    free(cases);
+    yacap_dispose(&_cli);
+    return status;
+}
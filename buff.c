@@ -0,0 +1,205 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "helpers.h"
+#include "allocator.h"
+#include "buff.h"
+
+
+void
+buff_init(struct buff *b, char *data, size_t size) {
+    b->data = data;
+    b->size = size;
+    b->len = 0;
+    b->growable = false;
+    b->allocator = NULL;
+    b->storage = NULL;
+}
+
+
+int
+buff_alloc(struct buff *b, size_t size, const struct yacap_allocator *a) {
+    buff_init(b, allocator_alloc(a, size), size);
+    if (b->data == NULL) {
+        b->size = 0;
+        return -1;
+    }
+
+    b->growable = true;
+    b->allocator = a;
+    return 0;
+}
+
+
+void
+buff_initgrowable(struct buff *b, char *data, size_t size,
+        const struct yacap_allocator *a) {
+    buff_init(b, data, size);
+    b->growable = true;
+    b->allocator = a;
+    b->storage = data;
+}
+
+
+void
+buff_free(struct buff *b) {
+    if (b->growable && b->data && (b->data != b->storage)) {
+        allocator_free(b->allocator, b->data);
+    }
+
+    buff_init(b, NULL, 0);
+}
+
+
+/* ensure there is room for at least need more bytes, plus the null
+ * terminator vsnprintf writes. returns the available space which may be
+ * less than requested for non-growable buffers. */
+static size_t
+_reserve(struct buff *b, size_t need) {
+    char *new;
+    size_t newsize;
+
+    if ((!b->growable) || ((b->len + need) < b->size)) {
+        return b->size - b->len;
+    }
+
+    newsize = MAX(b->size * 2, b->len + need + 1);
+    if (b->data == b->storage) {
+        new = allocator_alloc(b->allocator, newsize);
+        if (new && b->len) {
+            memcpy(new, b->data, b->len);
+        }
+    }
+    else {
+        new = allocator_realloc(b->allocator, b->data, b->len, newsize);
+    }
+    if (new == NULL) {
+        return b->size - b->len;
+    }
+
+    b->data = new;
+    b->size = newsize;
+    return b->size - b->len;
+}
+
+
+/* append a formatted string to the buffer. the output is silently truncated
+ * when the buffer is full and can not grow. */
+int
+buff_printf(struct buff *b, const char *format, ...) {
+    va_list args;
+    size_t avail = b->size - b->len;
+    int status;
+
+    if ((avail == 0) && (!b->growable)) {
+        return 0;
+    }
+
+    va_start(args, format);
+    status = vsnprintf(b->data + b->len, avail, format, args);
+    va_end(args);
+
+    if (status < 0) {
+        return -1;
+    }
+
+    /* second try after growing */
+    if ((status >= avail) && b->growable) {
+        avail = _reserve(b, status);
+        va_start(args, format);
+        status = vsnprintf(b->data + b->len, avail, format, args);
+        va_end(args);
+
+        if (status < 0) {
+            return -1;
+        }
+    }
+
+    /* vsnprintf reserves the last byte for the null terminator */
+    if (status >= avail) {
+        status = avail? avail - 1: 0;
+    }
+
+    b->len += status;
+    return status;
+}
+
+
+int
+buff_write(struct buff *b, const char *data, size_t len) {
+    size_t avail = _reserve(b, len);
+
+    if (len >= avail) {
+        len = avail? avail - 1: 0;
+    }
+
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+    return len;
+}
+
+
+int
+buff_pad(struct buff *b, int count) {
+    size_t avail;
+
+    if (count <= 0) {
+        return 0;
+    }
+
+    avail = _reserve(b, count);
+    if (count >= avail) {
+        count = avail? avail - 1: 0;
+    }
+
+    memset(b->data + b->len, ' ', count);
+    b->len += count;
+    return count;
+}
+
+
+/* write the whole buffer using as few write(2) calls as possible, normally
+ * one, and empty it. */
+int
+buff_flush(struct buff *b, int fd) {
+    size_t written = 0;
+    ssize_t status;
+
+    while (written < b->len) {
+        status = write(fd, b->data + written, b->len - written);
+        if (status == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return -1;
+        }
+
+        written += status;
+    }
+
+    b->len = 0;
+    return written;
+}
@@ -0,0 +1,79 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef BUFF_H_
+#define BUFF_H_
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "include/yacap.h"
+
+
+struct buff {
+    char *data;
+    size_t size;
+    size_t len;
+
+    /* heap allocated, grows on demand */
+    bool growable;
+    const struct yacap_allocator *allocator;
+
+    /* the caller's storage of buff_initgrowable(), it's never freed */
+    char *storage;
+};
+
+
+void
+buff_init(struct buff *b, char *data, size_t size);
+
+
+int
+buff_alloc(struct buff *b, size_t size, const struct yacap_allocator *a);
+
+
+/* starts on the caller's storage and moves to the heap when it's full */
+void
+buff_initgrowable(struct buff *b, char *data, size_t size,
+        const struct yacap_allocator *a);
+
+
+void
+buff_free(struct buff *b);
+
+
+int
+buff_write(struct buff *b, const char *data, size_t len);
+
+
+int
+buff_pad(struct buff *b, int count);
+
+
+int
+buff_printf(struct buff *b, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+
+int
+buff_flush(struct buff *b, int fd);
+
+
+
+#endif  // BUFF_H_
@@ -0,0 +1,135 @@
+# yacap_prerender_help(<target> [COMPRESS] [STRIP] [SEARCH])
+#
+# Render the help pages of all <target>'s commands at build time and link
+# them into the <target> as constant strings, so --help becomes a single
+# write of a precomputed blob. A twin of the <target> is built from the same
+# sources with YACAP_PRERENDER_TWIN defined, so its yacap_parse() becomes
+# yacap_prerender_main(), and executed to generate the C source. The shipped
+# library and the <target> never look at the environment for it.
+# The pages are given to the root as `.prerender = YACAP_PRERENDERED`, each
+# one carries a fingerprint of it's command, so the commands which are not
+# found or changed since (dynamic trees, different flags) are rendered at
+# runtime as usual.
+#
+# COMPRESS stores the pages compressed, they are decoded when printed.
+# STRIP defines YACAP_STRIP_HELP for the <target>, so strings wrapped by
+# YACAP_DOC() are left out of the binary. The help of a command missing from
+# the table then says it's not available instead of rendering without them.
+# SEARCH links the sorted --help=KEYWORD index too, so searching needs no
+# index build at runtime.
+#
+# Requires yacap built with YACAP_USE_PRERENDER.
+if (NOT YACAP_INCLUDE_DIR)
+  set(YACAP_INCLUDE_DIR "${CMAKE_CURRENT_LIST_DIR}/../include")
+endif()
+
+
+function(yacap_prerender_help target)
+  cmake_parse_arguments(PRERENDER "COMPRESS;STRIP;SEARCH" "" "" ${ARGN})
+  set(twin ${target}_prerender)
+  set(output "${CMAKE_CURRENT_BINARY_DIR}/${target}_help.c")
+  string(MAKE_C_IDENTIFIER "${target}_prerender" symbol)
+  set(args ${output} ${symbol})
+  if (PRERENDER_COMPRESS)
+    list(APPEND args compress)
+  endif()
+  if (PRERENDER_SEARCH)
+    list(APPEND args search)
+  endif()
+  if (PRERENDER_STRIP)
+    if (DEFINED YACAP_USE_PRERENDER AND NOT YACAP_USE_PRERENDER)
+      message(FATAL_ERROR "yacap_prerender_help(${target} STRIP) needs yacap "
+        "built with YACAP_USE_PRERENDER, the help would be empty")
+    endif()
+    list(APPEND args strip)
+  endif()
+  get_target_property(sources ${target} SOURCES)
+  get_target_property(libraries ${target} LINK_LIBRARIES)
+  get_target_property(includes ${target} INCLUDE_DIRECTORIES)
+
+  add_executable(${twin} ${sources})
+  target_compile_definitions(${twin} PRIVATE YACAP_PRERENDER_TWIN)
+  if (libraries)
+    target_link_libraries(${twin} PRIVATE ${libraries})
+  endif()
+  if (includes)
+    target_include_directories(${twin} PRIVATE ${includes})
+  endif()
+
+  add_custom_command(
+    OUTPUT ${output}
+    COMMAND $<TARGET_FILE:${twin}> ${args}
+    DEPENDS ${twin}
+    COMMENT "Pre-rendering ${target} help pages"
+    VERBATIM
+  )
+  set_source_files_properties(${output} PROPERTIES
+    COMPILE_FLAGS "-I${YACAP_INCLUDE_DIR}"
+  )
+  target_sources(${target} PRIVATE ${output})
+  target_compile_definitions(${target} PRIVATE
+    YACAP_PRERENDER_SYMBOL=${symbol})
+  if (PRERENDER_STRIP)
+    target_compile_definitions(${target} PRIVATE YACAP_STRIP_HELP)
+  endif()
+endfunction()
+
+
+# yacap_completion(<target> [BASH] [ZSH] [FISH])
+#
+# Generate static completion scripts for the command tree of the <target>
+# whenever it's rebuilt, so completing needs no process spawn at all. A twin
+# of the <target> is built from the same sources with YACAP_COMPLETION_TWIN
+# defined, so its yacap_parse() becomes yacap_completion_main(), and
+# executed once per shell. The scripts are written to the current binary
+# directory as <target>.bash, _<target> (zsh) and <target>.fish. All shells
+# are generated when none is given.
+#
+# Requires yacap built with YACAP_USE_COMPLETION.
+function(yacap_completion target)
+  cmake_parse_arguments(COMPLETION "BASH;ZSH;FISH" "" "" ${ARGN})
+  if (NOT (COMPLETION_BASH OR COMPLETION_ZSH OR COMPLETION_FISH))
+    set(COMPLETION_BASH ON)
+    set(COMPLETION_ZSH ON)
+    set(COMPLETION_FISH ON)
+  endif()
+
+  set(twin ${target}_completion_twin)
+  get_target_property(sources ${target} SOURCES)
+  get_target_property(libraries ${target} LINK_LIBRARIES)
+  get_target_property(includes ${target} INCLUDE_DIRECTORIES)
+
+  add_executable(${twin} ${sources})
+  target_compile_definitions(${twin} PRIVATE YACAP_COMPLETION_TWIN)
+  if (libraries)
+    target_link_libraries(${twin} PRIVATE ${libraries})
+  endif()
+  if (includes)
+    target_include_directories(${twin} PRIVATE ${includes})
+  endif()
+
+  set(outputs)
+  foreach (shell IN ITEMS bash zsh fish)
+    string(TOUPPER ${shell} enabled)
+    if (NOT COMPLETION_${enabled})
+      continue()
+    endif()
+
+    if (shell STREQUAL "zsh")
+      set(output "${CMAKE_CURRENT_BINARY_DIR}/_${target}")
+    else()
+      set(output "${CMAKE_CURRENT_BINARY_DIR}/${target}.${shell}")
+    endif()
+
+    add_custom_command(
+      OUTPUT ${output}
+      COMMAND $<TARGET_FILE:${twin}> ${output} ${shell} ${target}
+      DEPENDS ${twin}
+      COMMENT "Generating ${target} ${shell} completion"
+      VERBATIM
+    )
+    list(APPEND outputs ${output})
+  endforeach()
+
+  add_custom_target(${target}_completion ALL DEPENDS ${outputs})
+endfunction()
@@ -17,14 +17,36 @@
  *  Author: Vahid Mardani <vahid.mardani@gmail.com>
  */
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "config.h"
+#include "helpers.h"
+#include "allocator.h"
+#include "buff.h"
 #include "cmdstack.h"
+#include "probes.h"
+
+
+#define CMDSTACK_CHUNK 8
+
+
+void
+cmdstack_init(struct cmdstack *s, unsigned int max,
+        const struct yacap_allocator *a) {
+    s->frames = NULL;
+    s->len = 0;
+    s->size = 0;
+    s->max = max;
+    s->allocator = a;
+}
 
 
 void
-cmdstack_init(struct cmdstack *s) {
+cmdstack_dispose(struct cmdstack *s) {
+    allocator_free(s->allocator, s->frames);
+    s->frames = NULL;
     s->len = 0;
+    s->size = 0;
 }
 
 
@@ -34,28 +56,44 @@ cmdstack_last(struct cmdstack *s) {
         return NULL;
     }
 
-    return s->commands[s->len - 1];
+    return s->frames[s->len - 1].command;
 }
 
 
 int
 cmdstack_push(struct cmdstack *s, const char *name,
         const struct yacap_command *cmd) {
-    if (s->len >= YACAP_CMDSTACK_MAX) {
+    unsigned int size;
+    struct cmdframe *new;
+
+    if (s->len >= s->max) {
         return -1;
     }
 
-    s->commands[s->len] = cmd;
-    s->names[s->len] = name;
+    if (s->len == s->size) {
+        size = MIN(s->size * 2 + CMDSTACK_CHUNK, s->max);
+        new = allocator_realloc(s->allocator, s->frames,
+                s->len * sizeof(struct cmdframe),
+                size * sizeof(struct cmdframe));
+        if (new == NULL) {
+            return -1;
+        }
+        s->frames = new;
+        s->size = size;
+    }
+
+    s->frames[s->len].command = cmd;
+    s->frames[s->len].name = name;
     s->len++;
+    PROBE_COMMAND(s->len, name);
 
     return (int)s->len;
 }
 
 
 int
-cmdstack_print(int fd, struct cmdstack *s) {
-    int i;
+cmdstack_format(struct buff *b, struct cmdstack *s) {
+    unsigned int i;
     int bytes = 0;
     int status;
 
@@ -64,7 +102,7 @@ cmdstack_print(int fd, struct cmdstack *s) {
     }
 
     for (i = 0; i < s->len; i++) {
-        status = dprintf(fd, "%s%s", i? " ": "", s->names[i]);
+        status = buff_printf(b, "%s%s", i? " ": "", s->frames[i].name);
         if (status == -1) {
             return -1;
         }
@@ -73,3 +111,4 @@ cmdstack_print(int fd, struct cmdstack *s) {
 
     return bytes;
 }
+
@@ -21,17 +21,36 @@
 
 
 #include "config.h"
+#include "buff.h"
 
 
+/* the maximum length of the command chain of a struct yacap */
+#define CMDSTACK_MAX(c) ((c)->maxdepth? (c)->maxdepth: YACAP_CMDSTACK_MAX)
+
+
+struct cmdframe {
+    const char *name;
+    const struct yacap_command *command;
+};
+
+
+/* grows on the heap, up to the max frames */
 struct cmdstack {
-    const char *names[YACAP_CMDSTACK_MAX];
-    const struct yacap_command *commands[YACAP_CMDSTACK_MAX];
-    unsigned char len;
+    struct cmdframe *frames;
+    unsigned int len;
+    unsigned int size;
+    unsigned int max;
+    const struct yacap_allocator *allocator;
 };
 
 
 void
-cmdstack_init(struct cmdstack *s);
+cmdstack_init(struct cmdstack *s, unsigned int max,
+        const struct yacap_allocator *a);
+
+
+void
+cmdstack_dispose(struct cmdstack *s);
 
 
 int
@@ -44,7 +63,7 @@ cmdstack_last(struct cmdstack *s);
 
 
 int
-cmdstack_print(int fd, struct cmdstack *s);
+cmdstack_format(struct buff *b, struct cmdstack *s);
 
 
 #endif  // CMDSTACK_H_
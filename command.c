@@ -21,14 +21,20 @@
 
 #include "command.h"
 #include "helpers.h"
+#include "option.h"
 
 
 struct yacap_command *
-command_findbyname(const struct yacap_command *cmd, const char *name) {
+command_findbyname(const struct yacap_command *cmd, const char *name,
+        struct yacap_stats *stats) {
     if (name == NULL) {
         return NULL;
     }
 
+    if (stats) {
+        stats->commandlookups++;
+    }
+
     if ((cmd == NULL) || (!cmd->commands) || (!cmd->commands[0])) {
         return NULL;
     }
@@ -37,6 +43,10 @@ command_findbyname(const struct yacap_command *cmd, const char *name) {
     struct yacap_command *s;
 
     while ((s = *c)) {
+        if (stats) {
+            stats->comparisons++;
+        }
+
         if (STREQ(name, s->name)) {
             return s;
         }
@@ -46,3 +56,64 @@ command_findbyname(const struct yacap_command *cmd, const char *name) {
 
     return NULL;
 }
+
+
+uint64_t
+command_hash(uint64_t h, const char *s) {
+    if (s == NULL) {
+        return (h ^ 0xff) * COMMAND_HASHPRIME;
+    }
+
+    do {
+        h = (h ^ (unsigned char)*s) * COMMAND_HASHPRIME;
+    } while (*s++);
+
+    return h;
+}
+
+
+static uint64_t
+_hashint(uint64_t h, uint64_t v) {
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        h = (h ^ (v & 0xff)) * COMMAND_HASHPRIME;
+        v >>= 8;
+    }
+
+    return h;
+}
+
+
+uint64_t
+command_fingerprint(const struct yacap *c, const struct yacap_command *cmd,
+        uint64_t path, bool subcommand) {
+    uint64_t h = path;
+    int count = 0;
+    struct optioniter it;
+    const struct yacap_option *opt;
+    struct yacap_command * const *sub;
+
+    h = _hashint(h, c->flags);
+    h = _hashint(h, c->version != NULL);
+    h = _hashint(h, subcommand);
+    h = command_hash(h, cmd->args);
+    h = _hashint(h, cmd->argflags);
+
+    optioniter_init(&it, cmd);
+    while ((opt = optioniter_next(&it))) {
+        h = command_hash(h, opt->name);
+        h = _hashint(h, opt->key);
+        h = command_hash(h, opt->arg);
+        h = _hashint(h, opt->flags);
+        count++;
+    }
+
+    /* so the options and the sub-commands can't shift into each other */
+    h = _hashint(h, count);
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        h = command_hash(h, (*sub)->name);
+    }
+
+    return h;
+}
@@ -24,8 +24,30 @@
 #include "config.h"
 
 
+/* the lookup is counted when stats is not NULL */
 struct yacap_command *
-command_findbyname(const struct yacap_command *cmd, const char *name);
+command_findbyname(const struct yacap_command *cmd, const char *name,
+        struct yacap_stats *stats);
+
+
+/* FNV-1a, the basis is the hash of the root path */
+#define COMMAND_HASHBASIS 0xcbf29ce484222325ULL
+#define COMMAND_HASHPRIME 0x100000001b3ULL
+
+
+/* FNV-1a of the string and it's terminator, NULL hashes apart from "" */
+uint64_t
+command_hash(uint64_t h, const char *s);
+
+
+/* of what the help of the cmd is rendered from but the doc strings, which
+ * may be stripped from the program: the path, the yacap flags, the names,
+ * keys, args and flags of the options, the args and the sub-commands. the
+ * path is the command_hash() of the names from the root's first sub-command
+ * down to the cmd. */
+uint64_t
+command_fingerprint(const struct yacap *c, const struct yacap_command *cmd,
+        uint64_t path, bool subcommand);
 
 
 #endif  // COMMAND_H_
@@ -0,0 +1,893 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "include/yacap.h"
+#include "config.h"
+#include "helpers.h"
+#include "allocator.h"
+#include "builtin.h"
+#include "buff.h"
+#include "cmdstack.h"
+#include "command.h"
+#include "option.h"
+#include "completion.h"
+
+
+#ifdef YACAP_USE_COMPLETION
+
+
+#define PATH_BUFFSIZE 1024
+#define DESC_MAX 72
+#define BUILTINS_MAX 8
+#define PATH(g) (int)(g)->path.len, (g)->path.data
+#define PATHFLAGS(f) ((f) & (YACAP_OPTION_FILE | YACAP_OPTION_DIRECTORY))
+
+
+struct generator;
+typedef void (*emitter_t) (struct generator *g,
+        const struct yacap_command *cmd);
+
+
+struct generator {
+    FILE *file;
+    const char *name;
+
+    /* space separated names from the program to the current command */
+    struct buff path;
+
+    /* options accepted by the current command, including the parents' */
+    struct yacap_option *options;
+    int count;
+    int size;
+    const struct yacap_allocator *allocator;
+};
+
+
+static int
+_push(struct generator *g, const struct yacap_option *opt) {
+    struct yacap_option *new;
+
+    if (opt->key == 0) {
+        return 0;
+    }
+
+    if (g->count == g->size) {
+        new = allocator_realloc(g->allocator, g->options,
+                g->count * sizeof(*new), (g->size + 16) * sizeof(*new));
+        if (new == NULL) {
+            return -1;
+        }
+        g->options = new;
+        g->size += 16;
+    }
+
+    memcpy(&g->options[g->count++], opt, sizeof(*opt));
+    return 0;
+}
+
+
+/* builtin options of the root, returns the count */
+static int
+_builtins(const struct yacap *c, const struct yacap_option **out) {
+    int count = 0;
+
+    if (!HASFLAG(c, YACAP_NO_HELP)) {
+        out[count++] = &opt_help;
+    }
+
+    if (!HASFLAG(c, YACAP_NO_USAGE)) {
+        out[count++] = &opt_usage;
+    }
+
+#ifdef YACAP_USE_CLOG
+    if (!HASFLAG(c, YACAP_NO_CLOG)) {
+        out[count++] = &opt_verboseflag;
+        out[count++] = &opt_quietflag;
+        out[count++] = &opt_verbosity;
+    }
+#endif
+
+    if (c->version) {
+        out[count++] = &opt_version;
+    }
+
+    return count;
+}
+
+
+/* calls the emitter for each command, depth first */
+static int
+_walk(struct generator *g, const struct yacap_command *cmd, emitter_t emit) {
+    struct optioniter it;
+    const struct yacap_option *opt;
+    struct yacap_command * const *sub;
+    size_t pathlen = g->path.len;
+    int count = g->count;
+    int status = 0;
+
+    optioniter_init(&it, cmd);
+    while ((opt = optioniter_next(&it))) {
+        if (_push(g, opt)) {
+            return -1;
+        }
+    }
+
+    emit(g, cmd);
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        buff_printf(&g->path, " %s", (*sub)->name);
+        status = _walk(g, *sub, emit);
+        g->path.len = pathlen;
+        if (status) {
+            break;
+        }
+    }
+
+    g->count = count;
+    return status;
+}
+
+
+/* the first line of a doc string, single quoted */
+static void
+_quote(FILE *f, const char *s, bool zsh) {
+    int i;
+
+    fputc('\'', f);
+    for (i = 0; s && s[i] && (s[i] != '\n') && (i < DESC_MAX); i++) {
+        if (s[i] == '\'') {
+            fputs("'\\''", f);
+        }
+        else if (zsh && (s[i] == ':')) {
+            fputs("\\:", f);
+        }
+        else {
+            fputc(s[i], f);
+        }
+    }
+
+    if (s && s[i] && (s[i] != '\n')) {
+        fputs("...", f);
+    }
+    fputc('\'', f);
+}
+
+
+/* 'path:-k'|'path:--key' case pattern of an option */
+static void
+_case(struct generator *g, const struct yacap_option *opt,
+        const char *separator) {
+    if (ISCHAR(opt->key)) {
+        fprintf(g->file, "'%.*s:-%c'%s", PATH(g), opt->key,
+                opt->name? separator: "");
+    }
+
+    if (opt->name) {
+        fprintf(g->file, "'%.*s:--%s'", PATH(g), opt->name);
+    }
+}
+
+
+/* descend into the sub-commands, shared by bash and zsh */
+static void
+_sh_descent(struct generator *g, const struct yacap_command *cmd) {
+    struct yacap_command * const *sub;
+
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        fprintf(g->file, "            '%.*s %s') cmdpath='%.*s %s';;\n",
+                PATH(g), (*sub)->name, PATH(g), (*sub)->name);
+    }
+}
+
+
+/* options which take the next word as their value */
+static void
+_sh_skip(struct generator *g, const struct yacap_command *cmd) {
+    int i;
+
+    for (i = 0; i < g->count; i++) {
+        if (YACAP_OPTION_ARGNEEDED(&g->options[i])) {
+            fprintf(g->file, "            ");
+            _case(g, &g->options[i], "|");
+            fprintf(g->file, ") skip=1; continue;;\n");
+        }
+    }
+}
+
+
+static void
+_bash_value(struct generator *g, const struct yacap_command *cmd) {
+    int i;
+    const struct yacap_option *opt;
+
+    for (i = 0; i < g->count; i++) {
+        opt = &g->options[i];
+        if ((!YACAP_OPTION_ARGNEEDED(opt)) || (!PATHFLAGS(opt->flags))) {
+            continue;
+        }
+
+        fprintf(g->file, "            ");
+        _case(g, opt, "|");
+        fprintf(g->file, ") COMPREPLY=($(compgen -%c -- \"$cur\"));;\n",
+                (opt->flags & YACAP_OPTION_FILE)? 'f': 'd');
+    }
+}
+
+
+static void
+_bash_command(struct generator *g, const struct yacap_command *cmd) {
+    int i;
+    const struct yacap_option *opt;
+    struct yacap_command * const *sub;
+
+    fprintf(g->file, "        '%.*s')\n            opts='", PATH(g));
+    for (i = 0; i < g->count; i++) {
+        opt = &g->options[i];
+        if (ISCHAR(opt->key)) {
+            fprintf(g->file, "%s-%c", i? " ": "", opt->key);
+        }
+
+        if (opt->name) {
+            fprintf(g->file, "%s--%s", (i || ISCHAR(opt->key))? " ": "",
+                    opt->name);
+        }
+    }
+
+    fprintf(g->file, "'\n            cmds='");
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        fprintf(g->file, "%s%s", (sub != cmd->commands)? " ": "",
+                (*sub)->name);
+    }
+
+    fprintf(g->file, "'\n            files='%s'\n            ;;\n",
+            (cmd->argflags & YACAP_OPTION_FILE)? "-f":
+            (cmd->argflags & YACAP_OPTION_DIRECTORY)? "-d": "");
+}
+
+
+static int
+_bash(struct generator *g, const struct yacap *c) {
+    const struct yacap_command *root = (const struct yacap_command *)c;
+    int status = 0;
+
+    fprintf(g->file,
+        "# %s completion, generated by yacap, do not edit\n"
+        "_yacap_%s() {\n"
+        "    local cur=\"${COMP_WORDS[COMP_CWORD]}\"\n"
+        "    local prev=\"${COMP_WORDS[COMP_CWORD-1]}\"\n"
+        "    local cmdpath='%s' opts='' cmds='' files='' skip=0 w i\n"
+        "\n"
+        "    for ((i = 1; i < COMP_CWORD; i++)); do\n"
+        "        w=\"${COMP_WORDS[i]}\"\n"
+        "        if ((skip)); then\n"
+        "            skip=0\n"
+        "            continue\n"
+        "        fi\n"
+        "        case \"$cmdpath:$w\" in\n", g->name, g->name, g->name);
+    status |= _walk(g, root, _sh_skip);
+    fprintf(g->file,
+        "        esac\n"
+        "        case \"$cmdpath $w\" in\n");
+    status |= _walk(g, root, _sh_descent);
+    fprintf(g->file,
+        "        esac\n"
+        "    done\n"
+        "\n"
+        "    if ((skip)); then\n"
+        "        case \"$cmdpath:$prev\" in\n");
+    status |= _walk(g, root, _bash_value);
+    fprintf(g->file,
+        "        esac\n"
+        "        return\n"
+        "    fi\n"
+        "\n"
+        "    case \"$cmdpath\" in\n");
+    status |= _walk(g, root, _bash_command);
+    fprintf(g->file,
+        "    esac\n"
+        "\n"
+        "    if [[ \"$cur\" == -* ]]; then\n"
+        "        COMPREPLY=($(compgen -W \"$opts\" -- \"$cur\"))\n"
+        "        return\n"
+        "    fi\n"
+        "\n"
+        "    COMPREPLY=($(compgen -W \"$cmds\" -- \"$cur\"))\n"
+        "    if [[ -n \"$files\" ]]; then\n"
+        "        COMPREPLY+=($(compgen $files -- \"$cur\"))\n"
+        "    fi\n"
+        "}\n"
+        "complete -F _yacap_%s %s\n", g->name, g->name);
+
+    return status;
+}
+
+
+/* zsh */
+static void
+_zsh_value(struct generator *g, const struct yacap_command *cmd) {
+    int i;
+    const struct yacap_option *opt;
+
+    for (i = 0; i < g->count; i++) {
+        opt = &g->options[i];
+        if (!YACAP_OPTION_ARGNEEDED(opt)) {
+            continue;
+        }
+
+        fprintf(g->file, "            ");
+        _case(g, opt, "|");
+        if (opt->flags & YACAP_OPTION_FILE) {
+            fprintf(g->file, ") _files;;\n");
+        }
+        else if (opt->flags & YACAP_OPTION_DIRECTORY) {
+            fprintf(g->file, ") _files -/;;\n");
+        }
+        else {
+            fprintf(g->file, ") _message ");
+            _quote(g->file, opt->arg, false);
+            fprintf(g->file, ";;\n");
+        }
+    }
+}
+
+
+static void
+_zsh_command(struct generator *g, const struct yacap_command *cmd) {
+    int i;
+    const struct yacap_option *opt;
+    struct yacap_command * const *sub;
+
+    fprintf(g->file, "        '%.*s')\n            opts=(", PATH(g));
+    for (i = 0; i < g->count; i++) {
+        opt = &g->options[i];
+        if (ISCHAR(opt->key)) {
+            fprintf(g->file, "\n                '-%c':", opt->key);
+            _quote(g->file, opt->help, true);
+        }
+
+        if (opt->name) {
+            fprintf(g->file, "\n                '--%s':", opt->name);
+            _quote(g->file, opt->help, true);
+        }
+    }
+
+    fprintf(g->file, "\n            )\n            cmds=(");
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        fprintf(g->file, "\n                '%s':", (*sub)->name);
+        _quote(g->file, (*sub)->header, true);
+    }
+
+    fprintf(g->file, "\n            )\n            files='%s'\n"
+            "            ;;\n",
+            (cmd->argflags & YACAP_OPTION_FILE)? "f":
+            (cmd->argflags & YACAP_OPTION_DIRECTORY)? "d": "");
+}
+
+
+static int
+_zsh(struct generator *g, const struct yacap *c) {
+    const struct yacap_command *root = (const struct yacap_command *)c;
+    int status = 0;
+
+    fprintf(g->file,
+        "#compdef %s\n"
+        "# %s completion, generated by yacap, do not edit\n"
+        "_yacap_%s() {\n"
+        "    local cmdpath='%s' files='' skip=0 w i\n"
+        "    local -a opts cmds\n"
+        "\n"
+        "    for ((i = 2; i < CURRENT; i++)); do\n"
+        "        w=\"${words[i]}\"\n"
+        "        if ((skip)); then\n"
+        "            skip=0\n"
+        "            continue\n"
+        "        fi\n"
+        "        case \"$cmdpath:$w\" in\n", g->name, g->name, g->name,
+        g->name);
+    status |= _walk(g, root, _sh_skip);
+    fprintf(g->file,
+        "        esac\n"
+        "        case \"$cmdpath $w\" in\n");
+    status |= _walk(g, root, _sh_descent);
+    fprintf(g->file,
+        "        esac\n"
+        "    done\n"
+        "\n"
+        "    if ((skip)); then\n"
+        "        case \"$cmdpath:${words[CURRENT-1]}\" in\n");
+    status |= _walk(g, root, _zsh_value);
+    fprintf(g->file,
+        "        esac\n"
+        "        return\n"
+        "    fi\n"
+        "\n"
+        "    case \"$cmdpath\" in\n");
+    status |= _walk(g, root, _zsh_command);
+    fprintf(g->file,
+        "    esac\n"
+        "\n"
+        "    if [[ \"${words[CURRENT]}\" == -* ]]; then\n"
+        "        _describe 'option' opts\n"
+        "        return\n"
+        "    fi\n"
+        "\n"
+        "    _describe 'command' cmds\n"
+        "    case \"$files\" in\n"
+        "        f) _files;;\n"
+        "        d) _files -/;;\n"
+        "    esac\n"
+        "}\n"
+        "\n"
+        "if [ \"$funcstack[1]\" = \"_%s\" ]; then\n"
+        "    _yacap_%s \"$@\"\n"
+        "else\n"
+        "    compdef _yacap_%s %s\n"
+        "fi\n", g->name, g->name, g->name, g->name);
+
+    return status;
+}
+
+
+/* fish */
+static void
+_fish_skip(struct generator *g, const struct yacap_command *cmd) {
+    int i;
+
+    for (i = 0; i < g->count; i++) {
+        if (YACAP_OPTION_ARGNEEDED(&g->options[i])) {
+            fprintf(g->file, "            case ");
+            _case(g, &g->options[i], " ");
+            fprintf(g->file, "\n                set skip 1\n"
+                    "                continue\n");
+        }
+    }
+}
+
+
+static void
+_fish_descent(struct generator *g, const struct yacap_command *cmd) {
+    struct yacap_command * const *sub;
+
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        fprintf(g->file, "            case '%.*s %s'\n"
+                "                set cmdpath '%.*s %s'\n",
+                PATH(g), (*sub)->name, PATH(g), (*sub)->name);
+    }
+}
+
+
+static void
+_fish_command(struct generator *g, const struct yacap_command *cmd) {
+    int i;
+    const struct yacap_option *opt;
+    struct yacap_command * const *sub;
+    char cond[PATH_BUFFSIZE + 64];
+
+    snprintf(cond, sizeof(cond), "complete -c %s -n \"test "
+            "(__yacap_%s_path) = '%.*s'\"", g->name, g->name, PATH(g));
+
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        fprintf(g->file, "%s -a '%s' -d ", cond, (*sub)->name);
+        _quote(g->file, (*sub)->header, false);
+        fputc('\n', g->file);
+    }
+
+    for (i = 0; i < g->count; i++) {
+        opt = &g->options[i];
+        if ((!ISCHAR(opt->key)) && (opt->name == NULL)) {
+            continue;
+        }
+
+        fprintf(g->file, "%s", cond);
+        if (ISCHAR(opt->key)) {
+            fprintf(g->file, " -s '%c'", opt->key);
+        }
+
+        if (opt->name) {
+            fprintf(g->file, " -l '%s'", opt->name);
+        }
+
+        if (YACAP_OPTION_ARGNEEDED(opt)) {
+            fprintf(g->file, " -r");
+            if (opt->flags & YACAP_OPTION_FILE) {
+                fprintf(g->file, " -F");
+            }
+            else if (opt->flags & YACAP_OPTION_DIRECTORY) {
+                fprintf(g->file, " -a '(__fish_complete_directories)'");
+            }
+        }
+
+        fprintf(g->file, " -d ");
+        _quote(g->file, opt->help, false);
+        fputc('\n', g->file);
+    }
+
+    if (cmd->argflags & YACAP_OPTION_FILE) {
+        fprintf(g->file, "%s -F\n", cond);
+    }
+    else if (cmd->argflags & YACAP_OPTION_DIRECTORY) {
+        fprintf(g->file, "%s -a '(__fish_complete_directories)'\n", cond);
+    }
+}
+
+
+static int
+_fish(struct generator *g, const struct yacap *c) {
+    const struct yacap_command *root = (const struct yacap_command *)c;
+    int status = 0;
+
+    fprintf(g->file,
+        "# %s completion, generated by yacap, do not edit\n"
+        "function __yacap_%s_path\n"
+        "    set -l cmdpath '%s'\n"
+        "    set -l skip 0\n"
+        "    for w in (commandline -opc)[2..-1]\n"
+        "        if test $skip = 1\n"
+        "            set skip 0\n"
+        "            continue\n"
+        "        end\n"
+        "        switch \"$cmdpath:$w\"\n", g->name, g->name, g->name);
+    status |= _walk(g, root, _fish_skip);
+    fprintf(g->file,
+        "        end\n"
+        "        switch \"$cmdpath $w\"\n");
+    status |= _walk(g, root, _fish_descent);
+    fprintf(g->file,
+        "        end\n"
+        "    end\n"
+        "    echo $cmdpath\n"
+        "end\n"
+        "\n"
+        "complete -c %s -f\n", g->name);
+    status |= _walk(g, root, _fish_command);
+
+    return status;
+}
+
+
+/* write the static completion script of the whole command tree for the
+ * given shell: bash, zsh or fish. */
+int
+completion_write(const struct yacap *c, const char *prog, const char *shell,
+        const char *filename) {
+    int i;
+    int count;
+    int status;
+    char tmp[PATH_BUFFSIZE];
+    const struct yacap_option *builtins[BUILTINS_MAX];
+    int (*writer)(struct generator *g, const struct yacap *c);
+    const char *slash = strrchr(prog, '/');
+    struct generator g = {
+        .name = slash? slash + 1: prog,
+        .options = NULL,
+        .count = 0,
+        .size = 0,
+        .allocator = c->allocator,
+    };
+
+    if (shell == NULL) {
+        shell = "bash";
+    }
+
+    if (STREQ(shell, "bash")) {
+        writer = _bash;
+    }
+    else if (STREQ(shell, "zsh")) {
+        writer = _zsh;
+    }
+    else if (STREQ(shell, "fish")) {
+        writer = _fish;
+    }
+    else {
+        PERR("invalid shell for completion: %s\n", shell);
+        return -1;
+    }
+
+    buff_init(&g.path, tmp, sizeof(tmp));
+    buff_printf(&g.path, "%s", g.name);
+    count = _builtins(c, builtins);
+    for (i = 0; i < count; i++) {
+        if (_push(&g, builtins[i])) {
+            allocator_free(g.allocator, g.options);
+            return -1;
+        }
+    }
+
+    g.file = fopen(filename, "w");
+    if (g.file == NULL) {
+        allocator_free(g.allocator, g.options);
+        return -1;
+    }
+
+    status = writer(&g, c);
+    allocator_free(g.allocator, g.options);
+    if (fclose(g.file)) {
+        return -1;
+    }
+
+    return status;
+}
+
+
+/* the command chain of the line being completed, a completion is a single
+ * pass, so the names are scanned in place instead of being indexed. */
+struct completer {
+    const struct yacap_option *builtins[BUILTINS_MAX];
+    int nbuiltins;
+
+    /* options of all the commands of the chain are accepted */
+    const struct yacap_command **chain;
+    unsigned int depth;
+    unsigned int maxdepth;
+
+    /* KEY_* of the short options accepted so far */
+    char keys[128];
+};
+
+
+#define KEY_FLAG 1
+#define KEY_VALUE 2
+
+
+static void
+_completer_key(struct completer *cm, const struct yacap_option *opt) {
+    if ((opt->key > 0) && (opt->key < 128)) {
+        cm->keys[opt->key] = YACAP_OPTION_ARGNEEDED(opt)? KEY_VALUE:
+            KEY_FLAG;
+    }
+}
+
+
+static void
+_completer_enter(struct completer *cm, const struct yacap_command *cmd) {
+    struct optioniter it;
+    const struct yacap_option *opt;
+
+    cm->chain[cm->depth++] = cmd;
+    optioniter_init(&it, cmd);
+    while ((opt = optioniter_next(&it))) {
+        _completer_key(cm, opt);
+    }
+}
+
+
+/* whether the long option takes the next word as it's value */
+static bool
+_completer_longtakesnext(struct completer *cm, const char *name) {
+    int i;
+    unsigned int d;
+    struct optioniter it;
+    const struct yacap_option *opt;
+
+    for (i = 0; i < cm->nbuiltins; i++) {
+        if (STREQ(cm->builtins[i]->name, name)) {
+            return YACAP_OPTION_ARGNEEDED(cm->builtins[i]);
+        }
+    }
+
+    for (d = 0; d < cm->depth; d++) {
+        optioniter_init(&it, cm->chain[d]);
+        while ((opt = optioniter_next(&it))) {
+            if (opt->key && opt->name && STREQ(opt->name, name)) {
+                return YACAP_OPTION_ARGNEEDED(opt);
+            }
+        }
+    }
+
+    return false;
+}
+
+
+/* whether the word is an option which takes the next word as it's value */
+static bool
+_completer_takesnext(struct completer *cm, const char *word) {
+    int i;
+    unsigned char key;
+
+    if (word[1] == '-') {
+        if (strchr(word, '=')) {
+            return false;
+        }
+
+        return _completer_longtakesnext(cm, word + 2);
+    }
+
+    /* packed short options, e.g. -fb or -fbvalue */
+    for (i = 1; word[i]; i++) {
+        key = word[i];
+        if ((key >= 128) || (cm->keys[key] == 0)) {
+            return false;
+        }
+
+        if (cm->keys[key] == KEY_VALUE) {
+            return word[i + 1] == 0;
+        }
+    }
+
+    return false;
+}
+
+
+static void
+_completer_longnames(struct completer *cm, struct buff *out,
+        const char *prefix) {
+    int i;
+    unsigned int d;
+    struct optioniter it;
+    const struct yacap_option *opt;
+    size_t len = strlen(prefix);
+
+    for (i = 0; i < cm->nbuiltins; i++) {
+        if (STRNEQ(cm->builtins[i]->name, prefix, len)) {
+            buff_printf(out, "--%s\n", cm->builtins[i]->name);
+        }
+    }
+
+    for (d = 0; d < cm->depth; d++) {
+        optioniter_init(&it, cm->chain[d]);
+        while ((opt = optioniter_next(&it))) {
+            if (opt->key && opt->name && STRNEQ(opt->name, prefix, len)) {
+                buff_printf(out, "--%s\n", opt->name);
+            }
+        }
+    }
+}
+
+
+static void
+_completer_candidates(struct completer *cm, struct buff *out,
+        const char *word) {
+    int i;
+    size_t len;
+    struct yacap_command * const *sub;
+    const struct yacap_command *cmd = cm->chain[cm->depth - 1];
+
+    if (word[0] != '-') {
+        /* the sub-commands are too deep to enter */
+        if (cm->depth == cm->maxdepth) {
+            return;
+        }
+
+        len = strlen(word);
+        for (sub = cmd->commands; sub && *sub; sub++) {
+            if (STRNEQ((*sub)->name, word, len)) {
+                buff_printf(out, "%s\n", (*sub)->name);
+            }
+        }
+        return;
+    }
+
+    if ((word[1] == 0) || ((word[1] != '-') && (word[2] == 0))) {
+        for (i = 0; i < 128; i++) {
+            if (cm->keys[i] && ISCHAR(i) && ((word[1] == 0) ||
+                        (word[1] == i))) {
+                buff_printf(out, "-%c\n", i);
+            }
+        }
+    }
+
+    if ((word[1] == 0) || (word[1] == '-')) {
+        _completer_longnames(cm, out, word[1]? word + 2: "");
+    }
+}
+
+
+bool
+completion_requested(const struct yacap *c, int argc, const char **argv) {
+    struct optioniter it;
+    const struct yacap_option *opt;
+
+    if ((!HASFLAG(c, YACAP_COMPLETE)) || (argc < 2) ||
+            (!STREQ(argv[1], "--complete"))) {
+        return false;
+    }
+
+    /* the program's own --complete wins */
+    optioniter_init(&it, (const struct yacap_command *)c);
+    while ((opt = optioniter_next(&it))) {
+        if (opt->key && opt->name && STREQ(opt->name, "complete")) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/* hidden --complete mode: argv[2..] are the words of the command line to
+ * complete, the last one is the word under the cursor. candidates are
+ * printed one per line. the init hooks and the eaters are not called. */
+int
+completion_complete(const struct yacap *c, int argc, const char **argv) {
+    int i;
+    bool skip = false;
+    bool dashdash = false;
+    const char *word;
+    const struct yacap_command *sub;
+    struct completer cm;
+    struct buff out;
+    int status;
+
+    memset(&cm, 0, sizeof(cm));
+    cm.nbuiltins = _builtins(c, cm.builtins);
+    for (i = 0; i < cm.nbuiltins; i++) {
+        _completer_key(&cm, cm.builtins[i]);
+    }
+
+    cm.maxdepth = CMDSTACK_MAX(c);
+    cm.chain = allocator_alloc(c->allocator,
+            cm.maxdepth * sizeof(struct yacap_command *));
+    if (cm.chain == NULL) {
+        return -1;
+    }
+
+    if (buff_alloc(&out, 1024, c->allocator)) {
+        allocator_free(c->allocator, cm.chain);
+        return -1;
+    }
+
+    _completer_enter(&cm, (const struct yacap_command *)c);
+
+    /* descend into the sub-commands */
+    for (i = 2; i < (argc - 1); i++) {
+        word = argv[i];
+        if (skip || dashdash) {
+            skip = false;
+            continue;
+        }
+
+        if (STREQ(word, "--")) {
+            dashdash = true;
+            continue;
+        }
+
+        if ((word[0] == '-') && word[1]) {
+            skip = _completer_takesnext(&cm, word);
+            continue;
+        }
+
+        /* the parser rejects the deeper ones, so the candidates are of the
+         * deepest command reached */
+        if (cm.depth == cm.maxdepth) {
+            continue;
+        }
+
+        sub = command_findbyname(cm.chain[cm.depth - 1], word, NULL);
+        if (sub) {
+            _completer_enter(&cm, sub);
+        }
+    }
+
+    /* values and positionals after -- are left to the shell */
+    word = (argc > 2)? argv[argc - 1]: "";
+    if ((!skip) && (!dashdash)) {
+        _completer_candidates(&cm, &out, word);
+    }
+
+    status = buff_flush(&out, STDOUT_FILENO) == -1? -1: 0;
+    allocator_free(c->allocator, cm.chain);
+    buff_free(&out);
+    return status;
+}
+
+
+#endif  // YACAP_USE_COMPLETION
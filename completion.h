@@ -0,0 +1,47 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef COMPLETION_H_
+#define COMPLETION_H_
+
+
+#include <stdbool.h>
+
+#include "include/yacap.h"
+#include "config.h"
+
+
+#ifdef YACAP_USE_COMPLETION
+
+
+int
+completion_write(const struct yacap *c, const char *prog, const char *shell,
+        const char *filename);
+
+
+/* whether the line asks for the hidden --complete mode */
+bool
+completion_requested(const struct yacap *c, int argc, const char **argv);
+
+
+int
+completion_complete(const struct yacap *c, int argc, const char **argv);
+
+
+#endif  // YACAP_USE_COMPLETION
+#endif  // COMPLETION_H_
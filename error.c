@@ -0,0 +1,137 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <string.h>
+
+#include "include/yacap.h"
+#include "config.h"
+#include "buff.h"
+#include "option.h"
+#include "error.h"
+
+
+int
+error_format(struct buff *b, const struct yacap_error *err) {
+    int start = b->len;
+    int textlen = err->text? err->len: 0;
+
+    switch (err->code) {
+        case YACAP_ERR_NONE:
+            return 0;
+
+        case YACAP_ERR_OPTION_UNRECOGNIZED:
+            buff_printf(b, "invalid option -- '%s%.*s'",
+                    textlen == 1? "-": "", textlen, err->text);
+            break;
+
+        case YACAP_ERR_OPTION_MISSINGARGUMENT:
+            buff_printf(b, "option requires an argument -- '");
+            option_format(b, err->option);
+            buff_printf(b, "'");
+            break;
+
+        case YACAP_ERR_OPTION_HASARGUMENT:
+            buff_printf(b, "no argument allowed for option -- '");
+            option_format(b, err->option);
+            buff_printf(b, "'");
+            break;
+
+        case YACAP_ERR_OPTION_REDUNDANT:
+            buff_printf(b, "redundant option -- '");
+            option_format(b, err->option);
+            buff_printf(b, "'");
+            break;
+
+        case YACAP_ERR_OPTION_NOTEATEN:
+            buff_printf(b, "option not eaten -- '");
+            option_format(b, err->option);
+            buff_printf(b, "'");
+            break;
+
+        case YACAP_ERR_POSITIONAL:
+            buff_printf(b, "invalid argument -- '%.*s'", textlen, err->text);
+            break;
+
+        case YACAP_ERR_POSITIONAL_NOTEATEN:
+            buff_printf(b, "argument not eaten -- '%.*s'", textlen,
+                    err->text);
+            break;
+
+        case YACAP_ERR_POSITIONALCOUNT:
+            buff_printf(b, "invalid positional arguments count");
+            break;
+
+        case YACAP_ERR_PATH:
+            buff_printf(b, "%s -- '%.*s'", strerror(err->errnum), textlen,
+                    err->text);
+            break;
+
+        case YACAP_ERR_PATH_NOTFILE:
+            buff_printf(b, "not a regular file -- '%.*s'", textlen,
+                    err->text);
+            break;
+
+        case YACAP_ERR_PATH_NOTDIR:
+            buff_printf(b, "not a directory -- '%.*s'", textlen, err->text);
+            break;
+
+        case YACAP_ERR_OPTION_DUPLICATED:
+            buff_printf(b, "option duplicated -- '");
+            option_format(b, err->option);
+            buff_printf(b, "'");
+            break;
+
+        case YACAP_ERR_OPTION_TOOMANY:
+            buff_printf(b, "maximum allowed options are exceeded: %d",
+                    YACAP_OPTIONS_MAX);
+            break;
+
+        case YACAP_ERR_ARGHINT_TOOCOMPLEX:
+            buff_printf(b, "positional arguments hint is too complex");
+            break;
+
+        case YACAP_ERR_COMMAND_TOODEEP:
+            buff_printf(b, "sub-commands are nested too deep -- '%.*s'",
+                    textlen, err->text);
+            break;
+
+        default:
+            return -1;
+    }
+
+    return b->len - start;
+}
+
+
+/* render the error message into the caller's buffer, no allocation and no
+ * system call is made. the output is truncated and null terminated when
+ * the buffer is too small. */
+int
+yacap_error_format(const struct yacap_error *err, char *buff, size_t size) {
+    struct buff b;
+    int status;
+
+    if ((err == NULL) || (buff == NULL) || (size == 0)) {
+        return -1;
+    }
+
+    buff_init(&b, buff, size);
+    status = error_format(&b, err);
+    buff[b.len] = 0;
+    return status;
+}
@@ -87,6 +87,7 @@ static struct yacap cli = {
         NULL
     },
     .entrypoint = _main,
+    .prerender = YACAP_PRERENDERED,
 };
 
 
@@ -27,9 +27,20 @@
 #include "builtin.h"
 #include "state.h"
 #include "help.h"
+#include "buff.h"
+#include "option.h"
+#include "prerender.h"
+#include "sink.h"
 
 
 #define OPT_MINGAP 4
+#define HELP_BUFFSIZE 4096
+#define LINESIZE_MIN 16
+
+/* the help column is at most at the middle of the line, the help of longer
+ * options starts on the next line, so the page grows linearly with the
+ * options and their help, not with the longest name times the options */
+#define OPT_GAPMAX (YACAP_HELP_LINESIZE / 2 - 8)
 #define OPT_HELPLEN(o) ((o)->name? \
     (strlen((o)->name) + ((o)->arg? strlen((o)->arg) + 1: 0)): 0)
 
@@ -63,7 +74,8 @@ _calculate_initial_gapsize(const struct yacap *c, bool subcommand) {
 
 
 static void
-_print_multiline(int fd, const char *string, int indent, int linemax) {
+_print_multiline(struct buff *b, const char *string, int indent,
+        int linemax) {
     int remain;
     int linesize = linemax - indent;
     int ls;
@@ -73,6 +85,10 @@ _print_multiline(int fd, const char *string, int indent, int linemax) {
         return;
     }
 
+    if (linesize < LINESIZE_MIN) {
+        linesize = LINESIZE_MIN;
+    }
+
     remain = strlen(string);
     while (remain) {
         dash = false;
@@ -82,7 +98,8 @@ _print_multiline(int fd, const char *string, int indent, int linemax) {
         }
 
         if (remain <= linesize) {
-            dprintf(fd, "%s\n", string);
+            buff_write(b, string, remain);
+            buff_write(b, "\n", 1);
             remain = 0;
             break;
         }
@@ -101,34 +118,43 @@ _print_multiline(int fd, const char *string, int indent, int linemax) {
             ls--;
         }
 
-        dprintf(fd, "%.*s%s\n", ls, string, dash? "-": "");
+        buff_write(b, string, ls);
+        if (dash) {
+            buff_write(b, "-", 1);
+        }
+        buff_write(b, "\n", 1);
         remain -= ls;
         string += ls;
-        dprintf(fd, "%*s", indent, "");
+        buff_pad(b, indent);
     }
 }
 
 
 static void
-_print_optiongroup(int fd, const struct yacap_option *opt, int gapsize) {
+_print_optiongroup(struct buff *b, const struct yacap_option *opt,
+        int gapsize) {
     int rpad;
 
     if (opt->name && (!STREQ("-", opt->name))) {
         rpad = (gapsize + 8) - strlen(opt->name);
-        dprintf(fd, "\n%s%*s", opt->name, rpad, "");
+        buff_printf(b, "\n%s%*s", opt->name, MAX(rpad, 0), "");
+        if (opt->help && (rpad < 1)) {
+            buff_write(b, "\n", 1);
+            buff_pad(b, gapsize + 8);
+        }
     }
 
     if (opt->help) {
-        _print_multiline(fd, opt->help, gapsize + 8, YACAP_HELP_LINESIZE);
+        _print_multiline(b, opt->help, gapsize + 8, YACAP_HELP_LINESIZE);
     }
     else {
-        dprintf(fd, "\n");
+        buff_write(b, "\n", 1);
     }
 }
 
 
 static void
-_print_subcommands(int fd, const struct yacap_command *cmd) {
+_print_subcommands(struct buff *b, const struct yacap_command *cmd) {
     struct yacap_command * const *c = cmd->commands;
     struct yacap_command *s;
 
@@ -136,167 +162,281 @@ _print_subcommands(int fd, const struct yacap_command *cmd) {
         return;
     }
 
-    dprintf(fd, "\nCommands:\n");
+    buff_printf(b, "\nCommands:\n");
     while ((s = *c)) {
-        dprintf(fd, "  %s\n", s->name);
+        buff_printf(b, "  %s\n", s->name);
         c++;
     }
 }
 
 
 static void
-_print_option(int fd, const struct yacap_option *opt, int gapsize) {
+_print_option(struct buff *b, const struct yacap_option *opt, int gapsize) {
     int rpad = gapsize - OPT_HELPLEN(opt);
 
+    /* wider than the column */
+    if (rpad < OPT_MINGAP) {
+        rpad = 0;
+    }
+
     if (ISCHAR(opt->key)) {
-        dprintf(fd, "  -%c%c ", opt->key, opt->name? ',': ' ');
+        buff_printf(b, "  -%c%c ", opt->key, opt->name? ',': ' ');
     }
     else {
-        dprintf(fd, "      ");
+        buff_pad(b, 6);
     }
 
     if (opt->name) {
         if (opt->arg == NULL) {
-            dprintf(fd, "--%s%*s", opt->name, rpad, "");
+            buff_printf(b, "--%s%*s", opt->name, rpad, "");
         }
         else {
-            dprintf(fd, "--%s=%s%*s", opt->name, opt->arg, rpad, "");
+            buff_printf(b, "--%s=%s%*s", opt->name, opt->arg, rpad, "");
         }
     }
     else {
-        dprintf(fd, "  %*s", rpad, "");
+        buff_printf(b, "  %*s", rpad, "");
     }
 
     if (opt->help) {
-        _print_multiline(fd, opt->help, gapsize + 8, YACAP_HELP_LINESIZE);
+        if (rpad == 0) {
+            buff_write(b, "\n", 1);
+            buff_pad(b, gapsize + 8);
+        }
+        _print_multiline(b, opt->help, gapsize + 8, YACAP_HELP_LINESIZE);
     }
     else {
-        dprintf(fd, "\n");
+        buff_write(b, "\n", 1);
     }
 }
 
 
 static void
-_print_options(int fd, const struct yacap *c, const struct yacap_command *cmd) {
+_print_options(struct buff *b, const struct yacap *c,
+        const struct yacap_command *cmd, bool subcommand) {
     int gapsize;
-    int i = 0;
+    struct optioniter it;
     const struct yacap_option *opt;
-    bool subcommand = c->state->cmdstack.len > 1;
 
     /* calculate gap size between options and description */
     gapsize = _calculate_initial_gapsize(c, subcommand);
-    while (cmd->options) {
-        opt = &(cmd->options[i++]);
-        if (opt->name == NULL) {
-            break;
-        }
-
+    optioniter_init(&it, cmd);
+    while ((opt = optioniter_next(&it))) {
         gapsize = MAX(gapsize, OPT_HELPLEN(opt) + OPT_MINGAP);
     }
+    gapsize = MIN(gapsize, MAX(OPT_GAPMAX, 8));
 
-    dprintf(fd, "\nOptions:\n");
+    buff_printf(b, "\nOptions:\n");
     if (!HASFLAG(c, YACAP_NO_HELP)) {
-        _print_option(fd, &opt_help, gapsize);
+        _print_option(b, &opt_help, gapsize);
     }
 
     if (!HASFLAG(c, YACAP_NO_USAGE)) {
-        _print_option(fd, &opt_usage, gapsize);
+        _print_option(b, &opt_usage, gapsize);
     }
 
 #ifdef YACAP_USE_CLOG
     if ((!subcommand) && (!HASFLAG(c, YACAP_NO_CLOG))) {
-        _print_option(fd, &opt_verboseflag, gapsize);
-        _print_option(fd, &opt_quietflag, gapsize);
-        _print_option(fd, &opt_verbosity, gapsize);
+        _print_option(b, &opt_verboseflag, gapsize);
+        _print_option(b, &opt_quietflag, gapsize);
+        _print_option(b, &opt_verbosity, gapsize);
     }
 #endif
 
     if (!subcommand && c->version) {
-        _print_option(fd, &opt_version, gapsize);
+        _print_option(b, &opt_version, gapsize);
     }
 
-    i = 0;
-    while (cmd->options) {
-        opt = &(cmd->options[i++]);
-        if (opt->name == NULL) {
-            break;
-        }
-
+    optioniter_init(&it, cmd);
+    while ((opt = optioniter_next(&it))) {
         if (opt->key) {
-            _print_option(fd, opt, gapsize);
+            _print_option(b, opt, gapsize);
         }
         else {
-            _print_optiongroup(fd, opt, gapsize);
+            _print_optiongroup(b, opt, gapsize);
         }
     }
 }
 
 
-void
-yacap_usage_print(const struct yacap *c) {
-    char delim[1] = {'\n'};
-    char *needle;
-    char *saveptr = NULL;
-    char *buff = NULL;
+static void
+_print_usage(struct buff *b, const struct yacap *c) {
+    const char *needle;
+    const char *eol;
+    bool first = true;
     struct yacap_state *state = c->state;
     const struct yacap_command *cmd = cmdstack_last(&state->cmdstack);
 
-    POUT("Usage: ");
-    cmdstack_print(STDOUT_FILENO, &state->cmdstack);
-    POUT(" [OPTION...]");
+    buff_printf(b, "Usage: ");
+    cmdstack_format(b, &state->cmdstack);
+    buff_printf(b, " [OPTION...]");
+
+    /* each line of the args is an alternative usage form */
+    needle = cmd->args;
+    while (needle && needle[0]) {
+        eol = strchrnul(needle, '\n');
+        if (eol > needle) {
+            if (!first) {
+                buff_printf(b, "\n   or: ");
+                cmdstack_format(b, &state->cmdstack);
+                buff_printf(b, " [OPTION...]");
+            }
+            buff_printf(b, " %.*s", (int)(eol - needle), needle);
+            first = false;
+        }
 
-    if (cmd->args == NULL) {
-        goto done;
+        needle = eol[0]? eol + 1: eol;
     }
 
-    buff = malloc(strlen(cmd->args) + 1);
-    strcpy(buff, cmd->args);
+    buff_write(b, "\n", 1);
+}
 
-    needle = strtok_r(buff, delim, &saveptr);
-    POUT(" %s", needle);
-    while (true) {
-        needle = strtok_r(NULL, delim, &saveptr);
-        if (needle == NULL) {
-            break;
-        }
-        POUT("\n   or: ");
-        cmdstack_print(STDOUT_FILENO, &state->cmdstack);
-        POUT(" [OPTION...] %s", needle);
+
+void
+help_scratch(struct buff *b, const struct yacap *c) {
+    struct yacap_state *state = c->state;
+
+    if (state->scratchbusy) {
+        buff_initgrowable(b, NULL, 0, STATE_ALLOCATOR(state));
+        return;
     }
 
-done:
-    if (buff) {
-        free(buff);
+    state->scratchbusy = true;
+    buff_initgrowable(b, state->scratch.render, sizeof(state->scratch.render),
+            STATE_ALLOCATOR(state));
+}
+
+
+void
+help_scratchfree(struct buff *b, const struct yacap *c) {
+    if (b->storage && (b->storage == c->state->scratch.render)) {
+        c->state->scratchbusy = false;
     }
-    POUT("\n");
+
+    buff_free(b);
+}
+
+
+int
+yacap_usage_render(const struct yacap *c, struct yacap_sink *sink) {
+    struct buff b;
+    int status;
+
+    if ((c == NULL) || (c->state == NULL) || (sink == NULL)) {
+        return -1;
+    }
+
+    help_scratch(&b, c);
+    _print_usage(&b, c);
+    status = sink_write(sink, b.data, b.len);
+    help_scratchfree(&b, c);
+    return status;
 }
 
 
 void
-yacap_help_print(const struct yacap *c) {
-    struct yacap_state *state = c->state;
-    const struct yacap_command *cmd = cmdstack_last(&state->cmdstack);
+yacap_usage_print(const struct yacap *c) {
+    struct yacap_sink sink = SINK_FD(STDOUT_FILENO, c);
+
+    yacap_usage_render(c, &sink);
+    sink_drain(&sink);
+    yacap_sink_dispose(&sink);
+}
 
-    /* usage */
-    yacap_usage_print(c);
 
+/* everything after the usage line, it does not depend on the argv and
+ * the command chain, so it may be rendered at build time, see prerender.c */
+void
+help_body(struct buff *b, const struct yacap *c,
+        const struct yacap_command *cmd, bool subcommand) {
     /* header */
     if (cmd->header) {
-        POUT("\n");
-        _print_multiline(STDOUT_FILENO, cmd->header, 0, YACAP_HELP_LINESIZE);
+        buff_write(b, "\n", 1);
+        _print_multiline(b, cmd->header, 0, YACAP_HELP_LINESIZE);
     }
 
     /* sub-commands */
     if (cmd->commands && cmd->commands[0]) {
-        _print_subcommands(STDOUT_FILENO, cmd);
+        _print_subcommands(b, cmd);
     }
 
     /* options */
-    _print_options(STDOUT_FILENO, c, cmd);
+    _print_options(b, c, cmd, subcommand);
 
     /* footer */
     if (cmd->footer) {
-        POUT("\n");
-        _print_multiline(STDOUT_FILENO, cmd->footer, 0, YACAP_HELP_LINESIZE);
+        buff_write(b, "\n", 1);
+        _print_multiline(b, cmd->footer, 0, YACAP_HELP_LINESIZE);
     }
 }
+
+
+int
+yacap_help_render(const struct yacap *c, struct yacap_sink *sink) {
+    int status;
+    struct buff b;
+    struct yacap_state *state;
+    const struct yacap_command *cmd;
+    bool subcommand;
+
+    if ((c == NULL) || (c->state == NULL) || (sink == NULL)) {
+        return -1;
+    }
+
+    state = c->state;
+    cmd = cmdstack_last(&state->cmdstack);
+    subcommand = state->cmdstack.len > 1;
+
+#ifdef YACAP_USE_PRERENDER
+    const struct yacap_prerendered *p = prerender_find(c, &state->cmdstack);
+
+    const char *page = p? prerender_page(p, STATE_ALLOCATOR(state)): NULL;
+
+    /* only the usage line is rendered, the rest is written as is */
+    if (page) {
+        help_scratch(&b, c);
+        _print_usage(&b, c);
+        struct iovec iov[2] = {
+            {b.data, b.len},
+            {(void *)page, p->helplen},
+        };
+        status = sink_writev(sink, iov, 2);
+        help_scratchfree(&b, c);
+        prerender_page_free(p, page, STATE_ALLOCATOR(state));
+        return status;
+    }
+
+    /* the doc strings are not in the program, so say it instead of
+     * rendering a help without them */
+    if (prerender_stripped(c)) {
+        help_scratch(&b, c);
+        _print_usage(&b, c);
+        buff_printf(&b, "\nThe help is not available, it's stripped at "
+                "build time.\n");
+        sink_write(sink, b.data, b.len);
+        help_scratchfree(&b, c);
+        return -1;
+    }
+#endif
+
+    /* render the whole help into a single buffer, then write it at once */
+    if (buff_alloc(&b, HELP_BUFFSIZE, STATE_ALLOCATOR(state))) {
+        return -1;
+    }
+
+    _print_usage(&b, c);
+    help_body(&b, c, cmd, subcommand);
+    status = sink_write(sink, b.data, b.len);
+    buff_free(&b);
+    return status;
+}
+
+
+void
+yacap_help_print(const struct yacap *c) {
+    struct yacap_sink sink = SINK_FD(STDOUT_FILENO, c);
+
+    yacap_help_render(c, &sink);
+    sink_drain(&sink);
+    yacap_sink_dispose(&sink);
+}
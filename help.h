@@ -20,4 +20,28 @@
 #define HELP_H_
 
 
+#include <stdbool.h>
+
+#include "include/yacap.h"
+#include "buff.h"
+
+
+/* linear in the text of the command and it's options, the options column
+ * is capped, see OPT_GAPMAX */
+void
+help_body(struct buff *b, const struct yacap *c,
+        const struct yacap_command *cmd, bool subcommand);
+
+
+/* the renders compose into the scratch of the state, which moves to the
+ * heap when it's full. a render within another one, e.g. by a sink
+ * callback, starts on the heap. */
+void
+help_scratch(struct buff *b, const struct yacap *c);
+
+
+void
+help_scratchfree(struct buff *b, const struct yacap *c);
+
+
 #endif  // HELP_H_
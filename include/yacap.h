@@ -21,6 +21,11 @@
 
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 
 /* yacap_parse() result */
@@ -55,11 +60,41 @@ enum yacap_eatstatus {
 };
 
 
+/* yacap_parse() rejection reason */
+enum yacap_errcode {
+    YACAP_ERR_NONE = 0,
+    YACAP_ERR_OPTION_UNRECOGNIZED,
+    YACAP_ERR_OPTION_MISSINGARGUMENT,
+    YACAP_ERR_OPTION_HASARGUMENT,
+    YACAP_ERR_OPTION_REDUNDANT,
+    YACAP_ERR_OPTION_NOTEATEN,
+    YACAP_ERR_POSITIONAL,
+    YACAP_ERR_POSITIONAL_NOTEATEN,
+    YACAP_ERR_POSITIONALCOUNT,
+    YACAP_ERR_PATH,
+    YACAP_ERR_PATH_NOTFILE,
+    YACAP_ERR_PATH_NOTDIR,
+
+    /* programming errors of the option tables and the positionals hints,
+     * yacap_parse() returns YACAP_FATAL */
+    YACAP_ERR_OPTION_DUPLICATED,
+    YACAP_ERR_OPTION_TOOMANY,
+    YACAP_ERR_ARGHINT_TOOCOMPLEX,
+
+    /* the command chain is longer than the maxdepth, the text is the
+     * sub-command which is not entered. yacap_parse() returns YACAP_FATAL */
+    YACAP_ERR_COMMAND_TOODEEP,
+};
+
+
 /* yacap flags */
 enum yacap_flags{
     YACAP_NO_HELP = 1,
     YACAP_NO_USAGE = 2,
     YACAP_NO_CLOG = 4,
+
+    /* enable the hidden --complete mode, see README */
+    YACAP_COMPLETE = 8,
 };
 
 
@@ -81,6 +116,12 @@ typedef int (*yacap_entrypoint_t) (const struct yacap *c,
 enum yacap_optionflags {
     YACAP_OPTION_NONE = 0,
     YACAP_OPTION_MULTIPLE = 1,
+
+    /* the value must be path of an existing regular file / directory. paths
+     * are collected while parsing and checked all at once at the end.
+     * */
+    YACAP_OPTION_FILE = 2,
+    YACAP_OPTION_DIRECTORY = 4,
 };
 
 
@@ -94,6 +135,80 @@ struct yacap_option {
 };
 
 
+/* relocation-free option, the strings are offsets into the pool of it's
+ * table and 0 means NULL, see YACAP_OPTIONTABLE() */
+struct yacap_optionentry {
+    uint32_t name;
+    int key;
+    uint32_t arg;
+    enum yacap_optionflags flags;
+    uint32_t help;
+};
+
+
+struct yacap_optiontable {
+    const char *pool;
+    const struct yacap_optionentry *entries;
+    int count;
+};
+
+
+/* YACAP_OPTIONTABLE(table, list) defines a struct yacap_optiontable named
+ * table from an X-macro list. the list takes the callback and an opaque
+ * argument to pass through, empty strings stand for NULL:
+ *
+ * #define FOO_OPTIONS(O, t) \
+ *     O(t, foo, "foo", 'f', "", 0, "Foo flag") \
+ *     O(t, bar, "bar", 'b', "BAR", 0, "Bar option")
+ *
+ * YACAP_OPTIONTABLE(foo_options, FOO_OPTIONS);
+ *
+ * where the second argument of O is an identifier unique in the list. the
+ * strings are packed into a single pool and the entries refer to them by
+ * offset, so the entries need no load time relocations. */
+#define _YACAP_POOLFIELDS(t, id, name, key, arg, flags, help) \
+    char id ## _name[sizeof(name)]; \
+    char id ## _arg[sizeof(arg)]; \
+    char id ## _help[sizeof(help)];
+#define _YACAP_POOLSTRINGS(t, id, name, key, arg, flags, help) \
+    name, arg, help,
+#define _YACAP_POOLOFFSET(t, field, s) \
+    ((sizeof(s) > 1)? (uint32_t)offsetof(struct t ## _pool, field): 0)
+#define _YACAP_TABLEENTRY(t, id, name, key, arg, flags, help) { \
+    _YACAP_POOLOFFSET(t, id ## _name, name), \
+    key, \
+    _YACAP_POOLOFFSET(t, id ## _arg, arg), \
+    flags, \
+    _YACAP_POOLOFFSET(t, id ## _help, help), \
+},
+#define YACAP_OPTIONTABLE(table, list) \
+    static const struct table ## _pool { \
+        char _null; \
+        list(_YACAP_POOLFIELDS, table) \
+    } table ## _pool = {0, list(_YACAP_POOLSTRINGS, table)}; \
+    static const struct yacap_optionentry table ## _entries[] = { \
+        list(_YACAP_TABLEENTRY, table) \
+    }; \
+    static const struct yacap_optiontable table = { \
+        .pool = (const char *)&table ## _pool, \
+        .entries = table ## _entries, \
+        .count = sizeof(table ## _entries) / \
+            sizeof(struct yacap_optionentry), \
+    }
+
+
+/* internal, the args of a command compiled by it's first parse, see
+ * arghint.h. it's compiled again when the args pointer is changed. */
+struct yacap_arghint {
+    unsigned int seq;
+    const char *args;
+    int status;
+    int count;
+    int loop;
+    uint64_t accept[2];
+};
+
+
 /* command */
 struct yacap_command {
     const char *name;
@@ -106,6 +221,219 @@ struct yacap_command {
     yacap_entrypoint_t entrypoint;
     void *userptr;
     struct yacap_command * const *commands;
+
+    /* YACAP_OPTION_FILE and/or YACAP_OPTION_DIRECTORY to check positionals */
+    enum yacap_optionflags argflags;
+
+    /* alternative to the options, used when options is NULL */
+    const struct yacap_optiontable *optiontable;
+
+    /* internal */
+    struct yacap_arghint arghint;
+};
+
+
+/* when given, yacap_parse() fills this record instead of printing. the
+ * option may be unpacked within the parser state and the text points into
+ * argv, so both are valid until yacap_dispose() and while argv lives. */
+struct yacap_error {
+    enum yacap_errcode code;
+
+    /* the offending argv item and the byte offset within it, argindex is
+     * argc when the error is not bound to a specific item. */
+    int argindex;
+    int offset;
+
+    /* the offending option, NULL for positionals */
+    const struct yacap_option *option;
+
+    /* the offending text (not null terminated) and it's length */
+    const char *text;
+    int len;
+
+    /* errno of the failed path check */
+    int errnum;
+
+    /* the nearest long option name (without dashes) or sub-command for the
+     * unrecognized ones, NULL when nothing is close enough */
+    const char *suggestion;
+};
+
+
+/* help page rendered at build time, see cmake/yacap.cmake */
+struct yacap_prerendered {
+    /* of the command, it's path and the yacap flags the page is rendered
+     * with, the page is used only when the command still matches it */
+    uint64_t fingerprint;
+
+    /* everything after the usage line, helplen is the rendered length.
+     * when compressedlen is not zero, help holds the compressed page. */
+    const char *help;
+    int helplen;
+    int compressedlen;
+};
+
+
+/* help search index, see search.c. strings are offsets into the pool, the
+ * offset 0 is an empty string. */
+struct yacap_searchdoc {
+    /* space separated names of the sub-commands, empty for the root */
+    int path;
+
+    /* the option, or empty for the command itself */
+    int option;
+
+    /* commands only, the first doc after the sub-tree */
+    int end;
+};
+
+
+/* a lowercase word of the names and doc strings */
+struct yacap_searchword {
+    int text;
+    int len;
+    int doc;
+};
+
+
+struct yacap_searchindex {
+    const char *pool;
+    const struct yacap_searchdoc *docs;
+    int docscount;
+    const struct yacap_searchword *words;
+    int wordscount;
+
+    /* words are sorted, so a keyword is looked up by bisection */
+    bool sorted;
+
+    /* of the whole tree, the index is used only when it still matches */
+    uint64_t fingerprint;
+};
+
+
+/* the output of yacap_prerender_help(), see YACAP_PRERENDERED */
+struct yacap_prerender {
+    const struct yacap_prerendered *pages;
+    int count;
+
+    /* the program is built with the doc strings stripped */
+    bool stripped;
+
+    /* the sorted --help=KEYWORD index, NULL without SEARCH */
+    const struct yacap_searchindex *search;
+};
+
+
+/* for the prerender of the root, the pages yacap_prerender_help(<target>)
+ * links into the <target>. it's NULL within the twin rendering them and
+ * for the programs not built with it. */
+#ifdef YACAP_PRERENDER_SYMBOL
+extern const struct yacap_prerender YACAP_PRERENDER_SYMBOL;
+#define YACAP_PRERENDERED (&YACAP_PRERENDER_SYMBOL)
+#else
+#define YACAP_PRERENDERED NULL
+#endif
+
+
+/* wrap help, header and footer strings with this to drop them from the
+ * binary when it's help pages are rendered at build time, see
+ * yacap_prerender_help(... STRIP) in cmake/yacap.cmake. */
+#ifdef YACAP_STRIP_HELP
+#define YACAP_DOC(s) NULL
+#else
+#define YACAP_DOC(s) s
+#endif
+
+
+/* output sinks for help, usage and command chain */
+enum yacap_sinktype {
+    /* file descriptor, unwritten bytes of non-blocking fds are kept, see
+     * yacap_sink_flush() */
+    YACAP_SINK_FD,
+
+    /* FILE* stream */
+    YACAP_SINK_FILE,
+
+    /* caller provided memory, output is truncated when it's full */
+    YACAP_SINK_MEMORY,
+
+    /* user callback, it's called again with the rest when it accepts a part
+     * of the data. the bytes are kept as pending when it returns 0, see
+     * yacap_sink_flush(). */
+    YACAP_SINK_CALLBACK,
+};
+
+
+/* memory allocator, the libc one is used when not given. realloc is never
+ * called with a NULL pointer and oldsize is the count of the leading bytes
+ * of ptr in use, which must be preserved. the blocks may be released all at
+ * once, e.g. by a bump allocator, after yacap_dispose(). */
+struct yacap_allocator {
+    void *(*alloc)(size_t size, void *userptr);
+    void *(*realloc)(void *ptr, size_t oldsize, size_t size, void *userptr);
+    void (*free)(void *ptr, void *userptr);
+    void *userptr;
+};
+
+
+typedef ssize_t (*yacap_sinkwriter_t) (const char *data, size_t len,
+        void *userptr);
+
+
+struct yacap_sink {
+    enum yacap_sinktype type;
+    union {
+        int fd;
+        FILE *file;
+        struct {
+            char *data;
+            size_t size;
+            size_t len;
+        } memory;
+        struct {
+            yacap_sinkwriter_t write;
+            void *userptr;
+        } callback;
+    };
+
+    /* allocates the pending bytes, the libc allocator when NULL */
+    const struct yacap_allocator *allocator;
+
+    /* internal, bytes not accepted by a non-blocking fd or the callback
+     * yet */
+    char *pending;
+    size_t pendinglen;
+};
+
+
+/* counters of the last parse, see yacap_stats() */
+struct yacap_stats {
+    /* tokens of the argv, each option of a short cluster is a token */
+    unsigned int tokens;
+
+    /* option lookups by --name and by -k, and sub-command lookups */
+    unsigned int longlookups;
+    unsigned int shortlookups;
+    unsigned int commandlookups;
+
+    /* names compared by the long option and the sub-command lookups */
+    unsigned int comparisons;
+
+    /* fresh blocks and resizes requested from the allocator by the parser,
+     * and the bytes requested, only the growth of a resize counts */
+    unsigned int allocations;
+    unsigned int reallocations;
+    size_t allocated;
+
+    /* sub-commands entered */
+    unsigned int depth;
+
+    /* wall time in nanoseconds, parse covers the init hooks and the eaters
+     * and total covers all the phases */
+    uint64_t setupns;
+    uint64_t parsens;
+    uint64_t pathcheckns;
+    uint64_t totalns;
 };
 
 
@@ -115,6 +443,19 @@ struct yacap {
 
     const char *version;
     enum yacap_flags flags;
+    struct yacap_error *error;
+
+    /* maximum length of the command chain, including the root, zero means
+     * YACAP_CMDSTACK_MAX. the chain lives on the heap, the parser itself
+     * takes a constant amount of stack regardless of the depth. */
+    unsigned int maxdepth;
+
+    /* used for all the allocations of the parse and the rendering, the libc
+     * allocator when NULL. it must not change until yacap_dispose(). */
+    const struct yacap_allocator *allocator;
+
+    /* the help rendered at build time, usually YACAP_PRERENDERED */
+    const struct yacap_prerender *prerender;
 
     /* Internal yacap state */
     yacap_state_t state;
@@ -134,10 +475,30 @@ void
 yacap_usage_print(const struct yacap *c);
 
 
+int
+yacap_usage_render(const struct yacap *c, struct yacap_sink *sink);
+
+
 void
 yacap_help_print(const struct yacap *c);
 
 
+int
+yacap_help_render(const struct yacap *c, struct yacap_sink *sink);
+
+
+/* prints the commands and options of the current command's sub-tree which
+ * have words starting with each of the keywords, one per line. returns the
+ * number of hits. */
+int
+yacap_helpsearch_print(const struct yacap *c, const char *keywords);
+
+
+int
+yacap_helpsearch_render(const struct yacap *c, const char *keywords,
+        struct yacap_sink *sink);
+
+
 int
 yacap_try_help(const struct yacap *c);
 
@@ -146,4 +507,71 @@ int
 yacap_commandchain_print(int fd, const struct yacap *c);
 
 
+int
+yacap_commandchain_render(const struct yacap *c, struct yacap_sink *sink);
+
+
+ssize_t
+yacap_sink_flush(struct yacap_sink *sink);
+
+
+void
+yacap_sink_dispose(struct yacap_sink *sink);
+
+
+const struct stat *
+yacap_pathstat(const struct yacap *c, const char *path);
+
+
+/* valid until yacap_dispose(), NULL when not parsed */
+const struct yacap_stats *
+yacap_stats(const struct yacap *c);
+
+
+int
+yacap_error_format(const struct yacap_error *err, char *buff, size_t size);
+
+
+/* the entry point of the twin built by yacap_prerender_help(), see
+ * cmake/yacap.cmake. the twin is compiled with YACAP_PRERENDER_TWIN, so
+ * its yacap_parse() calls write the help pages and return. */
+enum yacap_status
+yacap_prerender_main(const struct yacap *c, int argc, const char **argv);
+
+
+#ifdef YACAP_PRERENDER_TWIN
+static inline enum yacap_status
+yacap_prerender_parse(struct yacap *c, int argc, const char **argv,
+        const struct yacap_command **command) {
+    if (command) {
+        *command = NULL;
+    }
+
+    return yacap_prerender_main(c, argc, argv);
+}
+#define yacap_parse yacap_prerender_parse
+#endif
+
+
+/* the entry point of the twin built by yacap_completion(), see
+ * cmake/yacap.cmake. the twin is compiled with YACAP_COMPLETION_TWIN, so
+ * its yacap_parse() calls write the completion script and return. */
+enum yacap_status
+yacap_completion_main(const struct yacap *c, int argc, const char **argv);
+
+
+#ifdef YACAP_COMPLETION_TWIN
+static inline enum yacap_status
+yacap_completion_parse(struct yacap *c, int argc, const char **argv,
+        const struct yacap_command **command) {
+    if (command) {
+        *command = NULL;
+    }
+
+    return yacap_completion_main(c, argc, argv);
+}
+#define yacap_parse yacap_completion_parse
+#endif
+
+
 #endif  // YACAP_H_
@@ -0,0 +1,192 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "helpers.h"
+#include "allocator.h"
+#include "buff.h"
+#include "lz.h"
+
+
+#define LITERAL_MAX 128
+#define MATCH_MIN 3
+#define MATCH_MAX (127 + MATCH_MIN)
+#define DISTANCE_MAX 65535
+#define CHAIN_MAX 64
+#define HASHBITS 13
+#define HASH(p) ((((p)[0] << 10) ^ ((p)[1] << 5) ^ (p)[2]) & \
+        ((1 << HASHBITS) - 1))
+
+
+/* returns -1 when the output can't grow */
+static int
+_literals(struct buff *out, const char *in, size_t len) {
+    unsigned char c;
+    unsigned char n;
+
+    while (len) {
+        c = MIN(len, LITERAL_MAX);
+        n = c - 1;
+        if ((buff_write(out, (char *)&n, 1) != 1) ||
+                (buff_write(out, in, c) != c)) {
+            return -1;
+        }
+        in += c;
+        len -= c;
+    }
+
+    return 0;
+}
+
+
+/* greedy matching using hash chains, it's used at build time only. the
+ * tables are allocated with the allocator of the output buffer. */
+int
+lz_compress(struct buff *out, const char *in, size_t len) {
+    size_t i;
+    size_t j;
+    size_t cand;
+    size_t best;
+    size_t bestdist;
+    size_t limit;
+    size_t literal = 0;
+    int status = 0;
+    int chain;
+    int hash;
+    size_t *head;
+    size_t *prev;
+    unsigned char match[3];
+    const unsigned char *s = (const unsigned char *)in;
+
+    head = allocator_alloc(out->allocator, (1 << HASHBITS) * sizeof(size_t));
+    prev = allocator_alloc(out->allocator, MAX(len, 1) * sizeof(size_t));
+    if ((head == NULL) || (prev == NULL)) {
+        allocator_free(out->allocator, head);
+        allocator_free(out->allocator, prev);
+        return -1;
+    }
+
+    /* SIZE_MAX marks an empty slot */
+    memset(head, 0xff, (1 << HASHBITS) * sizeof(size_t));
+
+    i = 0;
+    while ((i < len) && (status == 0)) {
+        best = 0;
+        bestdist = 0;
+
+        if ((i + MATCH_MIN) <= len) {
+            hash = HASH(s + i);
+            limit = MIN(len - i, MATCH_MAX);
+            cand = head[hash];
+            for (chain = 0; (cand != SIZE_MAX) && (chain < CHAIN_MAX) &&
+                    ((i - cand) <= DISTANCE_MAX); chain++) {
+                for (j = 0; (j < limit) && (s[cand + j] == s[i + j]); j++) {
+                }
+
+                if (j > best) {
+                    best = j;
+                    bestdist = i - cand;
+                    if (best == limit) {
+                        break;
+                    }
+                }
+                cand = prev[cand];
+            }
+        }
+
+        if (best < MATCH_MIN) {
+            best = 1;
+        }
+        else {
+            match[0] = 0x80 | (best - MATCH_MIN);
+            match[1] = bestdist >> 8;
+            match[2] = bestdist & 0xff;
+            if (_literals(out, in + literal, i - literal) ||
+                    (buff_write(out, (char *)match, 3) != 3)) {
+                status = -1;
+            }
+        }
+
+        /* index all positions of this step */
+        for (j = 0; j < best; j++, i++) {
+            if ((i + MATCH_MIN) <= len) {
+                hash = HASH(s + i);
+                prev[i] = head[hash];
+                head[hash] = i;
+            }
+        }
+
+        if (best >= MATCH_MIN) {
+            literal = i;
+        }
+    }
+
+    if ((status == 0) && _literals(out, in + literal, len - literal)) {
+        status = -1;
+    }
+    allocator_free(out->allocator, head);
+    allocator_free(out->allocator, prev);
+    return status;
+}
+
+
+int
+lz_decompress(char *out, size_t outlen, const unsigned char *in,
+        size_t len) {
+    size_t i = 0;
+    size_t o = 0;
+    size_t n;
+    size_t dist;
+    unsigned char c;
+
+    while (i < len) {
+        c = in[i++];
+        if (c < 0x80) {
+            n = c + 1;
+            if (((i + n) > len) || ((o + n) > outlen)) {
+                return -1;
+            }
+
+            memcpy(out + o, in + i, n);
+            i += n;
+            o += n;
+            continue;
+        }
+
+        if ((i + 2) > len) {
+            return -1;
+        }
+
+        n = (c & 0x7f) + MATCH_MIN;
+        dist = (in[i] << 8) | in[i + 1];
+        i += 2;
+        if ((dist == 0) || (dist > o) || ((o + n) > outlen)) {
+            return -1;
+        }
+
+        /* byte by byte, the source may overlap the destination */
+        for (; n; n--, o++) {
+            out[o] = out[o - dist];
+        }
+    }
+
+    return o;
+}
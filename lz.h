@@ -0,0 +1,43 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef LZ_H_
+#define LZ_H_
+
+
+#include <stddef.h>
+
+#include "buff.h"
+
+
+/* A tiny LZ77 codec to store pre-rendered help pages, the stream is a
+ * sequence of:
+ *  0lllllll <l + 1 literal bytes>
+ *  1lllllll <distance: 2 bytes, big endian>, copy l + 3 bytes from
+ *  distance bytes behind.
+ */
+int
+lz_compress(struct buff *out, const char *in, size_t len);
+
+
+int
+lz_decompress(char *out, size_t outlen, const unsigned char *in,
+        size_t len);
+
+
+#endif  // LZ_H_
@@ -17,20 +17,22 @@
  *  Author: Vahid Mardani <vahid.mardani@gmail.com>
  */
 #include <stdio.h>
+#include <string.h>
 
 #include "include/yacap.h"
 #include "config.h"
 #include "helpers.h"
+#include "buff.h"
 #include "option.h"
 
 
 int
-option_print(int fd, const struct yacap_option *opt) {
+option_format(struct buff *b, const struct yacap_option *opt) {
     int bytes = 0;
     int status;
 
     if ((opt->key != 0) && ISCHAR(opt->key)) {
-        status = dprintf(fd, "-%c%s", opt->key, opt->name? "/": "");
+        status = buff_printf(b, "-%c%s", opt->key, opt->name? "/": "");
         if (status == -1) {
             return -1;
         }
@@ -39,7 +41,7 @@ option_print(int fd, const struct yacap_option *opt) {
     }
 
     if (opt->name) {
-        status = dprintf(fd, "--%s", opt->name);
+        status = buff_printf(b, "--%s", opt->name);
         if (status == -1) {
             return -1;
         }
@@ -49,3 +51,50 @@ option_print(int fd, const struct yacap_option *opt) {
 
     return bytes;
 }
+
+
+void
+option_unpack(struct yacap_option *opt, const struct yacap_optiontable *t,
+        int index) {
+    const struct yacap_optionentry *e = t->entries + index;
+
+    memcpy(opt, &(struct yacap_option) {
+        .name = OPTIONTABLE_STR(t, e->name),
+        .key = e->key,
+        .arg = OPTIONTABLE_STR(t, e->arg),
+        .flags = e->flags,
+        .help = OPTIONTABLE_STR(t, e->help),
+    }, sizeof(struct yacap_option));
+}
+
+
+void
+optioniter_init(struct optioniter *it, const struct yacap_command *cmd) {
+    it->command = cmd;
+    it->index = 0;
+}
+
+
+const struct yacap_option *
+optioniter_next(struct optioniter *it) {
+    const struct yacap_command *cmd = it->command;
+    const struct yacap_option *opt;
+
+    if (cmd->options) {
+        opt = cmd->options + it->index;
+        if (opt->name == NULL) {
+            return NULL;
+        }
+
+        it->index++;
+        return opt;
+    }
+
+    if ((cmd->optiontable == NULL) ||
+            (it->index >= cmd->optiontable->count)) {
+        return NULL;
+    }
+
+    option_unpack(&it->unpacked, cmd->optiontable, it->index++);
+    return &it->unpacked;
+}
@@ -21,13 +21,36 @@
 
 
 #include "include/yacap.h"
+#include "buff.h"
 
 
 #define YACAP_OPTION_ARGNEEDED(opt) ((opt)->arg != NULL)
+#define OPTIONTABLE_STR(t, off) ((off)? (t)->pool + (off): NULL)
+
+
+/* walks the options of a command, whichever representation it has */
+struct optioniter {
+    const struct yacap_command *command;
+    int index;
+    struct yacap_option unpacked;
+};
 
 
 int
-option_print(int fd, const struct yacap_option *opt);
+option_format(struct buff *b, const struct yacap_option *opt);
+
+
+void
+option_unpack(struct yacap_option *opt, const struct yacap_optiontable *t,
+        int index);
+
+
+void
+optioniter_init(struct optioniter *it, const struct yacap_command *cmd);
+
+
+const struct yacap_option *
+optioniter_next(struct optioniter *it);
 
 
 #endif  // OPTION_H_
@@ -18,11 +18,10 @@
  */
 #include <string.h>
 #include <stdlib.h>
-#include <stdio.h>
-#include <unistd.h>
 
 #include "config.h"
 #include "helpers.h"
+#include "allocator.h"
 #include "option.h"
 #include "optiondb.h"
 
@@ -40,11 +39,13 @@ optiondb_extend(struct optiondb *db) {
     }
 
     if (newsize <= db->size) {
-        PERR("maximum allowed options are exceeded: %d\n", YACAP_OPTIONS_MAX);
+        db->error = YACAP_ERR_OPTION_TOOMANY;
         return -1;
     }
 
-    new = realloc(db->repo, newsize * sizeof(struct optioninfo));
+    new = allocator_realloc(db->allocator, db->repo,
+            db->count * sizeof(struct optioninfo),
+            newsize * sizeof(struct optioninfo));
 
     if (new == NULL) {
         return -1;
@@ -56,16 +57,86 @@ optiondb_extend(struct optiondb *db) {
 }
 
 
+#define TABLE(i) ((i)->command->optiontable)
+#define ENTRY(i) (TABLE(i)->entries + (i)->index)
+
+
+const char *
+optioninfo_name(const struct optioninfo *info) {
+    if (info->option) {
+        return info->option->name;
+    }
+
+    return OPTIONTABLE_STR(TABLE(info), ENTRY(info)->name);
+}
+
+
+int
+optioninfo_key(const struct optioninfo *info) {
+    if (info->option) {
+        return info->option->key;
+    }
+
+    return ENTRY(info)->key;
+}
+
+
+const char *
+optioninfo_arg(const struct optioninfo *info) {
+    if (info->option) {
+        return info->option->arg;
+    }
+
+    return OPTIONTABLE_STR(TABLE(info), ENTRY(info)->arg);
+}
+
+
+int
+optiondb_unpack(struct optiondb *db, struct optioninfo *info) {
+    struct optionblock *block;
+    struct yacap_option *opt;
+    int slot;
+
+    if (info->option) {
+        return 0;
+    }
+
+    /* the eaters and the error record hold pointers to the options, so the
+     * storage lives as long as the db */
+    slot = db->unpacked % OPTIONBLOCK_SIZE;
+    if (db->unpacked && (slot == 0)) {
+        block = allocator_alloc(db->allocator, sizeof(struct optionblock));
+        if (block == NULL) {
+            return -1;
+        }
+
+        block->next = db->blocks;
+        db->blocks = block;
+    }
+
+    block = db->blocks? db->blocks: &db->first;
+    opt = &block->options[slot];
+    option_unpack(opt, TABLE(info), info->index);
+    info->option = opt;
+    db->unpacked++;
+    return 0;
+}
+
+
 int
-optiondb_exists(struct optiondb *db, const struct yacap_option *opt) {
+optiondb_exists(const struct optiondb *db, const char *name, int key) {
     int i;
     const struct optioninfo *info;
+    const char *infoname;
 
     for (i = 0; i < db->count; i++) {
         info = db->repo + i;
-        if (((info->option->key == opt->key) ||
-                 (info->option->name && opt->name &&
-                  STREQ(info->option->name, opt->name)))) {
+        if (optioninfo_key(info) == key) {
+            return 1;
+        }
+
+        infoname = optioninfo_name(info);
+        if (infoname && name && STREQ(infoname, name)) {
             return 1;
         }
     }
@@ -74,32 +145,46 @@ optiondb_exists(struct optiondb *db, const struct yacap_option *opt) {
 }
 
 
-int
-optiondb_insert(struct optiondb *db, const struct yacap_option *opt,
-        const struct yacap_command *command) {
+static int
+_insert(struct optiondb *db, struct optioninfo *new) {
     struct optioninfo *info;
 
-    /* check existance */
-    if (optiondb_exists(db, opt)) {
-        PERR("option duplicated -- '");
-        option_print(STDERR_FILENO, opt);
-        PERR("'\n");
+    /* the failures are reported with the option, so the table entry is
+     * unpacked, it's left at YACAP_ERR_NONE when it can't be */
+    if (optiondb_exists(db, optioninfo_name(new), optioninfo_key(new))) {
+        if (optiondb_unpack(db, new) == 0) {
+            db->error = YACAP_ERR_OPTION_DUPLICATED;
+            db->erroroption = new->option;
+        }
         return -1;
     }
 
     /* extend db if there is no space for new item */
     if ((db->count == db->size) && optiondb_extend(db)) {
+        if (optiondb_unpack(db, new)) {
+            db->error = YACAP_ERR_NONE;
+        }
+        db->erroroption = new->option;
         return -1;
     }
 
     info = db->repo + (db->count++);
-    info->option = opt;
-    info->command = command;
+    *info = *new;
     info->occurances = 0;
     return 0;
 }
 
 
+int
+optiondb_insert(struct optiondb *db, const struct yacap_option *opt,
+        const struct yacap_command *command) {
+    return _insert(db, &(struct optioninfo) {
+        .option = opt,
+        .command = command,
+    });
+}
+
+
 int
 optiondb_insertvector(struct optiondb *db, const struct yacap_option *opt,
         const struct yacap_command *cmd) {
@@ -120,13 +205,51 @@ optiondb_insertvector(struct optiondb *db, const struct yacap_option *opt,
 
 
 int
-optiondb_init(struct optiondb *db) {
-    db->repo = calloc(EXTENDSIZE, sizeof(struct optioninfo));
+optiondb_inserttable(struct optiondb *db, const struct yacap_command *cmd) {
+    const struct yacap_optiontable *t = cmd->optiontable;
+    struct optioninfo info = {
+        .option = NULL,
+        .command = cmd,
+    };
+
+    if (t == NULL) {
+        return 0;
+    }
+
+    for (info.index = 0; info.index < t->count; info.index++) {
+        if (t->entries[info.index].key && _insert(db, &info)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+int
+optiondb_insertcommand(struct optiondb *db, const struct yacap_command *cmd) {
+    if (cmd->options) {
+        return optiondb_insertvector(db, cmd->options, cmd);
+    }
+
+    return optiondb_inserttable(db, cmd);
+}
+
+
+int
+optiondb_init(struct optiondb *db, const struct yacap_allocator *a) {
+    db->allocator = a;
+    db->repo = allocator_calloc(a, EXTENDSIZE, sizeof(struct optioninfo));
     if (db->repo == NULL) {
         return -1;
     }
     db->size = EXTENDSIZE;
     db->count = 0;
+    db->blocks = NULL;
+    db->unpacked = 0;
+    db->error = YACAP_ERR_NONE;
+    db->erroroption = NULL;
+    db->stats = NULL;
 
     return 0;
 }
@@ -134,8 +257,14 @@ optiondb_init(struct optiondb *db) {
 
 void
 optiondb_dispose(struct optiondb *db) {
-    if (db->repo) {
-        free(db->repo);
+    struct optionblock *block;
+
+    allocator_free(db->allocator, db->repo);
+    db->repo = NULL;
+
+    while ((block = db->blocks)) {
+        db->blocks = block->next;
+        allocator_free(db->allocator, block);
     }
 
     db->count = -1;
@@ -146,29 +275,37 @@ struct optioninfo *
 optiondb_findbyname(const struct optiondb *db, const char *name,
         int len) {
     int i;
+    unsigned int comparisons = 0;
     struct optioninfo *info;
-    char tmp[len + 1];
+    struct optioninfo *found = NULL;
+    const char *infoname;
 
     if (name == NULL) {
         return NULL;
     }
 
-    strncpy(tmp, name, len);
-    tmp[len] = 0;
-
+    /* compared in place, the name may be as long as an argv word */
     for (i = 0; i < db->count; i++) {
         info = db->repo + i;
+        infoname = optioninfo_name(info);
 
-        if (info->option->name == NULL) {
+        if (infoname == NULL) {
             continue;
         }
 
-        if (STREQ(tmp, info->option->name)) {
-            return info;
+        comparisons++;
+        if ((strncmp(name, infoname, len) == 0) && (infoname[len] == 0)) {
+            found = info;
+            break;
         }
     }
 
-    return NULL;
+    if (db->stats) {
+        db->stats->longlookups++;
+        db->stats->comparisons += comparisons;
+    }
+
+    return found;
 }
 
 
@@ -177,10 +314,14 @@ optiondb_findbykey(const struct optiondb *db, int key) {
     int i;
     struct optioninfo *info;
 
+    if (db->stats) {
+        db->stats->shortlookups++;
+    }
+
     for (i = 0; i < db->count; i++) {
         info = db->repo + i;
 
-        if (info->option->key == key) {
+        if (optioninfo_key(info) == key) {
             return info;
         }
     }
@@ -31,22 +31,47 @@ enum optioninfoflag {
 };
 
 
+/* entries of the command's option table are looked up in place by index,
+ * option is NULL until the entry is matched, see optiondb_unpack() */
 struct optioninfo {
     const struct yacap_option *option;
     const struct yacap_command *command;
     unsigned int occurances;
+    int index;
+};
+
+
+#define OPTIONBLOCK_SIZE 4
+
+
+/* the matched table entries are unpacked here, the first block is a part of
+ * the db and the rest are allocated on demand */
+struct optionblock {
+    struct optionblock *next;
+    struct yacap_option options[OPTIONBLOCK_SIZE];
 };
 
 
 struct optiondb {
     struct optioninfo *repo;
+    struct optionblock first;
+    struct optionblock *blocks;
+    size_t unpacked;
     size_t size;
     volatile size_t count;
+    const struct yacap_allocator *allocator;
+
+    /* why the last insert failed, YACAP_ERR_NONE on allocation failures */
+    enum yacap_errcode error;
+    const struct yacap_option *erroroption;
+
+    /* lookups are counted when it's set */
+    struct yacap_stats *stats;
 };
 
 
 int
-optiondb_init(struct optiondb *db);
+optiondb_init(struct optiondb *db, const struct yacap_allocator *a);
 
 
 void
@@ -64,7 +89,31 @@ optiondb_insertvector(struct optiondb *db, const struct yacap_option *opt,
 
 
 int
-optiondb_exists(struct optiondb *db, const struct yacap_option *opt);
+optiondb_inserttable(struct optiondb *db, const struct yacap_command *cmd);
+
+
+int
+optiondb_insertcommand(struct optiondb *db, const struct yacap_command *cmd);
+
+
+int
+optiondb_exists(const struct optiondb *db, const char *name, int key);
+
+
+int
+optiondb_unpack(struct optiondb *db, struct optioninfo *info);
+
+
+const char *
+optioninfo_name(const struct optioninfo *info);
+
+
+int
+optioninfo_key(const struct optioninfo *info);
+
+
+const char *
+optioninfo_arg(const struct optioninfo *info);
 
 
 struct optioninfo *
@@ -0,0 +1,167 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#include "helpers.h"
+#include "allocator.h"
+#include "pathcheck.h"
+
+
+#define EXTENDSIZE 8
+
+
+void
+pathcheck_init(struct pathcheck *p, const struct yacap_allocator *a) {
+    p->repo = NULL;
+    p->size = 0;
+    p->count = 0;
+    p->allocator = a;
+}
+
+
+void
+pathcheck_dispose(struct pathcheck *p) {
+    allocator_free(p->allocator, p->repo);
+    pathcheck_init(p, p->allocator);
+}
+
+
+int
+pathcheck_append(struct pathcheck *p, const char *path, int argindex,
+        const struct yacap_option *opt, enum yacap_optionflags flags) {
+    struct pathinfo *new;
+    struct pathinfo *info;
+    size_t newsize;
+
+    if (path == NULL) {
+        return -1;
+    }
+
+    /* extend the repo if there is no space for the new item */
+    if (p->count == p->size) {
+        newsize = p->size? p->size * 2: EXTENDSIZE;
+        new = allocator_realloc(p->allocator, p->repo,
+                p->count * sizeof(struct pathinfo),
+                newsize * sizeof(struct pathinfo));
+        if (new == NULL) {
+            return -1;
+        }
+
+        p->repo = new;
+        p->size = newsize;
+    }
+
+    info = p->repo + (p->count++);
+    info->path = path;
+    info->argindex = argindex;
+    info->option = opt;
+    info->flags = PATHCHECK_FLAGS(flags);
+    info->errnum = 0;
+    return 0;
+}
+
+
+/* stat all collected paths in a single pass, paths are not checked while
+ * parsing, so the eaters never wait on the filesystem and the whole batch
+ * is walked once the command line is known to be valid. a command line
+ * carries a handful of paths and a stat of a cached inode is a syscall of
+ * about a microsecond, so it's kept serial rather than spawning threads in
+ * every program. returns the first rejected entry or NULL when all paths
+ * are acceptable. */
+struct pathinfo *
+pathcheck_run(struct pathcheck *p) {
+    size_t i;
+    struct pathinfo *info;
+    struct pathinfo *failed = NULL;
+    mode_t mode;
+
+    for (i = 0; i < p->count; i++) {
+        info = p->repo + i;
+
+        if (fstatat(AT_FDCWD, info->path, &info->stat, 0)) {
+            info->errnum = errno;
+        }
+        else {
+            mode = info->stat.st_mode;
+
+            /* either one is accepted when both flags are set */
+            if (HASFLAG(info, YACAP_OPTION_FILE) &&
+                    HASFLAG(info, YACAP_OPTION_DIRECTORY)) {
+                if ((!S_ISREG(mode)) && (!S_ISDIR(mode))) {
+                    info->errnum = EINVAL;
+                }
+            }
+            else if (HASFLAG(info, YACAP_OPTION_FILE) && (!S_ISREG(mode))) {
+                info->errnum = EINVAL;
+            }
+            else if (HASFLAG(info, YACAP_OPTION_DIRECTORY) &&
+                    (!S_ISDIR(mode))) {
+                info->errnum = ENOTDIR;
+            }
+        }
+
+        if (info->errnum && (failed == NULL)) {
+            failed = info;
+        }
+    }
+
+    return failed;
+}
+
+
+enum yacap_errcode
+pathcheck_errcode(const struct pathinfo *info) {
+    if (info->errnum == 0) {
+        return YACAP_ERR_NONE;
+    }
+
+    if ((info->errnum == EINVAL) && HASFLAG(info, YACAP_OPTION_FILE)) {
+        return YACAP_ERR_PATH_NOTFILE;
+    }
+
+    if ((info->errnum == ENOTDIR) && HASFLAG(info, YACAP_OPTION_DIRECTORY)) {
+        return YACAP_ERR_PATH_NOTDIR;
+    }
+
+    return YACAP_ERR_PATH;
+}
+
+
+const struct pathinfo *
+pathcheck_find(const struct pathcheck *p, const char *path) {
+    size_t i;
+    const struct pathinfo *info;
+
+    if (path == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < p->count; i++) {
+        info = p->repo + i;
+
+        if ((info->path == path) || STREQ(info->path, path)) {
+            return info;
+        }
+    }
+
+    return NULL;
+}
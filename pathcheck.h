@@ -0,0 +1,77 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef PATHCHECK_H_
+#define PATHCHECK_H_
+
+
+#include <stddef.h>
+#include <sys/stat.h>
+
+#include "include/yacap.h"
+
+
+#define PATHCHECK_FLAGS(f) ((f) & (YACAP_OPTION_FILE | YACAP_OPTION_DIRECTORY))
+
+
+struct pathinfo {
+    const char *path;
+    int argindex;
+    const struct yacap_option *option;
+    enum yacap_optionflags flags;
+
+    /* filled by pathcheck_run() */
+    int errnum;
+    struct stat stat;
+};
+
+
+struct pathcheck {
+    struct pathinfo *repo;
+    size_t size;
+    size_t count;
+    const struct yacap_allocator *allocator;
+};
+
+
+void
+pathcheck_init(struct pathcheck *p, const struct yacap_allocator *a);
+
+
+void
+pathcheck_dispose(struct pathcheck *p);
+
+
+int
+pathcheck_append(struct pathcheck *p, const char *path, int argindex,
+        const struct yacap_option *opt, enum yacap_optionflags flags);
+
+
+struct pathinfo *
+pathcheck_run(struct pathcheck *p);
+
+
+enum yacap_errcode
+pathcheck_errcode(const struct pathinfo *info);
+
+
+const struct pathinfo *
+pathcheck_find(const struct pathcheck *p, const char *path);
+
+
+#endif  // PATHCHECK_H_
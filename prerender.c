@@ -0,0 +1,295 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/yacap.h"
+#include "config.h"
+#include "helpers.h"
+#include "allocator.h"
+#include "buff.h"
+#include "help.h"
+#include "cmdstack.h"
+#include "command.h"
+#include "lz.h"
+#include "prerender.h"
+#include "search.h"
+
+
+#ifdef YACAP_USE_PRERENDER
+
+
+#define PATH_BUFFSIZE 1024
+#define BODY_BUFFSIZE 4096
+
+
+bool
+prerender_stripped(const struct yacap *c) {
+    return c->prerender && c->prerender->stripped;
+}
+
+
+const struct yacap_prerendered *
+prerender_find(const struct yacap *c, struct cmdstack *s) {
+    unsigned int i;
+    int j;
+    uint64_t fingerprint;
+    const struct yacap_prerender *r = c->prerender;
+
+    if ((r == NULL) || (r->count == 0)) {
+        return NULL;
+    }
+
+    /* the root name is argv[0], so it's not a part of the path */
+    fingerprint = COMMAND_HASHBASIS;
+    for (i = 1; i < s->len; i++) {
+        fingerprint = command_hash(fingerprint, s->frames[i].command->name);
+    }
+    fingerprint = command_fingerprint(c, cmdstack_last(s), fingerprint,
+            s->len > 1);
+
+    for (j = 0; j < r->count; j++) {
+        if (r->pages[j].fingerprint == fingerprint) {
+            return r->pages + j;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void
+_escape(FILE *f, const char *s, size_t len) {
+    size_t i;
+    unsigned char ch;
+
+    fputs("        \"", f);
+    for (i = 0; i < len; i++) {
+        ch = s[i];
+        switch (ch) {
+            case '\n':
+                fputs("\\n\"", f);
+                if ((i + 1) < len) {
+                    fputs("\n        \"", f);
+                }
+                continue;
+            case '"':
+            case '\\':
+                fputc('\\', f);
+                fputc(ch, f);
+                break;
+            default:
+                if ((ch < 32) || (ch > 126)) {
+                    fprintf(f, "\\%03o", ch);
+                }
+                else {
+                    fputc(ch, f);
+                }
+        }
+    }
+
+    if ((len == 0) || (s[len - 1] != '\n')) {
+        fputc('"', f);
+    }
+}
+
+
+struct generator {
+    FILE *file;
+    bool compress;
+    int pages;
+
+    /* the table is written after all pages */
+    struct buff table;
+};
+
+
+static int
+_write_command(struct generator *g, const struct yacap *c,
+        const struct yacap_command *cmd, struct buff *path,
+        uint64_t pathhash) {
+    struct buff body;
+    struct buff compressed;
+    struct yacap_command * const *sub;
+    size_t pathlen = path->len;
+    const char *page = NULL;
+    size_t pagelen = 0;
+
+    if (buff_alloc(&body, BODY_BUFFSIZE, c->allocator)) {
+        return -1;
+    }
+
+    help_body(&body, c, cmd, pathlen > 0);
+    if (g->compress) {
+        if (buff_alloc(&compressed, BODY_BUFFSIZE, c->allocator) ||
+                lz_compress(&compressed, body.data, body.len)) {
+            buff_free(&body);
+            buff_free(&compressed);
+            return -1;
+        }
+        page = compressed.data;
+        pagelen = compressed.len;
+    }
+    else {
+        page = body.data;
+        pagelen = body.len;
+    }
+
+    /* pages live in their own section, away from the hot data */
+    fprintf(g->file, "static const char _page%d[]\n"
+            "    __attribute__((section(\".yacap_help\"))) =\n", g->pages);
+    _escape(g->file, page, pagelen);
+    fprintf(g->file, ";\n\n\n");
+
+    buff_printf(&g->table, "    /* %.*s */\n    {\n"
+            "        .fingerprint = 0x%016" PRIx64 "ULL,\n",
+            (int)path->len, path->data,
+            command_fingerprint(c, cmd, pathhash, pathlen > 0));
+    buff_printf(&g->table, "        .help = _page%d,\n"
+            "        .helplen = %zu,\n"
+            "        .compressedlen = %zu,\n    },\n", g->pages, body.len,
+            g->compress? pagelen: 0);
+    g->pages++;
+
+    if (g->compress) {
+        buff_free(&compressed);
+    }
+    buff_free(&body);
+
+    if (cmd->commands == NULL) {
+        return 0;
+    }
+
+    for (sub = cmd->commands; *sub; sub++) {
+        buff_printf(path, "%s%s", pathlen? " ": "", (*sub)->name);
+        if (_write_command(g, c, *sub, path,
+                    command_hash(pathhash, (*sub)->name))) {
+            return -1;
+        }
+        path->len = pathlen;
+    }
+
+    return 0;
+}
+
+
+/* render help of all commands into a C source file defining the symbol as
+ * the struct yacap_prerender, pages are compressed using lz.c with
+ * PRERENDER_COMPRESS and the help search index is appended with
+ * PRERENDER_SEARCH. PRERENDER_STRIP marks the program as stripped of the
+ * doc strings. */
+int
+prerender_write(const struct yacap *c, const char *filename,
+        const char *symbol, int flags) {
+    int status;
+    char tmp[PATH_BUFFSIZE];
+    struct buff path;
+    struct search search;
+    bool searchable = (flags & PRERENDER_SEARCH) != 0;
+    struct generator g = {
+        .pages = 0,
+        .compress = (flags & PRERENDER_COMPRESS) != 0,
+    };
+
+    if (buff_alloc(&g.table, BODY_BUFFSIZE, c->allocator)) {
+        return -1;
+    }
+
+    g.file = fopen(filename, "w");
+    if (g.file == NULL) {
+        buff_free(&g.table);
+        return -1;
+    }
+
+    buff_init(&path, tmp, sizeof(tmp));
+    fprintf(g.file, "/* generated by yacap, do not edit */\n"
+            "#include <stddef.h>\n\n#include <yacap.h>\n\n\n");
+    status = _write_command(&g, c, (const struct yacap_command *)c, &path,
+            COMMAND_HASHBASIS);
+    fprintf(g.file, "static const struct yacap_prerendered _pages[] = {\n"
+            "%.*s};\n", (int)g.table.len, g.table.data);
+    buff_free(&g.table);
+
+    /* the help search index, sorted once here instead of on each search */
+    if ((status == 0) && searchable) {
+        fprintf(g.file, "\n\n");
+        status = search_build(&search, (const struct yacap_command *)c,
+                CMDSTACK_MAX(c), c->allocator);
+        if (status == 0) {
+            search_sort(&search);
+            status = search_write(g.file, &search, search_fingerprint(c));
+            search_dispose(&search);
+        }
+    }
+
+    fprintf(g.file, "\n\nconst struct yacap_prerender %s = {\n"
+            "    .pages = _pages,\n"
+            "    .count = %d,\n"
+            "    .stripped = %s,\n"
+            "    .search = %s,\n"
+            "};\n", symbol, g.pages,
+            (flags & PRERENDER_STRIP)? "true": "false",
+            searchable? "&_searchindex": "NULL");
+
+    if (fclose(g.file)) {
+        return -1;
+    }
+
+    return status;
+}
+
+
+/* returns the page, decompressed into a heap buffer when needed, which
+ * must be freed using prerender_page_free(). */
+const char *
+prerender_page(const struct yacap_prerendered *p,
+        const struct yacap_allocator *a) {
+    char *page;
+
+    if (p->compressedlen == 0) {
+        return p->help;
+    }
+
+    page = allocator_alloc(a, p->helplen);
+    if (page == NULL) {
+        return NULL;
+    }
+
+    if (lz_decompress(page, p->helplen, (const unsigned char *)p->help,
+                p->compressedlen) != p->helplen) {
+        allocator_free(a, page);
+        return NULL;
+    }
+
+    return page;
+}
+
+
+void
+prerender_page_free(const struct yacap_prerendered *p, const char *page,
+        const struct yacap_allocator *a) {
+    if (p->compressedlen && page) {
+        allocator_free(a, (char *)page);
+    }
+}
+
+
+#endif  // YACAP_USE_PRERENDER
@@ -0,0 +1,64 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef PRERENDER_H_
+#define PRERENDER_H_
+
+
+#include "include/yacap.h"
+#include "config.h"
+#include "cmdstack.h"
+
+
+#ifdef YACAP_USE_PRERENDER
+
+
+const struct yacap_prerendered *
+prerender_find(const struct yacap *c, struct cmdstack *s);
+
+
+enum prerenderflags {
+    PRERENDER_COMPRESS = 1,
+    PRERENDER_SEARCH = 2,
+    PRERENDER_STRIP = 4,
+};
+
+
+/* the program is built with yacap_prerender_help(... STRIP), so the doc
+ * strings are not there to render the missing pages at runtime */
+bool
+prerender_stripped(const struct yacap *c);
+
+
+int
+prerender_write(const struct yacap *c, const char *filename,
+        const char *symbol, int flags);
+
+
+const char *
+prerender_page(const struct yacap_prerendered *p,
+        const struct yacap_allocator *a);
+
+
+void
+prerender_page_free(const struct yacap_prerendered *p, const char *page,
+        const struct yacap_allocator *a);
+
+
+#endif  // YACAP_USE_PRERENDER
+#endif  // PRERENDER_H_
@@ -0,0 +1,67 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef PROBES_H_
+#define PROBES_H_
+
+
+#include "config.h"
+
+
+/* USDT probes of the yacap provider, compiled in with YACAP_USE_USDT. a
+ * probe costs a nop until a tracer attaches to it, see README.
+ *
+ * parse_entry(argc, argv)
+ * parse_return(status)
+ * token(status, argindex, offset, key)    key is 0 for the positionals
+ * eat_entry(key, name, value)             name is NULL for the positionals
+ * eat_return(key, status)
+ * command(depth, name)                    a sub-command is entered
+ * error(code, argindex, offset)           the parse is rejected
+ */
+#ifdef YACAP_USE_USDT
+
+#include <sys/sdt.h>
+
+#define PROBE_PARSE_ENTRY(argc, argv) DTRACE_PROBE2(yacap, parse_entry, \
+        argc, argv)
+#define PROBE_PARSE_RETURN(status) DTRACE_PROBE1(yacap, parse_return, status)
+#define PROBE_TOKEN(status, argindex, offset, key) DTRACE_PROBE4(yacap, \
+        token, status, argindex, offset, key)
+#define PROBE_EAT_ENTRY(key, name, value) DTRACE_PROBE3(yacap, eat_entry, \
+        key, name, value)
+#define PROBE_EAT_RETURN(key, status) DTRACE_PROBE2(yacap, eat_return, \
+        key, status)
+#define PROBE_COMMAND(depth, name) DTRACE_PROBE2(yacap, command, depth, name)
+#define PROBE_ERROR(code, argindex, offset) DTRACE_PROBE3(yacap, error, \
+        code, argindex, offset)
+
+#else
+
+#define PROBE_PARSE_ENTRY(argc, argv)
+#define PROBE_PARSE_RETURN(status)
+#define PROBE_TOKEN(status, argindex, offset, key)
+#define PROBE_EAT_ENTRY(key, name, value)
+#define PROBE_EAT_RETURN(key, status)
+#define PROBE_COMMAND(depth, name)
+#define PROBE_ERROR(code, argindex, offset)
+
+#endif
+
+
+#endif  // PROBES_H_
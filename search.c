@@ -0,0 +1,546 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "include/yacap.h"
+#include "config.h"
+#include "helpers.h"
+#include "allocator.h"
+#include "buff.h"
+#include "cmdstack.h"
+#include "command.h"
+#include "option.h"
+#include "sink.h"
+#include "state.h"
+#include "help.h"
+#include "search.h"
+
+
+#define PATH_BUFFSIZE 1024
+#define GROW(x, a, count, size) (((count) < (size))? 0: \
+        _grow((x)->allocator, (void **)&(a), &(size), sizeof(*(a))))
+
+
+static int
+_grow(const struct yacap_allocator *a, void **array, int *size,
+        size_t itemsize) {
+    void *new;
+    int newsize = *size? *size * 2: 256;
+
+    new = allocator_realloc(a, *array, *size * itemsize, newsize * itemsize);
+    if (new == NULL) {
+        return -1;
+    }
+
+    *array = new;
+    *size = newsize;
+    return 0;
+}
+
+
+/* shorter first on common prefix */
+static int
+_compare(const char *a, int alen, const char *b, int blen) {
+    int status = memcmp(a, b, MIN(alen, blen));
+
+    return status? status: alen - blen;
+}
+
+
+static int
+_wordcmp(const void *a, const void *b, void *pool) {
+    const struct yacap_searchword *x = a;
+    const struct yacap_searchword *y = b;
+    int status = _compare((char *)pool + x->text, x->len,
+            (char *)pool + y->text, y->len);
+
+    return status? status: x->doc - y->doc;
+}
+
+
+/* the next alphanumeric run of the text */
+static const char *
+_nextword(const char *text, int *len) {
+    const char *start;
+
+    if (text == NULL) {
+        return NULL;
+    }
+
+    while (*text && (!isalnum((unsigned char)*text))) {
+        text++;
+    }
+
+    if (*text == 0) {
+        return NULL;
+    }
+
+    for (start = text; isalnum((unsigned char)*text); text++) {
+    }
+
+    *len = text - start;
+    return start;
+}
+
+
+/* null terminated copy into the pool, returns the offset */
+static int
+_string(struct search *x, const char *s, size_t len) {
+    int offset = x->pool.len;
+
+    if (len == 0) {
+        return 0;
+    }
+
+    if ((buff_write(&x->pool, s, len) != len) ||
+            (buff_write(&x->pool, "", 1) != 1)) {
+        return -1;
+    }
+
+    return offset;
+}
+
+
+static int
+_index(struct search *x, const char *text, int doc) {
+    int i;
+    int len;
+    int offset;
+    struct yacap_searchword *w;
+
+    while ((text = _nextword(text, &len))) {
+        offset = x->pool.len;
+        if ((buff_write(&x->pool, text, len) != len) ||
+                GROW(x, x->words, x->index.wordscount, x->wordssize)) {
+            return -1;
+        }
+
+        for (i = 0; i < len; i++) {
+            x->pool.data[offset + i] = tolower(x->pool.data[offset + i]);
+        }
+
+        w = x->words + x->index.wordscount++;
+        w->text = offset;
+        w->len = len;
+        w->doc = doc;
+        text += len;
+    }
+
+    return 0;
+}
+
+
+static int
+_doc(struct search *x, int path, const struct yacap_option *opt) {
+    struct yacap_searchdoc *d;
+    int label = 0;
+    char tmp[YACAP_HELP_LINESIZE + 1];
+    struct buff b;
+
+    if (opt) {
+        buff_init(&b, tmp, sizeof(tmp));
+        option_format(&b, opt);
+        if ((label = _string(x, b.data, b.len)) == -1) {
+            return -1;
+        }
+    }
+
+    if (GROW(x, x->docs, x->index.docscount, x->docssize)) {
+        return -1;
+    }
+
+    d = x->docs + x->index.docscount;
+    d->path = path;
+    d->option = label;
+    d->end = x->index.docscount + 1;
+    return x->index.docscount++;
+}
+
+
+/* depth first, so the docs of a sub-tree are contiguous */
+static int
+_walk(struct search *x, struct buff *path, const struct yacap_command *cmd,
+        unsigned int depth, unsigned int maxdepth) {
+    struct optioniter it;
+    const struct yacap_option *opt;
+    struct yacap_command * const *sub;
+    size_t pathlen = path->len;
+    int offset;
+    int doc;
+    int d;
+
+    /* deeper commands are not reachable anyway */
+    if (depth >= maxdepth) {
+        return 0;
+    }
+
+    /* the name of the root is the argv[0] */
+    if (((offset = _string(x, path->data, path->len)) == -1) ||
+            ((doc = _doc(x, offset, NULL)) == -1) ||
+            (depth && _index(x, cmd->name, doc)) ||
+            _index(x, cmd->header, doc) || _index(x, cmd->footer, doc)) {
+        return -1;
+    }
+
+    optioniter_init(&it, cmd);
+    while ((opt = optioniter_next(&it))) {
+        /* group titles */
+        if (opt->key == 0) {
+            continue;
+        }
+
+        d = _doc(x, offset, opt);
+        if ((d == -1) || _index(x, opt->name, d) || _index(x, opt->arg, d)
+                || _index(x, opt->help, d)) {
+            return -1;
+        }
+    }
+
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        if ((buff_printf(path, "%s%s", pathlen? " ": "", (*sub)->name) == -1)
+                || _walk(x, path, *sub, depth + 1, maxdepth)) {
+            return -1;
+        }
+        path->len = pathlen;
+    }
+
+    x->docs[doc].end = x->index.docscount;
+    return 0;
+}
+
+
+int
+search_build(struct search *x, const struct yacap_command *root,
+        unsigned int maxdepth, const struct yacap_allocator *a) {
+    struct buff path;
+    int status;
+
+    memset(x, 0, sizeof(struct search));
+    x->allocator = a;
+    if (buff_alloc(&x->pool, 4096, a) || buff_alloc(&path, PATH_BUFFSIZE, a)) {
+        buff_free(&x->pool);
+        return -1;
+    }
+
+    /* the offset 0 is an empty string */
+    buff_write(&x->pool, "", 1);
+    status = _walk(x, &path, root, 0, maxdepth);
+    buff_free(&path);
+    if (status) {
+        search_dispose(x);
+        return -1;
+    }
+
+    x->index.pool = x->pool.data;
+    x->index.docs = x->docs;
+    x->index.words = x->words;
+    return 0;
+}
+
+
+/* sorting is left to the build-time generator, at runtime the index is
+ * queried once or a few times so it's cheaper to scan all the words. */
+void
+search_sort(struct search *x) {
+    qsort_r(x->words, x->index.wordscount, sizeof(struct yacap_searchword),
+            _wordcmp, x->pool.data);
+    x->index.sorted = true;
+}
+
+
+void
+search_dispose(struct search *x) {
+    allocator_free(x->allocator, x->docs);
+    allocator_free(x->allocator, x->words);
+    buff_free(&x->pool);
+    memset(x, 0, sizeof(struct search));
+}
+
+
+static uint64_t
+_fingerprint(const struct yacap *c, const struct yacap_command *cmd,
+        uint64_t path, unsigned int depth, uint64_t h) {
+    struct yacap_command * const *sub;
+
+    /* as deep as the index is built */
+    if (depth >= CMDSTACK_MAX(c)) {
+        return h;
+    }
+
+    h = (h ^ command_fingerprint(c, cmd, path, depth > 0)) *
+        COMMAND_HASHPRIME;
+    for (sub = cmd->commands; sub && *sub; sub++) {
+        h = _fingerprint(c, *sub, command_hash(path, (*sub)->name),
+                depth + 1, h);
+    }
+
+    return h;
+}
+
+
+uint64_t
+search_fingerprint(const struct yacap *c) {
+    return _fingerprint(c, (const struct yacap_command *)c,
+            COMMAND_HASHBASIS, 0, COMMAND_HASHBASIS);
+}
+
+
+/* write the index as a C source named _searchindex, see prerender.c */
+int
+search_write(FILE *f, const struct search *x, uint64_t fingerprint) {
+    int i;
+    unsigned char c;
+    const struct yacap_searchdoc *d;
+    const struct yacap_searchword *w;
+
+    fprintf(f, "static const char _searchpool[] =\n        \"");
+    for (i = 0; i < x->pool.len; i++) {
+        c = x->pool.data[i];
+        if ((c < 32) || (c > 126) || (c == '"') || (c == '\\') ||
+                (c == '?')) {
+            fprintf(f, "\\%03o", c);
+        }
+        else {
+            fputc(c, f);
+        }
+
+        if (((i + 1) % 64) == 0) {
+            fputs("\"\n        \"", f);
+        }
+    }
+
+    fprintf(f, "\";\n\n\nstatic const struct yacap_searchdoc _searchdocs[] "
+            "= {\n");
+    for (i = 0; i < x->index.docscount; i++) {
+        d = x->docs + i;
+        fprintf(f, "    {%d, %d, %d},\n", d->path, d->option, d->end);
+    }
+
+    /* a sentinel, so the array is never empty */
+    fprintf(f, "    {0}\n};\n\n\nstatic const struct yacap_searchword "
+            "_searchwords[] = {\n");
+    for (i = 0; i < x->index.wordscount; i++) {
+        w = x->words + i;
+        fprintf(f, "    {%d, %d, %d},\n", w->text, w->len, w->doc);
+    }
+
+    fprintf(f, "    {0}\n};\n\n\n"
+            "static const struct yacap_searchindex _searchindex = {\n"
+            "    .pool = _searchpool,\n"
+            "    .docs = _searchdocs,\n"
+            "    .docscount = %d,\n"
+            "    .words = _searchwords,\n"
+            "    .wordscount = %d,\n"
+            "    .sorted = %s,\n"
+            "    .fingerprint = 0x%016" PRIx64 "ULL,\n"
+            "};\n", x->index.docscount, x->index.wordscount,
+            x->index.sorted? "true": "false", fingerprint);
+    return ferror(f)? -1: 0;
+}
+
+
+/* the first word not less than the keyword, in a sorted index the words
+ * having the keyword as prefix are next to each other from there. */
+static int
+_lowerbound(const struct yacap_searchindex *x, const char *keyword,
+        int len) {
+    int lo = 0;
+    int hi = x->wordscount;
+    int mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (_compare(x->pool + x->words[mid].text, x->words[mid].len,
+                    keyword, len) < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+
+/* writes a line per command or option of the path's sub-tree having a
+ * word prefixed by each of the keywords. returns the number of hits. */
+int
+search_query(const struct yacap_searchindex *x, struct buff *out,
+        const char *prog, const char *path, const char *keywords) {
+    const struct yacap_searchword *w;
+    const struct yacap_searchdoc *d;
+    const char *keyword;
+    char *lower;
+    int *matches;
+    int start;
+    int len;
+    int i;
+    int k = 0;
+    int hits = 0;
+
+    for (start = 0; start < x->docscount; start++) {
+        d = x->docs + start;
+        if ((d->option == 0) && STREQ(x->pool + d->path, path)) {
+            break;
+        }
+    }
+
+    if (start == x->docscount) {
+        return 0;
+    }
+
+    /* the temporaries come from the allocator of the output */
+    len = strlen(keywords);
+    lower = allocator_alloc(out->allocator, len + 1);
+    matches = allocator_calloc(out->allocator, x->docscount, sizeof(int));
+    if ((lower == NULL) || (matches == NULL)) {
+        allocator_free(out->allocator, lower);
+        allocator_free(out->allocator, matches);
+        return -1;
+    }
+
+    for (i = 0; i <= len; i++) {
+        lower[i] = tolower(keywords[i]);
+    }
+
+    /* a doc survives a keyword only if it has matched all the previous
+     * ones */
+    keyword = lower;
+    while ((keyword = _nextword(keyword, &len))) {
+        for (i = x->sorted? _lowerbound(x, keyword, len): 0;
+                i < x->wordscount; i++) {
+            w = x->words + i;
+            if ((w->len < len) || memcmp(x->pool + w->text, keyword, len)) {
+                if (x->sorted) {
+                    break;
+                }
+                continue;
+            }
+
+            if (matches[w->doc] == k) {
+                matches[w->doc] = k + 1;
+            }
+        }
+        keyword += len;
+        k++;
+    }
+
+    for (i = start; k && (i < x->docs[start].end); i++) {
+        if (matches[i] != k) {
+            continue;
+        }
+
+        d = x->docs + i;
+        buff_printf(out, "%s%s%s%s%s\n", prog, d->path? " ": "",
+                x->pool + d->path, d->option? " ": "", x->pool + d->option);
+        hits++;
+    }
+
+    allocator_free(out->allocator, lower);
+    allocator_free(out->allocator, matches);
+    return hits;
+}
+
+
+int
+yacap_helpsearch_render(const struct yacap *c, const char *keywords,
+        struct yacap_sink *sink) {
+    unsigned int i;
+    int status;
+    struct buff path;
+    struct buff b;
+    struct yacap_state *state;
+    const struct yacap_searchindex *index = NULL;
+
+    if ((c == NULL) || (c->state == NULL) || (sink == NULL) ||
+            (keywords == NULL)) {
+        return -1;
+    }
+
+    /* the one of yacap_prerender_help(... SEARCH), unless the tree is
+     * changed since */
+    if (c->prerender && c->prerender->search &&
+            (c->prerender->search->fingerprint == search_fingerprint(c))) {
+        index = c->prerender->search;
+    }
+
+    /* built once, the index lives as long as the state */
+    state = c->state;
+    if ((index == NULL) && (state->search == NULL)) {
+        state->search = allocator_alloc(STATE_ALLOCATOR(state),
+                sizeof(struct search));
+        if (state->search == NULL) {
+            return -1;
+        }
+
+        if (search_build(state->search, (const struct yacap_command *)c,
+                    CMDSTACK_MAX(c), STATE_ALLOCATOR(state))) {
+            allocator_free(STATE_ALLOCATOR(state), state->search);
+            state->search = NULL;
+            return -1;
+        }
+    }
+
+    if (index == NULL) {
+        index = &state->search->index;
+    }
+
+    /* the root name is argv[0], so it's not a part of the path */
+    help_scratch(&path, c);
+    buff_printf(&path, "%s", "");
+    for (i = 1; i < state->cmdstack.len; i++) {
+        buff_printf(&path, "%s%s", (i > 1)? " ": "",
+                state->cmdstack.frames[i].command->name);
+    }
+
+    if ((path.data == NULL) ||
+            buff_alloc(&b, 1024, STATE_ALLOCATOR(state))) {
+        help_scratchfree(&path, c);
+        return -1;
+    }
+
+    status = search_query(index, &b, state->cmdstack.frames[0].name,
+            path.data, keywords);
+    if (status > 0) {
+        status = sink_write(sink, b.data, b.len) == -1? -1: status;
+    }
+
+    buff_free(&b);
+    help_scratchfree(&path, c);
+    return status;
+}
+
+
+int
+yacap_helpsearch_print(const struct yacap *c, const char *keywords) {
+    struct yacap_sink sink = SINK_FD(STDOUT_FILENO, c);
+    int status;
+
+    status = yacap_helpsearch_render(c, keywords, &sink);
+    if (sink_drain(&sink)) {
+        status = -1;
+    }
+    yacap_sink_dispose(&sink);
+    return status;
+}
@@ -0,0 +1,70 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef SEARCH_H_
+#define SEARCH_H_
+
+
+#include <stdio.h>
+
+#include "include/yacap.h"
+#include "buff.h"
+
+
+/* inverted index of a command tree, built on the first search unless the
+ * program is linked with one generated at build time. */
+struct search {
+    struct yacap_searchindex index;
+
+    struct yacap_searchdoc *docs;
+    int docssize;
+    struct yacap_searchword *words;
+    int wordssize;
+    struct buff pool;
+    const struct yacap_allocator *allocator;
+};
+
+
+int
+search_build(struct search *x, const struct yacap_command *root,
+        unsigned int maxdepth, const struct yacap_allocator *a);
+
+
+void
+search_sort(struct search *x);
+
+
+void
+search_dispose(struct search *x);
+
+
+/* of the tree the index is built from, see command_fingerprint() */
+uint64_t
+search_fingerprint(const struct yacap *c);
+
+
+int
+search_write(FILE *f, const struct search *x, uint64_t fingerprint);
+
+
+int
+search_query(const struct yacap_searchindex *x, struct buff *out,
+        const char *prog, const char *path, const char *keywords);
+
+
+#endif  // SEARCH_H_
@@ -0,0 +1,247 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+
+#include "include/yacap.h"
+#include "helpers.h"
+#include "allocator.h"
+#include "sink.h"
+
+
+static int
+_pending_append(struct yacap_sink *s, struct iovec *iov, int iovcnt) {
+    int i;
+    size_t len = 0;
+    char *new;
+
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].iov_len;
+    }
+
+    new = allocator_realloc(s->allocator, s->pending, s->pendinglen,
+            s->pendinglen + len);
+    if (new == NULL) {
+        return -1;
+    }
+
+    s->pending = new;
+    for (i = 0; i < iovcnt; i++) {
+        memcpy(s->pending + s->pendinglen, iov[i].iov_base, iov[i].iov_len);
+        s->pendinglen += iov[i].iov_len;
+    }
+
+    return 0;
+}
+
+
+/* the bytes the fd or the callback accepted, 0 when it's not ready */
+static ssize_t
+_write(struct yacap_sink *s, const struct iovec *iov, int iovcnt) {
+    ssize_t status;
+
+    /* one vector at a time, the callback takes a single buffer */
+    if (s->type == YACAP_SINK_CALLBACK) {
+        return s->callback.write(iov->iov_base, iov->iov_len,
+                s->callback.userptr);
+    }
+
+    do {
+        status = writev(s->fd, iov, iovcnt);
+    } while ((status == -1) && (errno == EINTR));
+
+    if ((status == -1) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+        return 0;
+    }
+
+    return status;
+}
+
+
+/* write all vectors, the iov is consumed. the rest is kept in the sink's
+ * pending buffer when the non-blocking fd or the callback is not ready. */
+static ssize_t
+_pending_writev(struct yacap_sink *s, struct iovec *iov, int iovcnt) {
+    int i;
+    ssize_t total = 0;
+    ssize_t status = 0;
+
+    for (i = 0; i < iovcnt; i++) {
+        total += iov[i].iov_len;
+    }
+
+    /* keep the order, append behind the previous leftovers */
+    if (s->pendinglen) {
+        if (_pending_append(s, iov, iovcnt)) {
+            return -1;
+        }
+
+        return yacap_sink_flush(s) == -1? -1: total;
+    }
+
+    for (;;) {
+        /* skip the written and the empty vectors */
+        while (iovcnt && (status >= iov->iov_len)) {
+            status -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        if (iovcnt == 0) {
+            break;
+        }
+
+        iov->iov_base = (char *)iov->iov_base + status;
+        iov->iov_len -= status;
+
+        status = _write(s, iov, iovcnt);
+        if (status < 0) {
+            return -1;
+        }
+
+        if (status == 0) {
+            return _pending_append(s, iov, iovcnt)? -1: total;
+        }
+    }
+
+    return total;
+}
+
+
+ssize_t
+sink_writev(struct yacap_sink *s, struct iovec *iov, int iovcnt) {
+    int i;
+    size_t len;
+    ssize_t total = 0;
+
+    if ((s->type == YACAP_SINK_FD) || (s->type == YACAP_SINK_CALLBACK)) {
+        return _pending_writev(s, iov, iovcnt);
+    }
+
+    for (i = 0; i < iovcnt; i++) {
+        len = iov[i].iov_len;
+
+        switch (s->type) {
+            case YACAP_SINK_FILE:
+                if (len && (fwrite(iov[i].iov_base, len, 1, s->file) != 1)) {
+                    return -1;
+                }
+                break;
+
+            case YACAP_SINK_MEMORY:
+                len = MIN(len, s->memory.size - s->memory.len);
+                memcpy(s->memory.data + s->memory.len, iov[i].iov_base, len);
+                s->memory.len += len;
+                break;
+
+            default:
+                return -1;
+        }
+
+        total += len;
+    }
+
+    return total;
+}
+
+
+ssize_t
+sink_write(struct yacap_sink *s, const char *data, size_t len) {
+    struct iovec iov = {(void *)data, len};
+
+    return sink_writev(s, &iov, 1);
+}
+
+
+/* retry the bytes a non-blocking fd or the callback did not accept,
+ * returns the number of bytes still pending or -1 on error. */
+ssize_t
+yacap_sink_flush(struct yacap_sink *s) {
+    ssize_t status;
+    size_t written = 0;
+    struct iovec iov;
+
+    if ((s == NULL) || (s->pendinglen == 0)) {
+        return 0;
+    }
+
+    while (written < s->pendinglen) {
+        iov.iov_base = s->pending + written;
+        iov.iov_len = s->pendinglen - written;
+        status = _write(s, &iov, 1);
+        if (status < 0) {
+            return -1;
+        }
+
+        if (status == 0) {
+            break;
+        }
+
+        written += status;
+    }
+
+    s->pendinglen -= written;
+    if (s->pendinglen) {
+        memmove(s->pending, s->pending + written, s->pendinglen);
+    }
+    else {
+        allocator_free(s->allocator, s->pending);
+        s->pending = NULL;
+    }
+
+    return s->pendinglen;
+}
+
+
+/* waits for the fd until the pending bytes are written, for the sinks which
+ * are disposed right after the rendering. returns -1 when they can't be. */
+int
+sink_drain(struct yacap_sink *s) {
+    ssize_t pending;
+    struct pollfd pfd = {.fd = s->fd, .events = POLLOUT};
+
+    while ((pending = yacap_sink_flush(s)) > 0) {
+        /* there is nothing to wait for with a callback */
+        if (s->type != YACAP_SINK_FD) {
+            return -1;
+        }
+
+        if ((poll(&pfd, 1, -1) == -1) && (errno != EINTR)) {
+            return -1;
+        }
+    }
+
+    return pending;
+}
+
+
+void
+yacap_sink_dispose(struct yacap_sink *s) {
+    if (s == NULL) {
+        return;
+    }
+
+    allocator_free(s->allocator, s->pending);
+
+    s->pending = NULL;
+    s->pendinglen = 0;
+}
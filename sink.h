@@ -0,0 +1,45 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef SINK_H_
+#define SINK_H_
+
+
+#include <sys/uio.h>
+
+#include "include/yacap.h"
+
+
+/* a fd sink allocating with the allocator of the struct yacap c */
+#define SINK_FD(f, c) {.type = YACAP_SINK_FD, .fd = (f), \
+    .allocator = (c)? (c)->allocator: NULL}
+
+
+ssize_t
+sink_writev(struct yacap_sink *s, struct iovec *iov, int iovcnt);
+
+
+ssize_t
+sink_write(struct yacap_sink *s, const char *data, size_t len);
+
+
+int
+sink_drain(struct yacap_sink *s);
+
+
+#endif  // SINK_H_
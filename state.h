@@ -20,16 +20,68 @@
 #define STATE_H_
 
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "include/yacap.h"
+#include "config.h"
+#include "allocator.h"
+#include "arghint.h"
+#include "buff.h"
 #include "cmdstack.h"
 #include "optiondb.h"
+#include "pathcheck.h"
+#include "search.h"
+#include "suggest.h"
+#include "trace.h"
 
 
 struct yacap_state {
     struct cmdstack cmdstack;
     struct optiondb optiondb;
     size_t positionals;
+    struct pathcheck pathcheck;
+    struct yacap_error error;
+
+    /* built on the first help search, see search.c */
+    struct search *search;
+
+    /* when YACAP_TRACE is set, see trace.h */
+    struct trace *trace;
+
+    /* see yacap_stats() */
+    struct yacap_stats stats;
+
+    /* everything the parse and the renders allocate goes through it, it
+     * counts into the stats until yacap_parse() returns */
+    struct allocator_counter counter;
+
+    /* diagnostics are composed here and written at once, they move to the
+     * heap when they don't fit */
+    struct buff diag;
+
+    /* see help_scratch() */
+    bool scratchbusy;
+
+    /* the buffers below are not cleared with the rest of the state */
+    char diagbuff[YACAP_DIAG_BUFFSIZE];
+
+    /* the large locals of the parse and the renders, kept off the stack.
+     * they are never in use at the same time */
+    union {
+        struct suggest suggest;
+        struct arghint_nfa nfa;
+        char render[YACAP_DIAG_BUFFSIZE];
+    } scratch;
 };
 
 
+/* the allocator of the parse and the renders */
+#define STATE_ALLOCATOR(s) (&(s)->counter.allocator)
+
+
+/* the part of the state yacap_parse() clears */
+#define STATE_CLEARSIZE offsetof(struct yacap_state, diagbuff)
+
+
 #endif  // STATE_H_
@@ -0,0 +1,125 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "helpers.h"
+#include "suggest.h"
+
+
+/* candidates farther than a quarter of the pattern are noise */
+#define THRESHOLD(len) MIN((len) - 1, (len) / 4 + 1)
+
+
+void
+suggest_init(struct suggest *s, const char *pattern, int len) {
+    int i;
+    int slots = 1;
+    unsigned char c;
+
+    s->best = NULL;
+    s->pattern = pattern;
+    s->len = len;
+    if ((len <= 0) || (len > SUGGEST_PATTERN_MAX)) {
+        s->max = -1;
+        return;
+    }
+
+    s->max = THRESHOLD(len);
+    memset(s->slot, 0, sizeof(s->slot));
+    s->peq[0] = 0;
+    for (i = 0; i < len; i++) {
+        c = pattern[i];
+        if (s->slot[c] == 0) {
+            s->slot[c] = slots;
+            s->peq[slots++] = 0;
+        }
+        s->peq[s->slot[c]] |= (uint64_t)1 << i;
+    }
+}
+
+
+/* Levenshtein distance between the pattern and the text, using the
+ * bit-parallel algorithm of Myers as formulated by Hyyrö: one column of the
+ * dynamic programming matrix per text character, in a handful of word
+ * operations. returns max + 1 as soon as the distance is known to exceed
+ * max. */
+int
+suggest_distance(const struct suggest *s, const char *text, int len,
+        int max) {
+    int i;
+    int score = s->len;
+    uint64_t pv = ~(uint64_t)0;
+    uint64_t mv = 0;
+    uint64_t last = (uint64_t)1 << (s->len - 1);
+    uint64_t eq;
+    uint64_t xv;
+    uint64_t xh;
+    uint64_t ph;
+    uint64_t mh;
+
+    if ((s->max < 0) || (abs(len - s->len) > max)) {
+        return max + 1;
+    }
+
+    for (i = 0; i < len; i++) {
+        eq = s->peq[s->slot[(unsigned char)text[i]]];
+        xv = eq | mv;
+        xh = (((eq & pv) + pv) ^ pv) | eq;
+        ph = mv | ~(xh | pv);
+        mh = pv & xh;
+        if (ph & last) {
+            score++;
+        }
+        else if (mh & last) {
+            score--;
+        }
+
+        /* the remaining characters can lower the score by one each */
+        if ((score - (len - i - 1)) > max) {
+            return max + 1;
+        }
+
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+
+    return score;
+}
+
+
+void
+suggest_feed(struct suggest *s, const char *candidate) {
+    int distance;
+
+    if ((s->max < 0) || (candidate == NULL)) {
+        return;
+    }
+
+    distance = suggest_distance(s, candidate, strlen(candidate), s->max);
+    if (distance > s->max) {
+        return;
+    }
+
+    /* later candidates have to be strictly nearer */
+    s->best = candidate;
+    s->max = distance - 1;
+}
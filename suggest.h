@@ -0,0 +1,59 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef SUGGEST_H_
+#define SUGGEST_H_
+
+
+#include <stdint.h>
+
+
+/* patterns longer than this are never suggested for */
+#define SUGGEST_PATTERN_MAX 64
+
+
+/* nearest match search, the candidates are fed one by one and the first one
+ * with the smallest edit distance wins. */
+struct suggest {
+    /* the pattern positions of each byte, the bytes missing from the
+     * pattern are mapped to the empty peq[0] */
+    uint8_t slot[256];
+    uint64_t peq[SUGGEST_PATTERN_MAX + 1];
+    const char *pattern;
+    int len;
+
+    /* the distance a candidate has to beat, -1 disables the search */
+    int max;
+    const char *best;
+};
+
+
+void
+suggest_init(struct suggest *s, const char *pattern, int len);
+
+
+int
+suggest_distance(const struct suggest *s, const char *text, int len,
+        int max);
+
+
+void
+suggest_feed(struct suggest *s, const char *candidate);
+
+
+#endif  // SUGGEST_H_
@@ -115,7 +115,7 @@ yacap_parse_string(struct yacap *c, const char * line,
         const struct yacap_command **command) {
     char *argv[256];
     int argc = 0;
-    char delim[1] = {' '};
+    char delim[] = " ";
     char *needle;
     char *saveptr = NULL;
     static char buff[BUFFSIZE + 1];
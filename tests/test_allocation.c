@@ -0,0 +1,491 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <malloc.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "helpers.h"
+
+
+/* allocation calls and the peak of the heap during each yacap_parse(),
+ * yacap_help_print() and yacap_dispose(), within a budget per scenario.
+ * the libc allocator is interposed by this executable, the sanitizers
+ * interpose it already, so the suite is skipped under them. */
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define ALLOCATION_SKIP
+#endif
+
+
+#ifndef ALLOCATION_SKIP
+
+
+struct allocstats {
+    unsigned int mallocs;
+    unsigned int reallocs;
+    unsigned int frees;
+
+    /* blocks and bytes allocated but not freed */
+    int blocks;
+    long current;
+    long peak;
+};
+
+
+static bool _counting;
+static struct allocstats _stats;
+
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+
+static void
+_grow(long bytes) {
+    _stats.current += bytes;
+    if (_stats.current > _stats.peak) {
+        _stats.peak = _stats.current;
+    }
+}
+
+
+void *
+malloc(size_t size) {
+    void *p = __libc_malloc(size);
+
+    if (_counting && p) {
+        _stats.mallocs++;
+        _stats.blocks++;
+        _grow(malloc_usable_size(p));
+    }
+    return p;
+}
+
+
+void *
+calloc(size_t count, size_t size) {
+    void *p = __libc_calloc(count, size);
+
+    if (_counting && p) {
+        _stats.mallocs++;
+        _stats.blocks++;
+        _grow(malloc_usable_size(p));
+    }
+    return p;
+}
+
+
+void *
+realloc(void *ptr, size_t size) {
+    long old = ptr? malloc_usable_size(ptr): 0;
+    void *p = __libc_realloc(ptr, size);
+
+    if (_counting && p) {
+        _stats.reallocs++;
+        _stats.blocks += ptr? 0: 1;
+        _grow((long)malloc_usable_size(p) - old);
+    }
+    return p;
+}
+
+
+void
+free(void *ptr) {
+    if (_counting && ptr) {
+        _stats.frees++;
+        _stats.blocks--;
+        _stats.current -= malloc_usable_size(ptr);
+    }
+    __libc_free(ptr);
+}
+
+
+/* the heap is measured relative to the start */
+static void
+_begin() {
+    memset(&_stats, 0, sizeof(_stats));
+    _counting = true;
+}
+
+
+static void
+_end(struct allocstats *s) {
+    _counting = false;
+    *s = _stats;
+#ifdef ALLOCATION_PRINT
+    printf("mallocs=%u reallocs=%u frees=%u blocks=%d current=%ld "
+            "peak=%ld\n", s->mallocs, s->reallocs, s->frees, s->blocks,
+            s->current, s->peak);
+#endif
+}
+
+
+#define BUDGET(s, m, r, p) do { \
+    istrue((s).mallocs <= (m)); \
+    istrue((s).reallocs <= (r)); \
+    istrue((s).peak <= (p)); \
+} while (0)
+
+
+/* everything the parse allocated is freed by the dispose */
+#define BALANCED(parse, dispose) do { \
+    eqint(0, (parse).blocks + (dispose).blocks); \
+    eqint(0, (parse).current + (dispose).current); \
+} while (0)
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap_option options[] = {
+    {"foo", 'f', NULL, 0, "Foo flag"},
+    {"bar", 'b', "BAR", 0, "Bar option with value"},
+    {"baz", 'z', NULL, YACAP_OPTION_MULTIPLE, "Baz flag"},
+    {NULL}
+};
+
+
+static void
+_parse(struct yacap *c, int argc, const char **argv, struct allocstats *parse,
+        struct allocstats *dispose) {
+    _begin();
+    eqint(YACAP_OK, yacap_parse(c, argc, argv, NULL));
+    _end(parse);
+
+    _begin();
+    yacap_dispose(c);
+    _end(dispose);
+}
+
+
+static void
+test_allocation_parse() {
+    struct allocstats parse;
+    struct allocstats dispose;
+    const char *argv[] = {"foo", "-f", "--bar=qux", "-zz", "thud"};
+    struct yacap yacap = {
+        .args = "[THUD]",
+        .options = options,
+        .eat = _eater,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    /* the state with its scratch, the optiondb, the tokenizer and the
+     * command stack */
+    _parse(&yacap, 5, argv, &parse, &dispose);
+    BUDGET(parse, 4, 0, 3072);
+    eqint(0, dispose.mallocs);
+    eqint(0, dispose.reallocs);
+    BALANCED(parse, dispose);
+}
+
+
+/* the allocations do not depend on the argv length */
+static void
+test_allocation_argc() {
+    int i;
+    struct allocstats few;
+    struct allocstats many;
+    struct allocstats dispose;
+    const char *argv[1000] = {"foo"};
+    struct yacap yacap = {
+        .args = "...",
+        .options = options,
+        .eat = _eater,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    for (i = 1; i < 1000; i++) {
+        argv[i] = (i % 3)? "-zzz": "positional";
+    }
+
+    _parse(&yacap, 10, argv, &few, &dispose);
+    _parse(&yacap, 1000, argv, &many, &dispose);
+    BALANCED(many, dispose);
+    eqint(few.mallocs, many.mallocs);
+    eqint(few.reallocs, many.reallocs);
+    eqint(few.peak, many.peak);
+}
+
+
+static struct yacap_option qux_options[] = {
+    {"qux", 'x', NULL, 0, "Qux flag"},
+    {NULL}
+};
+
+
+static struct yacap_command quux = {
+    .name = "quux",
+    .args = "[FILE]",
+    .options = qux_options,
+    .eat = _eater,
+};
+
+
+static struct yacap_command qux = {
+    .name = "qux",
+    .options = qux_options + 1,
+    .commands = (struct yacap_command *const[]) {
+        &quux,
+        NULL
+    },
+};
+
+
+static void
+test_allocation_subcommands() {
+    struct allocstats parse;
+    struct allocstats dispose;
+    const char *argv[] = {"foo", "-f", "qux", "quux", "-x", "file"};
+    struct yacap yacap = {
+        .options = options,
+        .eat = _eater,
+        .flags = YACAP_NO_CLOG,
+        .commands = (struct yacap_command *const[]) {
+            &qux,
+            NULL
+        },
+    };
+
+    _parse(&yacap, 6, argv, &parse, &dispose);
+    BUDGET(parse, 4, 0, 3072);
+    BALANCED(parse, dispose);
+}
+
+
+#define TABLE_OPTIONS(O, t) \
+    O(t, foo, "foo", 'f', "", 0, "Foo flag") \
+    O(t, bar, "bar", 'b', "BAR", 0, "Bar option with value")
+
+
+YACAP_OPTIONTABLE(table_options, TABLE_OPTIONS);
+
+
+static void
+test_allocation_optiontable() {
+    struct allocstats parse;
+    struct allocstats dispose;
+    const char *argv[] = {"foo", "-f", "--bar=baz"};
+    struct yacap yacap = {
+        .optiontable = &table_options,
+        .eat = _eater,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    /* the matched entries are unpacked within the optiondb */
+    _parse(&yacap, 3, argv, &parse, &dispose);
+    BUDGET(parse, 4, 0, 3072);
+    BALANCED(parse, dispose);
+}
+
+
+/* options beyond the initial optiondb size grow it */
+static void
+test_allocation_optiondb() {
+    int i;
+    char names[40][8];
+    struct yacap_option many[41];
+    struct allocstats parse;
+    struct allocstats dispose;
+    const char *argv[] = {"foo"};
+    struct yacap yacap = {
+        .options = many,
+        .eat = _eater,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    for (i = 0; i < 40; i++) {
+        snprintf(names[i], sizeof(names[i]), "opt%d", i);
+        memcpy(&many[i], &(struct yacap_option) {names[i], 1000 + i, NULL,
+                0, NULL}, sizeof(struct yacap_option));
+    }
+    memset(&many[40], 0, sizeof(struct yacap_option));
+
+    /* 8 more options per extend */
+    _parse(&yacap, 1, argv, &parse, &dispose);
+    BUDGET(parse, 4, 5, 4096);
+    BALANCED(parse, dispose);
+}
+
+
+static void
+test_allocation_help() {
+    int fd;
+    int stdoutfd;
+    struct allocstats help;
+    struct allocstats dispose;
+    const char *argv[] = {"foo"};
+    struct yacap yacap = {
+        .args = "[THUD]",
+        .header = LOREM,
+        .footer = LOREM,
+        .options = options,
+        .eat = _eater,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    eqint(YACAP_OK, yacap_parse(&yacap, 1, argv, NULL));
+
+    fflush(stdout);
+    stdoutfd = dup(STDOUT_FILENO);
+    fd = open("/dev/null", O_WRONLY);
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+
+    _begin();
+    yacap_help_print(&yacap);
+    yacap_usage_print(&yacap);
+    _end(&help);
+
+    dup2(stdoutfd, STDOUT_FILENO);
+    close(stdoutfd);
+
+    /* a single buffer, freed before returning */
+    BUDGET(help, 1, 0, 4096 + 64);
+    eqint(0, help.blocks);
+    eqint(0, help.current);
+
+    _begin();
+    yacap_dispose(&yacap);
+    _end(&dispose);
+    eqint(0, dispose.mallocs);
+}
+
+
+/* a bump allocator over a static arena, released at once by the caller */
+struct arena {
+    char data[65536];
+    size_t len;
+    int allocs;
+    int frees;
+};
+
+
+static void *
+_arena_alloc(size_t size, struct arena *a) {
+    void *p;
+
+    size = (size + 15) & ~15;
+    if ((a->len + size) > sizeof(a->data)) {
+        return NULL;
+    }
+
+    p = a->data + a->len;
+    a->len += size;
+    a->allocs++;
+    return p;
+}
+
+
+static void *
+_arena_realloc(void *ptr, size_t oldsize, size_t size, struct arena *a) {
+    void *p = _arena_alloc(size, a);
+
+    if (p) {
+        memcpy(p, ptr, oldsize);
+        a->frees++;
+    }
+    return p;
+}
+
+
+static void
+_arena_free(void *ptr, struct arena *a) {
+    a->frees++;
+}
+
+
+static void
+test_allocation_allocator() {
+    int fd;
+    int stdoutfd;
+    struct allocstats stats;
+    struct arena arena = {.len = 0};
+    struct yacap_allocator allocator = {
+        .alloc = (void *(*)(size_t, void *))_arena_alloc,
+        .realloc = (void *(*)(void *, size_t, size_t, void *))_arena_realloc,
+        .free = (void (*)(void *, void *))_arena_free,
+        .userptr = &arena,
+    };
+    const char *argv[] = {"foo", "-f", "--bar=baz", "qux", "quux", "-x",
+        "file"};
+    struct yacap yacap = {
+        .optiontable = &table_options,
+        .eat = _eater,
+        .flags = YACAP_NO_CLOG,
+        .commands = (struct yacap_command *const[]) {
+            &qux,
+            NULL
+        },
+        .allocator = &allocator,
+    };
+
+    fflush(stdout);
+    stdoutfd = dup(STDOUT_FILENO);
+    fd = open("/dev/null", O_WRONLY);
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+
+    /* nothing reaches the libc allocator */
+    _begin();
+    eqint(YACAP_OK, yacap_parse(&yacap, 7, argv, NULL));
+    yacap_help_print(&yacap);
+    yacap_usage_print(&yacap);
+    yacap_helpsearch_print(&yacap, "qux");
+    yacap_dispose(&yacap);
+    _end(&stats);
+
+    dup2(stdoutfd, STDOUT_FILENO);
+    close(stdoutfd);
+
+    eqint(0, stats.mallocs);
+    eqint(0, stats.reallocs);
+    eqint(0, stats.frees);
+    istrue(arena.allocs > 0);
+    eqint(arena.allocs, arena.frees);
+}
+
+
+#endif
+
+
+int
+main() {
+#ifdef ALLOCATION_SKIP
+    printf("skipped under the sanitizers\n");
+#else
+    test_allocation_parse();
+    test_allocation_argc();
+    test_allocation_subcommands();
+    test_allocation_optiontable();
+    test_allocation_optiondb();
+    test_allocation_help();
+    test_allocation_allocator();
+#endif
+    return EXIT_SUCCESS;
+}
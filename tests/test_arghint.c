@@ -24,127 +24,305 @@
 #include "arghint.c"
 
 
+static int
+_validate(size_t count, const char *args) {
+    struct arghint h;
+
+    if (arghint_compile(&h, args)) {
+        return -2;
+    }
+
+    return arghint_validate(&h, count);
+}
+
+
 void
 test_arghint_validate() {
-    eqint(0, arghint_validate(0, arghint_parse(NULL)));
-    eqint(-1, arghint_validate(1, arghint_parse(NULL)));
-    eqint(-1, arghint_validate(2, arghint_parse(NULL)));
-
-    eqint(0, arghint_validate(0, arghint_parse("")));
-    eqint(-1, arghint_validate(1, arghint_parse("")));
-    eqint(-1, arghint_validate(2, arghint_parse("")));
-
-    eqint(-1, arghint_validate(0, arghint_parse("FOO")));
-    eqint(0, arghint_validate(1, arghint_parse("FOO")));
-    eqint(-1, arghint_validate(2, arghint_parse("FOO")));
-
-    eqint(0, arghint_validate(0, arghint_parse("[FOO]")));
-    eqint(0, arghint_validate(1, arghint_parse("[FOO]")));
-    eqint(-1, arghint_validate(2, arghint_parse("[FOO]")));
-
-    eqint(-1, arghint_validate(0, arghint_parse("FOO BAR")));
-    eqint(-1, arghint_validate(1, arghint_parse("FOO BAR")));
-    eqint(0, arghint_validate(2, arghint_parse("FOO BAR")));
-    eqint(-1, arghint_validate(3, arghint_parse("FOO BAR")));
-
-    eqint(-1, arghint_validate(0, arghint_parse("FOO BAR BAZ")));
-    eqint(-1, arghint_validate(1, arghint_parse("FOO BAR BAZ")));
-    eqint(-1, arghint_validate(2, arghint_parse("FOO BAR BAZ")));
-    eqint(0, arghint_validate(3, arghint_parse("FOO BAR BAZ")));
-
-    eqint(-1, arghint_validate(0, arghint_parse("FOO [BAR]")));
-    eqint(0, arghint_validate(1, arghint_parse("FOO [BAR]")));
-    eqint(0, arghint_validate(2, arghint_parse("FOO [BAR]")));
-    eqint(-1, arghint_validate(3, arghint_parse("FOO [BAR]")));
-
-    eqint(0, arghint_validate(0, arghint_parse("[FOO [BAR]]")));
-    eqint(0, arghint_validate(1, arghint_parse("[FOO [BAR]]")));
-    eqint(0, arghint_validate(2, arghint_parse("[FOO [BAR]]")));
-    eqint(-1, arghint_validate(3, arghint_parse("[FOO [BAR]]")));
-
-    eqint(-1, arghint_validate(0, arghint_parse("FOO [BAR [BAZ]]")));
-    eqint(0, arghint_validate(1, arghint_parse("FOO [BAR [BAZ]]")));
-    eqint(0, arghint_validate(2, arghint_parse("FOO [BAR [BAZ]]")));
-    eqint(0, arghint_validate(3, arghint_parse("FOO [BAR [BAZ]]")));
-    eqint(-1, arghint_validate(4, arghint_parse("FOO [BAR [BAZ]]")));
-
-    eqint(-1, arghint_validate(0, arghint_parse("FOO [BAR BAZ]")));
-    eqint(0, arghint_validate(1, arghint_parse("FOO [BAR BAZ]")));
-    eqint(-1, arghint_validate(2, arghint_parse("FOO [BAR BAZ]")));
-    eqint(0, arghint_validate(3, arghint_parse("FOO [BAR BAZ]")));
-    eqint(-1, arghint_validate(4, arghint_parse("FOO [BAR BAZ]")));
-
-    eqint(0, arghint_validate(0, arghint_parse("...")));
-    eqint(0, arghint_validate(1, arghint_parse("...")));
-    eqint(0, arghint_validate(2, arghint_parse("...")));
-    eqint(0, arghint_validate(3, arghint_parse("...")));
-    eqint(0, arghint_validate(4, arghint_parse("...")));
-
-    eqint(-1, arghint_validate(0, arghint_parse("FOO...")));
-    eqint(0, arghint_validate(1, arghint_parse("FOO...")));
-    eqint(0, arghint_validate(2, arghint_parse("FOO...")));
-    eqint(0, arghint_validate(3, arghint_parse("FOO...")));
-    eqint(0, arghint_validate(4, arghint_parse("FOO...")));
-
-    eqint(0, arghint_validate(0, arghint_parse("[FOO]...")));
-    eqint(0, arghint_validate(1, arghint_parse("[FOO]...")));
-    eqint(0, arghint_validate(2, arghint_parse("[FOO]...")));
-    eqint(0, arghint_validate(3, arghint_parse("[FOO]...")));
-    eqint(0, arghint_validate(4, arghint_parse("[FOO]...")));
-
-    eqint(-1, arghint_validate(0, arghint_parse("FOO BAR...")));
-    eqint(-1, arghint_validate(1, arghint_parse("FOO BAR...")));
-    eqint(0, arghint_validate(2, arghint_parse("FOO BAR...")));
-    eqint(0, arghint_validate(3, arghint_parse("FOO BAR...")));
-    eqint(0, arghint_validate(4, arghint_parse("FOO BAR...")));
-
-    eqint(0, arghint_validate(255, arghint_parse("FOO BAR...")));
+    eqint(0, _validate(0, NULL));
+    eqint(-1, _validate(1, NULL));
+    eqint(-1, _validate(2, NULL));
+
+    eqint(0, _validate(0, ""));
+    eqint(-1, _validate(1, ""));
+    eqint(-1, _validate(2, ""));
+
+    eqint(-1, _validate(0, "FOO"));
+    eqint(0, _validate(1, "FOO"));
+    eqint(-1, _validate(2, "FOO"));
+
+    eqint(0, _validate(0, "[FOO]"));
+    eqint(0, _validate(1, "[FOO]"));
+    eqint(-1, _validate(2, "[FOO]"));
+
+    eqint(-1, _validate(0, "FOO BAR"));
+    eqint(-1, _validate(1, "FOO BAR"));
+    eqint(0, _validate(2, "FOO BAR"));
+    eqint(-1, _validate(3, "FOO BAR"));
+
+    eqint(-1, _validate(0, "FOO BAR BAZ"));
+    eqint(-1, _validate(1, "FOO BAR BAZ"));
+    eqint(-1, _validate(2, "FOO BAR BAZ"));
+    eqint(0, _validate(3, "FOO BAR BAZ"));
+
+    eqint(-1, _validate(0, "FOO [BAR]"));
+    eqint(0, _validate(1, "FOO [BAR]"));
+    eqint(0, _validate(2, "FOO [BAR]"));
+    eqint(-1, _validate(3, "FOO [BAR]"));
+
+    eqint(0, _validate(0, "[FOO [BAR]]"));
+    eqint(0, _validate(1, "[FOO [BAR]]"));
+    eqint(0, _validate(2, "[FOO [BAR]]"));
+    eqint(-1, _validate(3, "[FOO [BAR]]"));
+
+    eqint(-1, _validate(0, "FOO [BAR [BAZ]]"));
+    eqint(0, _validate(1, "FOO [BAR [BAZ]]"));
+    eqint(0, _validate(2, "FOO [BAR [BAZ]]"));
+    eqint(0, _validate(3, "FOO [BAR [BAZ]]"));
+    eqint(-1, _validate(4, "FOO [BAR [BAZ]]"));
+
+    eqint(-1, _validate(0, "FOO [BAR BAZ]"));
+    eqint(0, _validate(1, "FOO [BAR BAZ]"));
+    eqint(-1, _validate(2, "FOO [BAR BAZ]"));
+    eqint(0, _validate(3, "FOO [BAR BAZ]"));
+    eqint(-1, _validate(4, "FOO [BAR BAZ]"));
+
+    eqint(0, _validate(0, "..."));
+    eqint(0, _validate(1, "..."));
+    eqint(0, _validate(2, "..."));
+    eqint(0, _validate(3, "..."));
+    eqint(0, _validate(4, "..."));
+
+    eqint(-1, _validate(0, "FOO..."));
+    eqint(0, _validate(1, "FOO..."));
+    eqint(0, _validate(2, "FOO..."));
+    eqint(0, _validate(3, "FOO..."));
+    eqint(0, _validate(4, "FOO..."));
+
+    eqint(0, _validate(0, "[FOO]..."));
+    eqint(0, _validate(1, "[FOO]..."));
+    eqint(0, _validate(2, "[FOO]..."));
+    eqint(0, _validate(3, "[FOO]..."));
+    eqint(0, _validate(4, "[FOO]..."));
+
+    eqint(-1, _validate(0, "FOO BAR..."));
+    eqint(-1, _validate(1, "FOO BAR..."));
+    eqint(0, _validate(2, "FOO BAR..."));
+    eqint(0, _validate(3, "FOO BAR..."));
+    eqint(0, _validate(4, "FOO BAR..."));
+
+    eqint(0, _validate(255, "FOO BAR..."));
 }
 
 
 void
-test_arghint_parse() {
-    eqint(0b00000000000000000000000000000001, arghint_parse(NULL));
-    eqint(0b00000000000000000000000000000001, arghint_parse(""));
-
-    eqint(0b00000000000000000000000000000010, arghint_parse("FOO"));
-    eqint(0b00000000000000000000000000000011, arghint_parse("[FOO]"));
-    eqint(0b00000000000000000000000000000100, arghint_parse("FOO BAR"));
-    eqint(0b00000000000000000000000000001000, arghint_parse("FOO BAR BAZ"));
-    eqint(0b00000000000000000000000000000110, arghint_parse("FOO [BAR]"));
-    eqint(0b00000000000000000000000000000111, arghint_parse("[FOO [BAR]]"));
-    eqint(0b00000000000000000000000000001110, arghint_parse("FOO [BAR [BAZ]]")); // NOLINT
-    eqint(0b00000000000000000000000000001010, arghint_parse("FOO [BAR BAZ]"));
-
-    eqint(0b10000000000000000000000000000001, arghint_parse("..."));
-    eqint(0b10000000000000000000000000000010, arghint_parse("FOO..."));
-    eqint(0b10000000000000000000000000000011, arghint_parse("[FOO]..."));
-    eqint(0b10000000000000000000000000000100, arghint_parse("FOO BAR..."));
+test_arghint_compile() {
+    struct arghint h;
+
+    eqint(0, arghint_compile(&h, NULL));
+    eqint(2, h.count);
+    eqint(1, h.loop);
+
+    eqint(0, arghint_compile(&h, "FOO [BAR [BAZ]]"));
+    eqint(5, h.count);
+    eqint(4, h.loop);
+
+    eqint(0, arghint_compile(&h, "..."));
+    eqint(1, h.count);
+    eqint(0, h.loop);
+
+    eqint(0, arghint_compile(&h, "FOO BAR..."));
+    eqint(3, h.count);
+    eqint(2, h.loop);
+}
+
+
+void
+test_arghint_forms() {
+    /* alternatives */
+    eqint(-1, _validate(0, "FOO\nBAR BAZ"));
+    eqint(0, _validate(1, "FOO\nBAR BAZ"));
+    eqint(0, _validate(2, "FOO\nBAR BAZ"));
+    eqint(-1, _validate(3, "FOO\nBAR BAZ"));
+
+    eqint(0, _validate(1, "FOO\n\nBAR BAZ\n"));
+    eqint(-1, _validate(0, "FOO\n\nBAR BAZ\n"));
+    eqint(0, _validate(0, " \n"));
+    eqint(-1, _validate(1, " \n"));
+
+    eqint(0, _validate(0, "-l\nFOO BAR...\n[FOO]"));
+    eqint(0, _validate(1, "-l\nFOO BAR...\n[FOO]"));
+    eqint(0, _validate(2, "-l\nFOO BAR...\n[FOO]"));
+    eqint(-1, _validate(1, "FOO BAR\nFOO BAR BAZ QUX"));
+    eqint(-1, _validate(3, "FOO BAR\nFOO BAR BAZ QUX"));
+    eqint(0, _validate(4, "FOO BAR\nFOO BAR BAZ QUX"));
+
+    /* options are not positionals */
+    eqint(0, _validate(0, "-l\nFOO BAR"));
+    eqint(-1, _validate(1, "-l\nFOO BAR"));
+    eqint(0, _validate(2, "-l\nFOO BAR"));
+    eqint(-1, _validate(0, "[-v...] --foo[=BAR] FOO\n-l [--all] -"));
+    eqint(0, _validate(1, "[-v...] --foo[=BAR] FOO\n-l [--all] -"));
+    eqint(-1, _validate(2, "[-v...] --foo[=BAR] FOO\n-l [--all] -"));
+
+    /* optional groups in the middle */
+    eqint(-1, _validate(1, "FOO [BAR BAZ] QUX"));
+    eqint(0, _validate(2, "FOO [BAR BAZ] QUX"));
+    eqint(-1, _validate(3, "FOO [BAR BAZ] QUX"));
+    eqint(0, _validate(4, "FOO [BAR BAZ] QUX"));
+    eqint(-1, _validate(5, "FOO [BAR BAZ] QUX"));
+
+    /* repeated groups */
+    eqint(0, _validate(0, "[FOO BAR]..."));
+    eqint(-1, _validate(1, "[FOO BAR]..."));
+    eqint(0, _validate(2, "[FOO BAR]..."));
+    eqint(-1, _validate(1001, "[FOO BAR]..."));
+    eqint(0, _validate(1002, "[FOO BAR]..."));
+    eqint(-1, _validate(0, "FOO [BAR BAZ]... QUX"));
+    eqint(0, _validate(2, "FOO [BAR BAZ]... QUX"));
+    eqint(-1, _validate(3, "FOO [BAR BAZ]... QUX"));
+    eqint(0, _validate(6, "FOO [BAR BAZ]... QUX"));
+    eqint(0, _validate(0, "[FOO...]"));
+    eqint(0, _validate(7, "[FOO...]"));
+    eqint(0, _validate(7, "[...]"));
+    eqint(-1, _validate(1, "FOO BAR ..."));
+    eqint(0, _validate(2, "FOO BAR ..."));
+    eqint(0, _validate(9, "FOO BAR ..."));
 }
 
 
 void
-test_arghint_parse_errors() {
-    eqint(-1, arghint_parse("[FOO...]"));
-    eqint(-1, arghint_parse("[...]"));
-    eqint(-1, arghint_parse("FOO]"));
-    eqint(-1, arghint_parse("[FOO"));
-
-    /* Pass 31 arg hints */
-    eqint(-1, arghint_parse(
+test_arghint_compile_errors() {
+    eqint(-2, _validate(0, "FOO]"));
+    eqint(-2, _validate(0, "[FOO"));
+    eqint(-2, _validate(0, "[FOO]]"));
+    eqint(-2, _validate(0, "FOO\n[BAR"));
+    eqint(-2, _validate(0, "FOO...BAR"));
+    eqint(-2, _validate(0, "FOO ...BAR"));
+
+    /* more than the 30 positionals of the old bitmask */
+    eqint(-1, _validate(30, "FOO BAR BAZ QUX QUUX THUD "
+        "FOO BAR BAZ QUX QUUX THUD "
         "FOO BAR BAZ QUX QUUX THUD "
+        "FOO BAR BAZ QUX QUUX THUD "
+        "FOO BAR BAZ QUX QUUX THUD "
+        "FOO"));
+    eqint(0, _validate(31, "FOO BAR BAZ QUX QUUX THUD "
         "FOO BAR BAZ QUX QUUX THUD "
         "FOO BAR BAZ QUX QUUX THUD "
         "FOO BAR BAZ QUX QUUX THUD "
         "FOO BAR BAZ QUX QUUX THUD "
         "FOO"));
+
+    /* too many states */
+    struct arghint h;
+    char args[ARGHINT_STATES * 4 + 1];
+    int i;
+
+    for (i = 0; i < ARGHINT_STATES; i++) {
+        memcpy(args + i * 4, "FOO ", 4);
+    }
+    args[ARGHINT_STATES * 4] = 0;
+    eqint(-2, _validate(0, args));
+    eqint(ARGHINT_TOOCOMPLEX, arghint_compile(&h, args));
+    eqint(ARGHINT_MALFORMED, arghint_compile(&h, "[FOO"));
+
+    /* a few states, but the cycle of the counts is 7 * 11 * 2 long */
+    eqint(ARGHINT_TOOCOMPLEX, arghint_compile(&h,
+                "[A A A A A A A]...\n"
+                "[A A A A A A A A A A A]...\n"
+                "[A A]..."));
+    eqint(ARGHINT_OK, arghint_compile(&h,
+                "[A A A A A A A]...\n"
+                "[A A A A A A A A A A A]..."));
+    eqint(77, h.count - h.loop);
+}
+
+
+static char *
+_nested(int depth) {
+    char *args = malloc(depth * 2 + 2);
+
+    memset(args, '[', depth);
+    args[depth] = 'A';
+    memset(args + depth + 1, ']', depth);
+    args[depth * 2 + 1] = 0;
+    return args;
+}
+
+
+void
+test_arghint_nesting() {
+    struct arghint h;
+    char *args;
+
+    args = _nested(NFA_NESTING);
+    eqint(ARGHINT_OK, arghint_compile(&h, args));
+    eqint(0, arghint_validate(&h, 0));
+    eqint(0, arghint_validate(&h, 1));
+    free(args);
+
+    args = _nested(NFA_NESTING + 1);
+    eqint(ARGHINT_TOOCOMPLEX, arghint_compile(&h, args));
+    free(args);
+
+    /* fails before the stack does */
+    args = _nested(1000000);
+    eqint(ARGHINT_TOOCOMPLEX, arghint_compile(&h, args));
+    free(args);
+}
+
+
+void
+test_arghint_cached() {
+    struct arghint h;
+    struct arghint_nfa nfa;
+    struct yacap_arghint cache = {0};
+    const char *foo = "FOO";
+    const char *bar = "[BAR]";
+
+    eqint(ARGHINT_OK, arghint_cached(&h, &cache, foo, &nfa));
+    eqint(2, cache.seq);
+    eqptr(foo, cache.args);
+    eqint(0, arghint_validate(&h, 1));
+
+    /* a hit, the stored hint is used */
+    cache.count = 2;
+    cache.loop = 1;
+    memset(cache.accept, 0, sizeof(cache.accept));
+    cache.accept[0] = 1;
+    eqint(ARGHINT_OK, arghint_cached(&h, &cache, foo, &nfa));
+    eqint(2, cache.seq);
+    eqint(0, arghint_validate(&h, 0));
+    eqint(-1, arghint_validate(&h, 1));
+
+    /* the args are changed */
+    eqint(ARGHINT_OK, arghint_cached(&h, &cache, bar, &nfa));
+    eqint(4, cache.seq);
+    eqptr(bar, cache.args);
+    eqint(0, arghint_validate(&h, 0));
+    eqint(0, arghint_validate(&h, 1));
+    eqint(-1, arghint_validate(&h, 2));
+
+    /* the errors are cached too */
+    eqint(ARGHINT_MALFORMED, arghint_cached(&h, &cache, "[FOO", &nfa));
+    eqint(6, cache.seq);
+    eqint(ARGHINT_MALFORMED, cache.status);
+
+    /* written by another thread, it's compiled but not stored */
+    cache.seq = 7;
+    eqint(ARGHINT_OK, arghint_cached(&h, &cache, foo, &nfa));
+    eqint(7, cache.seq);
+    eqint(0, arghint_validate(&h, 1));
 }
 
 
 int
 main() {
     test_arghint_validate();
-    test_arghint_parse();
-    test_arghint_parse_errors();
+    test_arghint_compile();
+    test_arghint_forms();
+    test_arghint_compile_errors();
+    test_arghint_nesting();
+    test_arghint_cached();
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,75 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <unistd.h>
+
+#include <cutest.h>
+
+#include "buff.c"
+
+
+void
+test_buff_printf() {
+    char tmp[8];
+    struct buff b;
+
+    buff_init(&b, tmp, sizeof(tmp));
+    eqint(3, buff_printf(&b, "foo"));
+    eqint(3, b.len);
+    eqnstr("foo", b.data, 3);
+
+    /* truncate */
+    eqint(4, buff_printf(&b, "%s", "barbaz"));
+    eqint(7, b.len);
+    eqnstr("foobarb", b.data, 7);
+
+    /* full */
+    eqint(0, buff_printf(&b, "qux"));
+    eqint(7, b.len);
+}
+
+
+void
+test_buff_flush() {
+    char tmp[16];
+    char out[16];
+    int p[2];
+    struct buff b;
+
+    eqint(0, pipe(p));
+    buff_init(&b, tmp, sizeof(tmp));
+    buff_printf(&b, "foo");
+    buff_printf(&b, " %s\n", "bar");
+    eqint(8, buff_flush(&b, p[1]));
+    eqint(0, b.len);
+
+    memset(out, 0, sizeof(out));
+    eqint(8, read(p[0], out, sizeof(out)));
+    eqstr("foo bar\n", out);
+
+    close(p[0]);
+    close(p[1]);
+}
+
+
+int
+main() {
+    test_buff_printf();
+    test_buff_flush();
+    return EXIT_SUCCESS;
+}
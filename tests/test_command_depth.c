@@ -0,0 +1,158 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <ucontext.h>
+
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "config.h"
+#include "helpers.h"
+
+
+#define DEPTH 1000
+#define STACKSIZE (16 * 1024)
+
+
+static struct yacap_command _commands[DEPTH];
+static struct yacap_command *_subcommands[DEPTH][2];
+static const char *_argv[DEPTH + 2];
+static int _inits;
+
+
+static int
+_init(struct yacap_command *command) {
+    _inits++;
+    return 0;
+}
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    return YACAP_EAT_OK;
+}
+
+
+/* root -> c -> c -> ... DEPTH times */
+static void
+_tree(struct yacap *yacap) {
+    int i;
+
+    memset(yacap, 0, sizeof(struct yacap));
+    yacap->commands = _subcommands[0];
+    yacap->flags = YACAP_NO_CLOG;
+    for (i = 0; i < DEPTH; i++) {
+        _commands[i].name = "c";
+        _commands[i].init = _init;
+        _commands[i].eat = _eater;
+        _subcommands[i][0] = &_commands[i];
+        _subcommands[i][1] = NULL;
+        if (i) {
+            _commands[i - 1].commands = _subcommands[i];
+        }
+    }
+
+    _argv[0] = "foo";
+    for (i = 1; i <= DEPTH; i++) {
+        _argv[i] = "c";
+    }
+    _commands[DEPTH - 1].args = "[FOO]";
+    _argv[DEPTH + 1] = "bar";
+}
+
+
+static void
+test_command_depth() {
+    struct yacap yacap;
+    struct yacap_error e;
+    const struct yacap_command *cmd = NULL;
+
+    _tree(&yacap);
+
+    /* limited by the compile-time default */
+    _inits = 0;
+    eqint(YACAP_FATAL, yacap_parse(&yacap, DEPTH + 1, _argv, &cmd));
+    eqint(YACAP_CMDSTACK_MAX - 1, _inits);
+    yacap_dispose(&yacap);
+
+    /* the whole chain */
+    _inits = 0;
+    yacap.maxdepth = DEPTH + 1;
+    eqint(YACAP_OK, yacap_parse(&yacap, DEPTH + 2, _argv, &cmd));
+    eqint(DEPTH, _inits);
+    eqptr(&_commands[DEPTH - 1], cmd);
+    yacap_dispose(&yacap);
+
+    /* one less */
+    _inits = 0;
+    yacap.maxdepth = DEPTH;
+    yacap.error = &e;
+    eqint(YACAP_FATAL, yacap_parse(&yacap, DEPTH + 2, _argv, &cmd));
+    eqint(DEPTH - 1, _inits);
+    eqint(YACAP_ERR_COMMAND_TOODEEP, e.code);
+    eqint(DEPTH, e.argindex);
+    yacap_dispose(&yacap);
+
+    /* the positional hint of the last command only */
+    _commands[DEPTH - 1].args = "FOO BAR";
+    yacap.maxdepth = DEPTH + 1;
+    eqint(YACAP_USERERROR, yacap_parse(&yacap, DEPTH + 2, _argv, &cmd));
+    eqint(YACAP_ERR_POSITIONALCOUNT, e.code);
+    yacap_dispose(&yacap);
+}
+
+
+static ucontext_t _main;
+static int _status;
+
+
+static void
+_coroutine() {
+    struct yacap yacap;
+
+    _tree(&yacap);
+    yacap.maxdepth = DEPTH + 1;
+    _status = yacap_parse(&yacap, DEPTH + 2, _argv, NULL);
+    yacap_dispose(&yacap);
+}
+
+
+/* the descent takes a constant stack regardless of the depth */
+static void
+test_command_depth_smallstack() {
+    ucontext_t co;
+    static char stack[STACKSIZE];
+
+    eqint(0, getcontext(&co));
+    co.uc_stack.ss_sp = stack;
+    co.uc_stack.ss_size = sizeof(stack);
+    co.uc_link = &_main;
+    makecontext(&co, _coroutine, 0);
+
+    _status = YACAP_FATAL;
+    eqint(0, swapcontext(&_main, &co));
+    eqint(YACAP_OK, _status);
+}
+
+
+int
+main() {
+    test_command_depth();
+    test_command_depth_smallstack();
+    return EXIT_SUCCESS;
+}
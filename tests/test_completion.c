@@ -0,0 +1,372 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "helpers.h"
+
+
+#define SCRIPTFILE "completion.out"
+
+
+static char script[BUFFSIZE * 8 + 1];
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap_option addoptions[] = {
+    {"file", 'f', "FILE", YACAP_OPTION_FILE, "Read routes from FILE"},
+    {"metric", 'm', "N", 0, "Route metric"},
+    {NULL}
+};
+
+
+static struct yacap_command add = {
+    .name = "add",
+    .header = "Add a route",
+    .options = addoptions,
+    .argflags = YACAP_OPTION_DIRECTORY,
+};
+
+
+static int initcalls = 0;
+
+
+static int
+_init(struct yacap_command *cmd) {
+    initcalls++;
+    return 0;
+}
+
+
+#define DEL_OPTIONS(O, t) \
+    O(t, force, "force", 'F', "", 0, "Delete even if in use") \
+    O(t, table, "table", 't', "TABLE", 0, "Routing table")
+
+
+YACAP_OPTIONTABLE(deloptions, DEL_OPTIONS);
+
+
+static struct yacap_command del = {
+    .name = "del",
+    .header = "Delete a route",
+    .init = _init,
+    .optiontable = &deloptions,
+};
+
+
+static struct yacap_command delta = {
+    .name = "delta",
+};
+
+
+static struct yacap_option options[] = {
+    {"quiet", 'Q', NULL, 0, "Don't print anything"},
+    {NULL}
+};
+
+
+static struct yacap cli = {
+    .eat = _eater,
+    .options = options,
+    .flags = YACAP_NO_CLOG,
+    .commands = (struct yacap_command * const[]) {
+        &add,
+        &del,
+        &delta,
+        NULL
+    },
+};
+
+
+static const char *
+_generate(const char *shell) {
+    FILE *f;
+    size_t len;
+    const char *argv[] = {"route_completion_twin", SCRIPTFILE, shell,
+        "/usr/bin/route"};
+
+    eqint(YACAP_OK_EXIT, yacap_completion_main(&cli, 4, argv));
+
+    f = fopen(SCRIPTFILE, "r");
+    isnotnull(f);
+    len = fread(script, 1, sizeof(script) - 1, f);
+    script[len] = 0;
+    fclose(f);
+    unlink(SCRIPTFILE);
+    return script;
+}
+
+
+static void
+test_completion_bash() {
+    const char *s = _generate("bash");
+
+    isnotnull(strstr(s, "complete -F _yacap_route route\n"));
+    isnotnull(strstr(s,
+        "            'route add') cmdpath='route add';;\n"
+        "            'route del') cmdpath='route del';;\n"));
+    isnotnull(strstr(s,
+        "            'route add:-f'|'route add:--file') skip=1; continue;;\n"
+        "            'route add:-m'|'route add:--metric') skip=1; "
+        "continue;;\n"));
+    isnotnull(strstr(s,
+        "            'route add:-f'|'route add:--file') "
+        "COMPREPLY=($(compgen -f -- \"$cur\"));;\n"));
+    isnotnull(strstr(s,
+        "        'route')\n"
+        "            opts='-h --help -? --usage -Q --quiet'\n"
+        "            cmds='add del delta'\n"
+        "            files=''\n"));
+    isnotnull(strstr(s,
+        "        'route add')\n"
+        "            opts='-h --help -? --usage -Q --quiet -f --file -m "
+        "--metric'\n"
+        "            cmds=''\n"
+        "            files='-d'\n"));
+}
+
+
+static void
+test_completion_zsh() {
+    const char *s = _generate("zsh");
+
+    eqnstr("#compdef route\n", s, 15);
+    isnotnull(strstr(s, "compdef _yacap_route route\n"));
+    isnotnull(strstr(s,
+        "            'route add:-m'|'route add:--metric') _message 'N';;\n"));
+    isnotnull(strstr(s,
+        "                '--quiet':'Don'\\''t print anything'\n"));
+    isnotnull(strstr(s,
+        "            cmds=(\n"
+        "                'add':'Add a route'\n"
+        "                'del':'Delete a route'\n"
+        "                'delta':''\n"
+        "            )\n"));
+}
+
+
+static void
+test_completion_fish() {
+    const char *s = _generate("fish");
+
+    isnotnull(strstr(s, "complete -c route -f\n"));
+    isnotnull(strstr(s,
+        "        switch \"$cmdpath $w\"\n"
+        "            case 'route add'\n"
+        "                set cmdpath 'route add'\n"));
+    isnotnull(strstr(s,
+        "complete -c route -n \"test (__yacap_route_path) = 'route'\" "
+        "-a 'del' -d 'Delete a route'\n"));
+    isnotnull(strstr(s,
+        "complete -c route -n \"test (__yacap_route_path) = 'route add'\" "
+        "-s 'f' -l 'file' -r -F -d 'Read routes from FILE'\n"));
+    isnotnull(strstr(s,
+        "complete -c route -n \"test (__yacap_route_path) = 'route add'\" "
+        "-a '(__fish_complete_directories)'\n"));
+}
+
+
+static void
+test_completion_dynamic() {
+    cli.flags |= YACAP_COMPLETE;
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&cli, "route --complete", NULL));
+    eqstr("add\ndel\ndelta\n", out);
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&cli, "route --complete de",
+                NULL));
+    eqstr("del\ndelta\n", out);
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&cli, "route --complete --q",
+                NULL));
+    eqstr("--quiet\n", out);
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&cli, "route --complete -",
+                NULL));
+    eqstr("-?\n-Q\n-h\n--help\n--usage\n--quiet\n", out);
+
+    /* sub-command options, inherited and from option tables, in the
+     * order of the commands */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&cli,
+                "route --complete -Q del --", NULL));
+    eqstr("--help\n--usage\n--quiet\n--force\n--table\n", out);
+
+    /* values are skipped */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&cli,
+                "route --complete add --metric del --f", NULL));
+    eqstr("--file\n", out);
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&cli,
+                "route --complete add -fm", NULL));
+    eqstr("", out);
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&cli,
+                "route --complete del -Ft main --", NULL));
+    eqstr("--help\n--usage\n--quiet\n--force\n--table\n", out);
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&cli,
+                "route --complete -- de", NULL));
+    eqstr("", out);
+    eqint(0, initcalls);
+
+    cli.flags &= ~YACAP_COMPLETE;
+}
+
+
+static struct yacap_command three = {
+    .name = "three",
+    .options = (const struct yacap_option[]) {
+        {"three", '3', NULL, 0, "Third level"},
+        {NULL}
+    },
+};
+
+
+static struct yacap_command two = {
+    .name = "two",
+    .options = (const struct yacap_option[]) {
+        {"two", '2', NULL, 0, "Second level"},
+        {NULL}
+    },
+    .commands = (struct yacap_command * const[]) {
+        &three,
+        NULL
+    },
+};
+
+
+static struct yacap_command one = {
+    .name = "one",
+    .options = (const struct yacap_option[]) {
+        {"one", '1', NULL, 0, "First level"},
+        {NULL}
+    },
+    .commands = (struct yacap_command * const[]) {
+        &two,
+        NULL
+    },
+};
+
+
+static void
+test_completion_depth() {
+    struct yacap yacap = {
+        .flags = YACAP_NO_CLOG | YACAP_COMPLETE,
+        .maxdepth = 3,
+        .commands = (struct yacap_command * const[]) {
+            &one,
+            NULL
+        },
+    };
+
+    /* the candidates of the deepest command reached */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap,
+                "foo --complete one two three --", NULL));
+    eqstr("--help\n--usage\n--one\n--two\n", out);
+
+    /* but not the sub-commands, they are too deep */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap,
+                "foo --complete one two t", NULL));
+    eqstr("", out);
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap,
+                "foo --complete one t", NULL));
+    eqstr("two\n", out);
+}
+
+
+static int completeflag = 0;
+
+
+static enum yacap_eatstatus
+_completeeater(const struct yacap_option *opt, const char *value,
+        void *userptr) {
+    if (opt && (opt->key == 'c')) {
+        completeflag++;
+    }
+
+    return YACAP_EAT_OK;
+}
+
+
+static void
+test_completion_optin() {
+    struct yacap_option own[] = {
+        {"complete", 'c', NULL, 0, "The program's own option"},
+        {NULL}
+    };
+    struct yacap yacap = {
+        .eat = _completeeater,
+        .options = own,
+        .flags = YACAP_NO_CLOG | YACAP_COMPLETE,
+    };
+
+    /* disabled by default */
+    eqint(YACAP_USERERROR, yacap_parse_string(&cli, "route --complete",
+                NULL));
+
+    /* the root's own --complete is parsed as usual */
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo --complete", NULL));
+    eqint(1, completeflag);
+    eqstr("", out);
+}
+
+
+static void
+test_completion_invalidshell() {
+    const char *argv[] = {"route_completion_twin", SCRIPTFILE, "csh",
+        "route"};
+
+    eqint(YACAP_FATAL, yacap_completion_main(&cli, 4, argv));
+    eqint(YACAP_FATAL, yacap_completion_main(&cli, 3, argv));
+}
+
+
+/* the environment doesn't turn a regular parse into the generator */
+static void
+test_completion_environment() {
+    setenv("YACAP_COMPLETION", SCRIPTFILE, 1);
+    setenv("YACAP_COMPLETION_SHELL", "bash", 1);
+    eqint(YACAP_OK, yacap_parse_string(&cli, "route add", NULL));
+    eqint(-1, access(SCRIPTFILE, F_OK));
+    unsetenv("YACAP_COMPLETION");
+    unsetenv("YACAP_COMPLETION_SHELL");
+}
+
+
+int
+main() {
+    test_completion_bash();
+    test_completion_zsh();
+    test_completion_fish();
+    test_completion_dynamic();
+    test_completion_depth();
+    test_completion_optin();
+    test_completion_invalidshell();
+    test_completion_environment();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,249 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "helpers.h"
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    if ((opt == NULL) && (strcmp(value, "bad") == 0)) {
+        return YACAP_EAT_UNRECOGNIZED;
+    }
+
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap_option options[] = {
+    {"foo", 'f', NULL, 0, NULL},
+    {"bar", 'b', "BAR", 0, NULL},
+    {NULL}
+};
+
+
+static void
+test_error_record() {
+    char msg[256];
+    struct yacap_error e;
+    struct yacap yacap = {
+        .eat = _eater,
+        .args = "[FOO]",
+        .options = options,
+        .flags = YACAP_NO_CLOG,
+        .error = &e,
+    };
+
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo -f", NULL));
+    eqint(YACAP_ERR_NONE, e.code);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo -f --qux",
+                NULL));
+    eqstr("", out);
+    eqstr("", err);
+    eqint(YACAP_ERR_OPTION_UNRECOGNIZED, e.code);
+    eqint(2, e.argindex);
+    eqint(0, e.offset);
+    isnull(e.option);
+    eqint(25, yacap_error_format(&e, msg, sizeof(msg)));
+    eqstr("invalid option -- '--qux'", msg);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo -fx", NULL));
+    eqstr("", err);
+    eqint(YACAP_ERR_OPTION_UNRECOGNIZED, e.code);
+    eqint(1, e.argindex);
+    eqint(2, e.offset);
+    yacap_error_format(&e, msg, sizeof(msg));
+    eqstr("invalid option -- '-x'", msg);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo -f -b", NULL));
+    eqstr("", err);
+    eqint(YACAP_ERR_OPTION_MISSINGARGUMENT, e.code);
+    eqint(2, e.argindex);
+    eqint(1, e.offset);
+    eqptr(&options[1], e.option);
+    yacap_error_format(&e, msg, sizeof(msg));
+    eqstr("option requires an argument -- '-b/--bar'", msg);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo --foo=baz",
+                NULL));
+    eqint(YACAP_ERR_OPTION_HASARGUMENT, e.code);
+    eqptr(&options[0], e.option);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo -f -ff", NULL));
+    eqint(YACAP_ERR_OPTION_REDUNDANT, e.code);
+    eqint(2, e.argindex);
+    eqint(1, e.offset);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo bad", NULL));
+    eqint(YACAP_ERR_POSITIONAL, e.code);
+    eqint(1, e.argindex);
+    eqnstr("bad", e.text, e.len);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo a b", NULL));
+    eqstr("", err);
+    eqint(YACAP_ERR_POSITIONALCOUNT, e.code);
+    eqint(3, e.argindex);
+    yacap_error_format(&e, msg, sizeof(msg));
+    eqstr("invalid positional arguments count", msg);
+
+    /* truncation */
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo --thud", NULL));
+    eqint(7, yacap_error_format(&e, msg, 8));
+    eqstr("invalid", msg);
+}
+
+
+static void
+test_error_print() {
+    struct yacap yacap = {
+        .eat = _eater,
+        .options = options,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo -f -b", NULL));
+    eqstr("", out);
+    eqstr("foo: option requires an argument -- '-b/--bar'\n"
+        "Try `foo --help' or `foo --usage' for more information.\n", err);
+}
+
+
+static void
+test_error_optiondb() {
+    char msg[256];
+    struct yacap_error e;
+    struct yacap_option dup[] = {
+        {"foo", 'f', NULL, 0, NULL},
+        {"qux", 'f', NULL, 0, NULL},
+        {NULL}
+    };
+    struct yacap_command sub = {
+        .name = "sub",
+        .options = dup,
+    };
+    struct yacap yacap = {
+        .eat = _eater,
+        .options = dup,
+        .flags = YACAP_NO_CLOG,
+        .error = &e,
+    };
+    struct yacap nested = {
+        .eat = _eater,
+        .options = options,
+        .commands = (struct yacap_command *const[]) {&sub, NULL},
+        .flags = YACAP_NO_CLOG,
+        .error = &e,
+    };
+
+    eqint(YACAP_FATAL, yacap_parse_string(&yacap, "foo", NULL));
+    eqstr("", err);
+    eqint(YACAP_ERR_OPTION_DUPLICATED, e.code);
+    eqptr(&dup[1], e.option);
+    yacap_error_format(&e, msg, sizeof(msg));
+    eqstr("option duplicated -- '-f/--qux'", msg);
+
+    /* sub-command options clashing with the root's */
+    eqint(YACAP_FATAL, yacap_parse_string(&nested, "foo sub", NULL));
+    eqstr("", err);
+    eqint(YACAP_ERR_OPTION_DUPLICATED, e.code);
+    eqptr(&dup[0], e.option);
+}
+
+
+/* the diagnostics move to the heap instead of being truncated */
+/* the hints beyond the automaton are refused instead of ignored */
+static void
+test_error_arghint() {
+    struct yacap_command sub = {
+        .name = "sub",
+        .args = "[A A A A A A A]...\n[A A A A A A A A A A A]...\n[A A]...",
+    };
+    struct yacap yacap = {
+        .eat = _eater,
+        .args = "[FOO]",
+        .commands = (struct yacap_command *const[]) {&sub, NULL},
+        .flags = YACAP_NO_CLOG,
+    };
+
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo", NULL));
+    eqint(YACAP_FATAL, yacap_parse_string(&yacap, "foo sub", NULL));
+    eqstr("foo sub: positional arguments hint is too complex\n", err);
+}
+
+
+/* the chain stops at the maxdepth with a reason */
+static void
+test_error_toodeep() {
+    struct yacap_error e;
+    struct yacap_command sub = {
+        .name = "sub",
+    };
+    struct yacap_command *subs[] = {&sub, NULL};
+    struct yacap yacap = {
+        .eat = _eater,
+        .commands = subs,
+        .flags = YACAP_NO_CLOG,
+        .maxdepth = 3,
+    };
+
+    sub.commands = subs;
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo sub sub", NULL));
+    eqint(YACAP_FATAL, yacap_parse_string(&yacap, "foo sub sub sub", NULL));
+    eqstr("foo sub sub: sub-commands are nested too deep -- 'sub'\n", err);
+
+    yacap.error = &e;
+    eqint(YACAP_FATAL, yacap_parse_string(&yacap, "foo sub sub sub", NULL));
+    eqstr("", err);
+    eqint(YACAP_ERR_COMMAND_TOODEEP, e.code);
+    eqint(3, e.argindex);
+}
+
+
+static void
+test_error_long() {
+    static char line[1600];
+    struct yacap yacap = {
+        .eat = _eater,
+        .options = options,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    strcpy(line, "foo --");
+    memset(line + 6, 'x', sizeof(line) - 7);
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, line, NULL));
+    eqint(strlen(line) + 78, strlen(err));
+    istrue(strncmp(err, "foo: invalid option -- '--xxx", 29) == 0);
+    eqstr("xxx'\n"
+        "Try `foo --help' or `foo --usage' for more information.\n",
+        err + strlen(err) - 61);
+}
+
+
+int
+main() {
+    test_error_record();
+    test_error_print();
+    test_error_optiondb();
+    test_error_arghint();
+    test_error_toodeep();
+    test_error_long();
+    return EXIT_SUCCESS;
+}
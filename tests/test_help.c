@@ -48,6 +48,39 @@ test_usage() {
 }
 
 
+/* the usage grows beyond the stack buffer instead of being truncated */
+void
+test_usage_long() {
+    static char args[40 * 136];
+    static char usage[16384];
+    const char *argv[] = {"foo"};
+    int i;
+    char *p = args;
+    struct yacap yacap = {
+        .args = args,
+        .flags = YACAP_NO_CLOG,
+    };
+    struct yacap_sink sink = {
+        .type = YACAP_SINK_MEMORY,
+        .memory = {usage, sizeof(usage), 0},
+    };
+
+    /* a few states each, long hints are refused */
+    for (i = 0; i < 40; i++) {
+        p += sprintf(p, "%s[arg%03d%0120d]", i? "\n": "", i, 0);
+    }
+
+    eqint(YACAP_OK, yacap_parse(&yacap, 1, argv, NULL));
+    istrue(yacap_usage_render(&yacap, &sink) > 0);
+    yacap_dispose(&yacap);
+
+    istrue(sink.memory.len > 4096);
+    eqnstr("Usage: foo [OPTION...] [arg000", usage, 30);
+    eqnstr("   or: foo [OPTION...] [arg039",
+            usage + sink.memory.len - 152, 30);
+}
+
+
 void
 test_help_doc() {
     struct yacap yacap = {
@@ -281,12 +314,52 @@ test_help_options() {
 }
 
 
+/* the help column is capped, longer options' help goes to the next line */
+void
+test_help_longoption() {
+    struct yacap_option options[] = {
+        {"foo", 'f', NULL, 0, "Foo flag"},
+        {"a-very-long-option-name-which-does-not-fit", 'l', "VALUE", 0,
+            "Long option"},
+        {"Some very long group name, longer than the column:", 0, 0, 0,
+            "Group"},
+        {"bar", 'b', NULL, 0, NULL},
+        {NULL}
+    };
+
+    struct yacap yacap = {
+        .options = options,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    char *help =
+"Usage: foo [OPTION...]\n"
+"\n"
+"Options:\n"
+"  -h, --help                           Give this help list and exit\n"
+"  -?, --usage                          Give a short usage message and exit\n"  // NOLINT
+"  -f, --foo                            Foo flag\n"
+"  -l, --a-very-long-option-name-which-does-not-fit=VALUE\n"
+"                                       Long option\n"
+"\n"
+"Some very long group name, longer than the column:\n"
+"                                       Group\n"
+"  -b, --bar                            \n";
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help", NULL));
+    eqstr(help, out);
+    eqstr("", err);
+}
+
+
 int
 main() {
     test_help_options();
     test_usage();
+    test_usage_long();
     test_help_doc();
     test_help_default();
     test_help_nooptions();
+    test_help_longoption();
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,265 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "config.h"
+#include "search.h"
+#include "helpers.h"
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    return YACAP_EAT_OK;
+}
+
+
+#define DEL_OPTIONS(O, t) \
+    O(t, force, "force", 'F', "", 0, "Delete even the static routes")
+
+YACAP_OPTIONTABLE(deloptions, DEL_OPTIONS);
+
+
+static struct yacap_command add = {
+    .name = "add",
+    .header = "Add a route",
+    .eat = _eater,
+    .options = (const struct yacap_option[]) {
+        {"file", 'f', "FILE", 0, "Read routes from FILE"},
+        {"metric", 'm', "N", 0, "Route metric"},
+        {NULL}
+    },
+};
+
+
+static struct yacap_command del = {
+    .name = "del",
+    .header = "Remove a route",
+    .eat = _eater,
+    .optiontable = &deloptions,
+};
+
+
+static struct yacap_command route = {
+    .name = "route",
+    .header = "Manage the routing tables",
+    .commands = (struct yacap_command*[]) {
+        &add,
+        &del,
+        NULL
+    },
+};
+
+
+static struct yacap_command link_ = {
+    .name = "link",
+    .header = "Manage the network devices",
+    .footer = "See also the route command.",
+    .eat = _eater,
+    .options = (const struct yacap_option[]) {
+        {"Common:", 0, NULL, 0, "Device selection"},
+        {"dev", 'd', "NAME", 0, "Device name"},
+        {NULL}
+    },
+};
+
+
+static struct yacap yacap = {
+    .header = "Network configuration",
+    .eat = _eater,
+    .options = (const struct yacap_option[]) {
+        {"netns", 'n', "NAME", 0, "Switch to the network namespace NAME"},
+        {NULL}
+    },
+    .commands = (struct yacap_command*[]) {
+        &route,
+        &link_,
+        NULL
+    },
+    .flags = YACAP_NO_CLOG,
+};
+
+
+static void
+test_helpsearch() {
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help=route",
+                NULL));
+    eqstr("", err);
+    eqstr(
+        "foo route\n"
+        "foo route add\n"
+        "foo route add -f/--file\n"
+        "foo route add -m/--metric\n"
+        "foo route del\n"
+        "foo route del -F/--force\n"
+        "foo link\n", out);
+
+    /* case insensitive prefixes */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help=NAM", NULL));
+    eqstr(
+        "foo -n/--netns\n"
+        "foo link -d/--dev\n", out);
+
+    /* all the keywords */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help=route,met",
+                NULL));
+    eqstr("foo route add -m/--metric\n", out);
+
+    /* option tables */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help=static",
+                NULL));
+    eqstr("foo route del -F/--force\n", out);
+
+    /* the sub-tree only */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap,
+                "foo route --help=network", NULL));
+    eqstr("", out);
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap,
+                "foo route --help=remove", NULL));
+    eqstr("foo route del\n", out);
+
+    /* group titles are not searched */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help=selection",
+                NULL));
+    eqstr("", out);
+    eqstr("", err);
+
+    /* no keywords, the help page */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help=", NULL));
+    eqnstr("Usage: foo [OPTION...]", out, 22);
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help=,", NULL));
+    eqstr("", out);
+
+    /* the others still reject values */
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo --usage=foo",
+                NULL));
+    eqnstr("foo: no argument allowed for option -- '-?/--usage'\n", err, 52);
+}
+
+
+static void
+test_helpsearch_render() {
+    char buff[128];
+    const char *argv[] = {"foo", "route", "add"};
+    struct yacap_sink sink = {
+        .type = YACAP_SINK_MEMORY,
+        .memory = {buff, sizeof(buff), 0},
+    };
+
+    eqint(YACAP_OK, yacap_parse(&yacap, 3, argv, NULL));
+    eqint(3, yacap_helpsearch_render(&yacap, "route", &sink));
+    eqnstr("foo route add\n"
+        "foo route add -f/--file\n"
+        "foo route add -m/--metric\n", buff, sink.memory.len);
+
+    /* the index is reused */
+    sink.memory.len = 0;
+    eqint(1, yacap_helpsearch_render(&yacap, "N", &sink));
+    eqnstr("foo route add -m/--metric\n", buff, sink.memory.len);
+
+    sink.memory.len = 0;
+    eqint(0, yacap_helpsearch_render(&yacap, "qux", &sink));
+    eqint(0, sink.memory.len);
+    eqint(-1, yacap_helpsearch_render(&yacap, NULL, &sink));
+    yacap_dispose(&yacap);
+}
+
+
+static void
+test_helpsearch_sorted() {
+    int i;
+    struct search x;
+    struct buff unsorted;
+    struct buff sorted;
+    FILE *f;
+    const char *keywords[] = {"route", "r", "NAME", "del", "the route", "",
+        "qux"};
+
+    eqint(0, search_build(&x, (const struct yacap_command *)&yacap,
+                YACAP_CMDSTACK_MAX, NULL));
+    eqint(0, x.index.sorted);
+    eqint(0, buff_alloc(&unsorted, 64, NULL));
+    eqint(0, buff_alloc(&sorted, 64, NULL));
+    for (i = 0; i < (sizeof(keywords) / sizeof(char *)); i++) {
+        search_query(&x.index, &unsorted, "foo", "", keywords[i]);
+        search_query(&x.index, &unsorted, "foo", "route", keywords[i]);
+    }
+
+    search_sort(&x);
+    eqint(1, x.index.sorted);
+    for (i = 0; i < (sizeof(keywords) / sizeof(char *)); i++) {
+        search_query(&x.index, &sorted, "foo", "", keywords[i]);
+        search_query(&x.index, &sorted, "foo", "route", keywords[i]);
+    }
+    eqint(unsorted.len, sorted.len);
+    eqnstr(unsorted.data, sorted.data, sorted.len);
+
+    /* the generated source */
+    f = tmpfile();
+    isnotnull(f);
+    eqint(0, search_write(f, &x, search_fingerprint(&yacap)));
+    eqint(0, ferror(f));
+    fclose(f);
+
+    buff_free(&unsorted);
+    buff_free(&sorted);
+    search_dispose(&x);
+}
+
+
+static void
+test_helpsearch_prerendered() {
+    struct search x;
+    struct yacap_prerender prerender = {
+        .search = &x.index,
+    };
+
+    /* an index of another tree, stands for a stale one */
+    eqint(0, search_build(&x, &del, YACAP_CMDSTACK_MAX, NULL));
+    search_sort(&x);
+    x.index.fingerprint = search_fingerprint(&yacap);
+    yacap.prerender = &prerender;
+
+    /* used as long as the fingerprint matches the tree */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help=force",
+                NULL));
+    eqstr("foo -F/--force\n", out);
+
+    /* and built at runtime when it doesn't */
+    x.index.fingerprint = 0;
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help=force",
+                NULL));
+    eqstr("foo route del -F/--force\n", out);
+
+    yacap.prerender = NULL;
+    search_dispose(&x);
+}
+
+
+int
+main() {
+    test_helpsearch();
+    test_helpsearch_render();
+    test_helpsearch_sorted();
+    test_helpsearch_prerendered();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <cutest.h>
+
+#include "lz.c"
+#include "helpers.h"
+
+
+static void
+_roundtrip(const char *in, size_t len) {
+    struct buff b;
+    char *out = malloc(len + 1);
+
+    isnotnull(out);
+    eqint(0, buff_alloc(&b, 64, NULL));
+    eqint(0, lz_compress(&b, in, len));
+    eqint(len, lz_decompress(out, len, (unsigned char *)b.data, b.len));
+    istrue(memcmp(in, out, len) == 0);
+
+    /* every truncation is either rejected or decodes a prefix */
+    for (size_t i = 0; i < b.len; i += 1 + (b.len / 512)) {
+        int n = lz_decompress(out, len, (unsigned char *)b.data, i);
+        istrue((n == -1) || ((n <= len) && (memcmp(in, out, n) == 0)));
+    }
+
+    buff_free(&b);
+    free(out);
+}
+
+
+void
+test_lz_roundtrip() {
+    int i;
+    char random[4096];
+
+    _roundtrip("", 0);
+    _roundtrip("a", 1);
+    _roundtrip("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 44);
+    _roundtrip(LOREM, strlen(LOREM));
+    _roundtrip(LOREM LOREM LOREM LOREM, strlen(LOREM) * 4);
+
+    srand(7);
+    for (i = 0; i < sizeof(random); i++) {
+        random[i] = rand() % ((i % 3)? 256: 4);
+    }
+    _roundtrip(random, sizeof(random));
+}
+
+
+/* inputs built to hit the limits of the format */
+void
+test_lz_adversarial() {
+    int i;
+    size_t len;
+    char *in = malloc(140000);
+
+    isnotnull(in);
+
+    /* runs longer than a match and than the window */
+    memset(in, 'a', 140000);
+    _roundtrip(in, 140000);
+
+    /* short periods, each position matches the one before */
+    for (len = 1; len <= 4; len++) {
+        for (i = 0; i < 70000; i++) {
+            in[i] = 'a' + (i % len);
+        }
+        _roundtrip(in, 70000);
+    }
+
+    /* repeats exactly at and just beyond the maximum distance */
+    srand(11);
+    for (i = 0; i < 140000; i++) {
+        in[i] = rand();
+    }
+    memcpy(in + 65535, in, 200);
+    memcpy(in + 65536 + 300, in + 300, 200);
+    _roundtrip(in, 140000);
+
+    /* all byte values, literal runs of every length */
+    for (i = 0; i < 256; i++) {
+        in[i] = i;
+    }
+    for (len = 0; len <= 256; len++) {
+        _roundtrip(in, len);
+    }
+
+    /* random lengths and alphabets */
+    for (i = 0; i < 500; i++) {
+        len = rand() % 2048;
+        for (size_t j = 0; j < len; j++) {
+            in[j] = rand() % (1 + (i % 8));
+        }
+        _roundtrip(in, len);
+    }
+
+    free(in);
+}
+
+
+/* the decoder never writes out of bounds, whatever the input */
+void
+test_lz_fuzz() {
+    int i;
+    int n;
+    size_t j;
+    size_t len;
+    struct buff b;
+    char out[4096];
+    unsigned char in[256];
+
+    srand(13);
+    for (i = 0; i < 20000; i++) {
+        len = rand() % sizeof(in);
+        for (j = 0; j < len; j++) {
+            in[j] = rand();
+        }
+        n = lz_decompress(out, rand() % sizeof(out), in, len);
+        istrue((n == -1) || ((n >= 0) && (n <= sizeof(out))));
+    }
+
+    /* bit flips of a valid stream */
+    eqint(0, buff_alloc(&b, 64, NULL));
+    eqint(0, lz_compress(&b, LOREM, strlen(LOREM)));
+    for (i = 0; i < 20000; i++) {
+        unsigned char *flipped = malloc(b.len);
+
+        memcpy(flipped, b.data, b.len);
+        flipped[rand() % b.len] ^= 1 << (rand() % 8);
+        n = lz_decompress(out, sizeof(out), flipped, b.len);
+        istrue((n == -1) || (n <= sizeof(out)));
+        free(flipped);
+    }
+    buff_free(&b);
+}
+
+
+void
+test_lz_ratio() {
+    struct buff b;
+    char in[4096];
+
+    memset(in, ' ', sizeof(in));
+    eqint(0, buff_alloc(&b, 64, NULL));
+    eqint(0, lz_compress(&b, in, sizeof(in)));
+    istrue(b.len < 128);
+    buff_free(&b);
+}
+
+
+void
+test_lz_corrupted() {
+    char out[16];
+    unsigned char match[] = {0, 'a', 0x80, 0, 2};
+    unsigned char literal[] = {4, 'a'};
+
+    /* distance beyond the output */
+    eqint(-1, lz_decompress(out, sizeof(out), match, sizeof(match)));
+
+    /* truncated literals */
+    eqint(-1, lz_decompress(out, sizeof(out), literal, sizeof(literal)));
+
+    /* output overflow */
+    eqint(-1, lz_decompress(out, 2, (unsigned char *)"\x03" "abcd", 5));
+}
+
+
+/* a full output is an error, not a truncated page */
+void
+test_lz_overflow() {
+    struct buff b;
+    char tmp[16];
+
+    buff_init(&b, tmp, sizeof(tmp));
+    eqint(-1, lz_compress(&b, LOREM, strlen(LOREM)));
+}
+
+
+int
+main() {
+    test_lz_roundtrip();
+    test_lz_adversarial();
+    test_lz_fuzz();
+    test_lz_overflow();
+    test_lz_ratio();
+    test_lz_corrupted();
+    return EXIT_SUCCESS;
+}
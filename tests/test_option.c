@@ -80,7 +80,7 @@ test_options_duplicated() {
 
     eqint(YACAP_FATAL, yacap_parse_string(&c, "foo -f", NULL));
     eqstr("", out);
-    eqstr("option duplicated -- '-f/--foo'\n", err);
+    eqstr("foo: option duplicated -- '-f/--foo'\n", err);
 }
 
 
@@ -26,7 +26,7 @@
 void
 test_optiondb_duplication() {
     struct optiondb optdb;
-    optiondb_init(&optdb);
+    optiondb_init(&optdb, NULL);
 
     struct yacap_option options1[] = {
         {"aoo", 'a', NULL, 0, NULL},
@@ -37,7 +37,7 @@ test_optiondb_duplication() {
     eqint(-1, optiondb_insertvector(&optdb, options1, NULL));
     optiondb_dispose(&optdb);
 
-    optiondb_init(&optdb);
+    optiondb_init(&optdb, NULL);
     struct yacap_option options2[] = {
         {"aoo", 'a', NULL, 0, NULL},
         {"boo", 'b', NULL, 0, NULL},
@@ -99,7 +99,7 @@ test_optiondb_autoextend() {
     };
 
 
-    optiondb_init(&optdb);
+    optiondb_init(&optdb, NULL);
     optiondb_insertvector(&optdb, options1, NULL);
 
     eqint(8, optdb.size);
@@ -0,0 +1,227 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "helpers.h"
+
+
+static struct {
+    int foo;
+    const char *bar;
+    int verbose;
+    int qux;
+} args;
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    if (opt == NULL) {
+        return YACAP_EAT_UNRECOGNIZED;
+    }
+
+    switch (opt->key) {
+        case 'f':
+            args.foo++;
+            break;
+        case 'b':
+            args.bar = value;
+            break;
+        case 'V':
+            args.verbose++;
+            break;
+        case 'x':
+            args.qux++;
+            break;
+        default:
+            return YACAP_EAT_NOTEATEN;
+    }
+
+    return YACAP_EAT_OK;
+}
+
+
+#define ROOT_OPTIONS(O, t) \
+    O(t, foo, "foo", 'f', "", 0, "Foo flag") \
+    O(t, bar, "bar", 'b', "BAR", 0, "Bar option with value") \
+    O(t, group, "Misc:", 0, "", 0, "") \
+    O(t, verbose, "", 'V', "", YACAP_OPTION_MULTIPLE, "")
+
+#define QUX_OPTIONS(O, t) \
+    O(t, qux, "qux", 'x', "", 0, "Qux flag")
+
+#define DUP_OPTIONS(O, t) \
+    O(t, foo, "foo", 'f', "", 0, "") \
+    O(t, foo2, "foo", 'o', "", 0, "")
+
+
+#define MANY_OPTIONS(O, t) \
+    O(t, alpha, "alpha", 'a', "", YACAP_OPTION_MULTIPLE, "") \
+    O(t, bravo, "bravo", 'b', "", 0, "") \
+    O(t, charlie, "charlie", 'c', "", 0, "") \
+    O(t, delta, "delta", 'd', "", 0, "") \
+    O(t, echo, "echo", 'e', "", 0, "") \
+    O(t, golf, "golf", 'g', "", 0, "")
+
+
+YACAP_OPTIONTABLE(root_options, ROOT_OPTIONS);
+YACAP_OPTIONTABLE(qux_options, QUX_OPTIONS);
+YACAP_OPTIONTABLE(dup_options, DUP_OPTIONS);
+YACAP_OPTIONTABLE(many_options, MANY_OPTIONS);
+
+
+static const struct yacap_option *eaten[8];
+static char eatennames[8][8];
+static int eatencount;
+static bool eatenstable;
+
+
+/* the options eaten before must remain intact */
+static enum yacap_eatstatus
+_collect(const struct yacap_option *opt, const char *value, void *userptr) {
+    int i;
+
+    if ((opt == NULL) || (eatencount == 8)) {
+        return YACAP_EAT_UNRECOGNIZED;
+    }
+
+    for (i = 0; i < eatencount; i++) {
+        eatenstable &= strcmp(eatennames[i], eaten[i]->name) == 0;
+    }
+
+    strcpy(eatennames[eatencount], opt->name);
+    eaten[eatencount++] = opt;
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap_command qux = {
+    .name = "qux",
+    .eat = _eater,
+    .optiontable = &qux_options,
+};
+
+
+static void
+test_optiontable_layout() {
+    eqint(4, root_options.count);
+    eqstr("foo", root_options.pool + root_options.entries[0].name);
+    eqint(0, root_options.entries[0].arg);
+    eqstr("BAR", root_options.pool + root_options.entries[1].arg);
+    eqint(0, root_options.entries[2].key);
+    eqint(0, root_options.entries[3].name);
+    eqint(YACAP_OPTION_MULTIPLE, root_options.entries[3].flags);
+}
+
+
+static void
+test_optiontable_parse() {
+    const struct yacap_command *cmd;
+    struct yacap yacap = {
+        .eat = _eater,
+        .optiontable = &root_options,
+        .commands = (struct yacap_command * const[]) {
+            &qux,
+            NULL
+        },
+        .flags = YACAP_NO_CLOG,
+    };
+
+    memset(&args, 0, sizeof(args));
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo -f --bar=baz -VV",
+                &cmd));
+    eqptr(&yacap, cmd);
+    eqint(1, args.foo);
+    eqstr("baz", args.bar);
+    eqint(2, args.verbose);
+
+    memset(&args, 0, sizeof(args));
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo --foo qux -x", &cmd));
+    eqptr(&qux, cmd);
+    eqint(1, args.foo);
+    eqint(1, args.qux);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo --Misc:", NULL));
+    eqstr("foo: invalid option -- '--Misc:'\n"
+        "Try `foo --help' or `foo --usage' for more information.\n", err);
+
+    yacap.optiontable = &dup_options;
+    eqint(YACAP_FATAL, yacap_parse_string(&yacap, "foo", NULL));
+    eqstr("foo: option duplicated -- '-o/--foo'\n", err);
+}
+
+
+/* more entries are matched than the first block of unpacked options holds
+ */
+static void
+test_optiontable_unpacked() {
+    struct yacap yacap = {
+        .eat = _collect,
+        .optiontable = &many_options,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    eatencount = 0;
+    eatenstable = true;
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo -gedcb --alpha -a",
+                NULL));
+    eqint(7, eatencount);
+    istrue(eatenstable);
+    eqstr("golf", eatennames[0]);
+    eqstr("echo", eatennames[1]);
+    eqstr("delta", eatennames[2]);
+    eqstr("charlie", eatennames[3]);
+    eqstr("bravo", eatennames[4]);
+    eqstr("alpha", eatennames[5]);
+    eqptr(eaten[5], eaten[6]);
+}
+
+
+static void
+test_optiontable_help() {
+    struct yacap yacap = {
+        .eat = _eater,
+        .optiontable = &root_options,
+        .flags = YACAP_NO_CLOG,
+    };
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help", NULL));
+    eqstr("", err);
+    eqstr(
+        "Usage: foo [OPTION...]\n"
+        "\n"
+        "Options:\n"
+        "  -h, --help       Give this help list and exit\n"
+        "  -?, --usage      Give a short usage message and exit\n"
+        "  -f, --foo        Foo flag\n"
+        "  -b, --bar=BAR    Bar option with value\n"
+        "\n"
+        "Misc:              \n"
+        "  -V               \n", out);
+}
+
+
+int
+main() {
+    test_optiontable_layout();
+    test_optiontable_parse();
+    test_optiontable_unpacked();
+    test_optiontable_help();
+    return EXIT_SUCCESS;
+}
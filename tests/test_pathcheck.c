@@ -0,0 +1,140 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <unistd.h>
+
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "helpers.h"
+
+
+#define ARGVSIZE(a) (sizeof(a) / sizeof(char*))
+
+
+static char file[] = "/tmp/yacap-pathcheck-XXXXXX";
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap yacap = {
+    .eat = _eater,
+    .args = "[FILE...]",
+    .argflags = YACAP_OPTION_FILE,
+    .options = (const struct yacap_option[]) {
+        {"input", 'i', "FILE", YACAP_OPTION_FILE, NULL},
+        {"outdir", 'o', "DIR", YACAP_OPTION_DIRECTORY, NULL},
+        {"any", 'a', "PATH", YACAP_OPTION_FILE | YACAP_OPTION_MULTIPLE, NULL},
+        {"path", 'p', "PATH", YACAP_OPTION_FILE | YACAP_OPTION_DIRECTORY,
+            NULL},
+        {NULL}
+    },
+    .flags = YACAP_NO_CLOG,
+};
+
+
+static void
+test_pathcheck_reject() {
+    char line[256];
+
+    sprintf(line, "foo -i %s -o /tmp %s %s", file, file, file);
+    eqint(YACAP_OK, yacap_parse_string(&yacap, line, NULL));
+    eqstr("", out);
+    eqstr("", err);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo -i /tmp", NULL));
+    eqstr("", out);
+    eqstr("foo: not a regular file -- '/tmp'\n"
+        "Try `foo --help' or `foo --usage' for more information.\n", err);
+
+    sprintf(line, "foo --outdir %s", file);
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, line, NULL));
+    eqstr("", out);
+    sprintf(line, "foo: not a directory -- '%s'\n"
+        "Try `foo --help' or `foo --usage' for more information.\n", file);
+    eqstr(line, err);
+
+    sprintf(line, "foo %s /yacap/not/exists", file);
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, line, NULL));
+    eqstr("", out);
+    eqstr("foo: No such file or directory -- '/yacap/not/exists'\n"
+        "Try `foo --help' or `foo --usage' for more information.\n", err);
+
+    /* help should not touch the filesystem */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap,
+                "foo /yacap/not/exists --usage", NULL));
+    eqstr("", err);
+}
+
+
+static void
+test_pathcheck_fileordirectory() {
+    char line[256];
+
+    sprintf(line, "foo -p %s", file);
+    eqint(YACAP_OK, yacap_parse_string(&yacap, line, NULL));
+    eqstr("", err);
+
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo -p /tmp", NULL));
+    eqstr("", err);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo -p /dev/null",
+                NULL));
+    eqstr("foo: not a regular file -- '/dev/null'\n"
+        "Try `foo --help' or `foo --usage' for more information.\n", err);
+}
+
+
+static void
+test_pathcheck_stat() {
+    const struct stat *st;
+    const char *argv[] = {"foo", "-o", "/tmp", file};
+
+    eqint(YACAP_OK, yacap_parse(&yacap, ARGVSIZE(argv), argv, NULL));
+    st = yacap_pathstat(&yacap, "/tmp");
+    isnotnull(st);
+    istrue(S_ISDIR(st->st_mode));
+
+    st = yacap_pathstat(&yacap, file);
+    isnotnull(st);
+    istrue(S_ISREG(st->st_mode));
+
+    isnull(yacap_pathstat(&yacap, "/etc"));
+    yacap_dispose(&yacap);
+}
+
+
+int
+main() {
+    int fd = mkstemp(file);
+    if (fd == -1) {
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    test_pathcheck_reject();
+    test_pathcheck_fileordirectory();
+    test_pathcheck_stat();
+
+    unlink(file);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "command.h"
+#include "helpers.h"
+
+
+static struct yacap_prerendered pages[] = {
+    {
+        .helplen = 13,
+        .help = "\nprerendered\n",
+    },
+    {
+        .helplen = 13,
+        .compressedlen = 10,
+        .help = "\x03\nqux\x85\x00\x04\x00\n",
+    },
+    {
+        .helplen = 17,
+        .help = "\nbar prerendered\n",
+    },
+};
+
+
+static const struct yacap_prerender prerender = {
+    .pages = pages,
+    .count = 3,
+};
+
+
+/* as yacap_prerender_help() does at build time */
+static void
+_fingerprint(struct yacap_prerendered *p, const struct yacap *c,
+        const struct yacap_command *cmd) {
+    bool subcommand = cmd != (const struct yacap_command *)c;
+    uint64_t path = COMMAND_HASHBASIS;
+
+    if (subcommand) {
+        path = command_hash(path, cmd->name);
+    }
+
+    p->fingerprint = command_fingerprint(c, cmd, path, subcommand);
+}
+
+
+static struct yacap_command bar = {
+    .name = "bar",
+};
+
+
+static struct yacap_command baz = {
+    .name = "baz",
+};
+
+
+static struct yacap_command qux = {
+    .name = "qux",
+};
+
+
+static void
+test_prerender_help() {
+    struct yacap yacap = {
+        .args = "FOO",
+        .flags = YACAP_NO_CLOG,
+        .commands = (struct yacap_command * const[]) {
+            &bar,
+            &baz,
+            &qux,
+            NULL
+        },
+        .prerender = &prerender,
+    };
+
+    _fingerprint(&pages[0], &yacap, (struct yacap_command *)&yacap);
+    _fingerprint(&pages[1], &yacap, &qux);
+    _fingerprint(&pages[2], &yacap, &bar);
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help", NULL));
+    eqstr("Usage: foo [OPTION...] FOO\n\nprerendered\n", out);
+    eqstr("", err);
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo bar --help",
+                NULL));
+    eqstr("Usage: foo bar [OPTION...]\n\nbar prerendered\n", out);
+
+    /* not rendered at build time */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo baz --help",
+                NULL));
+    eqstr("Usage: foo baz [OPTION...]\n"
+        "\n"
+        "Options:\n"
+        "  -h, --help     Give this help list and exit\n"
+        "  -?, --usage    Give a short usage message and exit\n", out);
+
+    /* compressed */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo qux --help",
+                NULL));
+    eqstr("Usage: foo qux [OPTION...]\n\nqux\nqux\nqux\n", out);
+
+    /* rendered with different flags */
+    yacap.flags = YACAP_NO_CLOG | YACAP_NO_USAGE;
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help", NULL));
+    eqstr("Usage: foo [OPTION...] FOO\n"
+        "\n"
+        "Commands:\n"
+        "  bar\n"
+        "  baz\n"
+        "  qux\n"
+        "\n"
+        "Options:\n"
+        "  -h, --help    Give this help list and exit\n", out);
+
+    /* changed at runtime */
+    yacap.flags = YACAP_NO_CLOG;
+    qux.args = "QUX";
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo qux --help",
+                NULL));
+    eqstr("Usage: foo qux [OPTION...] QUX\n"
+        "\n"
+        "Options:\n"
+        "  -h, --help     Give this help list and exit\n"
+        "  -?, --usage    Give a short usage message and exit\n", out);
+    qux.args = NULL;
+}
+
+
+static void
+test_prerender_othertree() {
+    struct yacap other = {
+        .flags = YACAP_NO_CLOG,
+        .commands = (struct yacap_command * const[]) {
+            &bar,
+            &qux,
+            NULL
+        },
+        .prerender = &prerender,
+    };
+
+    /* the pages of a different root are not used */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&other, "foo --help", NULL));
+    eqstr("Usage: foo [OPTION...]\n"
+        "\n"
+        "Commands:\n"
+        "  bar\n"
+        "  qux\n"
+        "\n"
+        "Options:\n"
+        "  -h, --help     Give this help list and exit\n"
+        "  -?, --usage    Give a short usage message and exit\n", out);
+
+    /* but the sub-commands which are the same are */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&other, "foo bar --help",
+                NULL));
+    eqstr("Usage: foo bar [OPTION...]\n\nbar prerendered\n", out);
+
+    /* and nothing is without the prerender */
+    other.prerender = NULL;
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&other, "foo bar --help",
+                NULL));
+    eqstr("Usage: foo bar [OPTION...]\n"
+        "\n"
+        "Options:\n"
+        "  -h, --help     Give this help list and exit\n"
+        "  -?, --usage    Give a short usage message and exit\n", out);
+}
+
+
+int
+main() {
+    test_prerender_help();
+    test_prerender_othertree();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "command.h"
+#include "helpers.h"
+
+
+static struct yacap_prerendered pages[] = {
+    {
+        .helplen = 13,
+        .help = "\nprerendered\n",
+    },
+};
+
+
+/* as written by yacap_prerender_help(... STRIP) */
+static const struct yacap_prerender prerender = {
+    .pages = pages,
+    .count = 1,
+    .stripped = true,
+};
+
+
+static struct yacap_command baz = {
+    .name = "baz",
+};
+
+
+static void
+test_prerender_strip() {
+    struct yacap yacap = {
+        .flags = YACAP_NO_CLOG,
+        .commands = (struct yacap_command * const[]) {
+            &baz,
+            NULL
+        },
+        .prerender = &prerender,
+    };
+
+    pages[0].fingerprint = command_fingerprint(&yacap,
+            (struct yacap_command *)&yacap, COMMAND_HASHBASIS, false);
+
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo --help", NULL));
+    eqstr("Usage: foo [OPTION...]\n\nprerendered\n", out);
+
+    /* not rendered at build time, the doc strings are not there */
+    eqint(YACAP_OK_EXIT, yacap_parse_string(&yacap, "foo baz --help",
+                NULL));
+    eqstr("Usage: foo baz [OPTION...]\n"
+        "\n"
+        "The help is not available, it's stripped at build time.\n", out);
+}
+
+
+int
+main() {
+    test_prerender_strip();
+    return EXIT_SUCCESS;
+}
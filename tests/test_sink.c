@@ -0,0 +1,340 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/wait.h>
+
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "helpers.h"
+
+
+#define ARGVSIZE(a) (sizeof(a) / sizeof(char*))
+#define LOREM4 LOREM LOREM LOREM LOREM
+#define LOREM32 LOREM4 LOREM4 LOREM4 LOREM4 LOREM4 LOREM4 LOREM4 LOREM4
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap_command bar = {
+    .name = "bar",
+    .eat = _eater,
+    .args = "BAZ",
+    .footer = LOREM32,
+};
+
+
+static struct yacap yacap = {
+    .flags = YACAP_NO_CLOG,
+    .commands = (struct yacap_command * const[]) {
+        &bar,
+        NULL
+    },
+};
+
+
+static ssize_t
+_writer(const char *data, size_t len, void *userptr) {
+    size_t *total = userptr;
+
+    *total += len;
+    return len;
+}
+
+
+struct chunks {
+    char data[16384];
+    size_t len;
+    int calls;
+};
+
+
+/* takes 5 bytes at most, and nothing on each third call */
+static ssize_t
+_chunkwriter(const char *data, size_t len, void *userptr) {
+    struct chunks *c = userptr;
+
+    if ((++c->calls % 3) == 0) {
+        return 0;
+    }
+
+    len = len < 5? len: 5;
+    memcpy(c->data + c->len, data, len);
+    c->len += len;
+    return len;
+}
+
+
+static void
+test_sink_memory() {
+    char buff[64];
+    const char *argv[] = {"foo", "bar", "baz"};
+    struct yacap_sink sink = {
+        .type = YACAP_SINK_MEMORY,
+        .memory = {buff, sizeof(buff), 0},
+    };
+
+    eqint(YACAP_OK, yacap_parse(&yacap, ARGVSIZE(argv), argv, NULL));
+
+    eqint(7, yacap_commandchain_render(&yacap, &sink));
+    eqint(7, sink.memory.len);
+    eqnstr("foo bar", buff, 7);
+
+    sink.memory.len = 0;
+    eqint(31, yacap_usage_render(&yacap, &sink));
+    eqnstr("Usage: foo bar [OPTION...] BAZ\n", buff, 31);
+
+    /* truncated */
+    sink.memory.len = 0;
+    eqint(sizeof(buff), yacap_help_render(&yacap, &sink));
+    eqint(sizeof(buff), sink.memory.len);
+    eqnstr("Usage: foo bar [OPTION...] BAZ\n\nOptions:\n", buff, 41);
+
+    yacap_dispose(&yacap);
+}
+
+
+static void
+test_sink_file_callback() {
+    char *data = NULL;
+    size_t size = 0;
+    size_t total = 0;
+    const char *argv[] = {"foo", "bar", "baz"};
+    struct yacap_sink sink = {
+        .type = YACAP_SINK_FILE,
+        .file = open_memstream(&data, &size),
+    };
+
+    eqint(YACAP_OK, yacap_parse(&yacap, ARGVSIZE(argv), argv, NULL));
+    isnotnull(sink.file);
+    eqint(31, yacap_usage_render(&yacap, &sink));
+    fclose(sink.file);
+    eqstr("Usage: foo bar [OPTION...] BAZ\n", data);
+    free(data);
+
+    sink.type = YACAP_SINK_CALLBACK;
+    sink.callback.write = _writer;
+    sink.callback.userptr = &total;
+    eqint(7, yacap_commandchain_render(&yacap, &sink));
+    eqint(7, total);
+
+    yacap_dispose(&yacap);
+}
+
+
+static void
+test_sink_nonblocking() {
+    int p[2];
+    int rendered;
+    ssize_t bytes;
+    ssize_t pending;
+    size_t received = 0;
+    char buff[8192];
+    const char *argv[] = {"foo", "bar", "baz"};
+    struct yacap_sink sink = {.type = YACAP_SINK_FD};
+
+    eqint(0, pipe2(p, O_NONBLOCK));
+    istrue(fcntl(p[1], F_SETPIPE_SZ, 4096) >= 4096);
+    sink.fd = p[1];
+
+    eqint(YACAP_OK, yacap_parse(&yacap, ARGVSIZE(argv), argv, NULL));
+    rendered = yacap_help_render(&yacap, &sink);
+    istrue(rendered > fcntl(p[1], F_GETPIPE_SZ));
+    istrue(sink.pendinglen > 0);
+
+    /* drain the pipe and flush the rest */
+    do {
+        bytes = read(p[0], buff, sizeof(buff));
+        if (bytes > 0) {
+            received += bytes;
+        }
+        pending = yacap_sink_flush(&sink);
+        istrue(pending >= 0);
+    } while (pending || (bytes > 0));
+
+    eqint(rendered, received);
+    isnull(sink.pending);
+    yacap_sink_dispose(&sink);
+    yacap_dispose(&yacap);
+    close(p[0]);
+    close(p[1]);
+}
+
+
+static void
+test_sink_callback_partial() {
+    int rendered;
+    char buff[16384];
+    struct chunks chunks = {.len = 0};
+    const char *argv[] = {"foo", "bar", "baz"};
+    struct yacap_sink memory = {
+        .type = YACAP_SINK_MEMORY,
+        .memory = {buff, sizeof(buff), 0},
+    };
+    struct yacap_sink sink = {
+        .type = YACAP_SINK_CALLBACK,
+        .callback = {_chunkwriter, &chunks},
+    };
+
+    eqint(YACAP_OK, yacap_parse(&yacap, ARGVSIZE(argv), argv, NULL));
+    rendered = yacap_help_render(&yacap, &memory);
+    eqint(rendered, yacap_help_render(&yacap, &sink));
+    istrue(sink.pendinglen > 0);
+
+    /* the rest is given to the callback on flush */
+    while (yacap_sink_flush(&sink) > 0) {
+    }
+
+    isnull(sink.pending);
+    eqint(rendered, chunks.len);
+    eqnstr(buff, chunks.data, rendered);
+    yacap_sink_dispose(&sink);
+    yacap_dispose(&yacap);
+}
+
+
+struct reentrant {
+    char usage[1024];
+    size_t len;
+    char chain[64];
+    struct yacap_sink inner;
+};
+
+
+/* renders the command chain while the usage is written */
+static ssize_t
+_reentrantwriter(const char *data, size_t len, void *userptr) {
+    struct reentrant *r = userptr;
+
+    if (r->inner.memory.len == 0) {
+        yacap_commandchain_render(&yacap, &r->inner);
+    }
+
+    memcpy(r->usage + r->len, data, len);
+    r->len += len;
+    return len;
+}
+
+
+/* a render within another one doesn't clobber the outer one's buffer */
+static void
+test_sink_reentrant() {
+    char buff[1024];
+    const char *argv[] = {"foo", "bar", "baz"};
+    struct yacap_sink memory = {
+        .type = YACAP_SINK_MEMORY,
+        .memory = {buff, sizeof(buff), 0},
+    };
+    struct reentrant r = {
+        .len = 0,
+        .inner = {
+            .type = YACAP_SINK_MEMORY,
+            .memory = {r.chain, sizeof(r.chain), 0},
+        },
+    };
+    struct yacap_sink sink = {
+        .type = YACAP_SINK_CALLBACK,
+        .callback = {_reentrantwriter, &r},
+    };
+
+    eqint(YACAP_OK, yacap_parse(&yacap, ARGVSIZE(argv), argv, NULL));
+    yacap_usage_render(&yacap, &memory);
+    eqint(memory.memory.len, yacap_usage_render(&yacap, &sink));
+    eqint(memory.memory.len, r.len);
+    eqnstr(buff, r.usage, r.len);
+    eqint(7, r.inner.memory.len);
+    eqnstr("foo bar", r.chain, 7);
+
+    /* the scratch is released */
+    r.len = 0;
+    r.inner.memory.len = 0;
+    eqint(memory.memory.len, yacap_usage_render(&yacap, &sink));
+    eqnstr(buff, r.usage, r.len);
+    yacap_sink_dispose(&sink);
+    yacap_dispose(&yacap);
+}
+
+
+static void
+test_sink_print_nonblocking() {
+    int p[2];
+    int status;
+    int stdoutfd;
+    int rendered;
+    char buff[16384];
+    ssize_t bytes;
+    size_t received = 0;
+    pid_t reader;
+    const char *argv[] = {"foo", "bar", "baz"};
+    struct yacap_sink memory = {
+        .type = YACAP_SINK_MEMORY,
+        .memory = {buff, sizeof(buff), 0},
+    };
+
+    eqint(YACAP_OK, yacap_parse(&yacap, ARGVSIZE(argv), argv, NULL));
+    rendered = yacap_help_render(&yacap, &memory);
+
+    eqint(0, pipe2(p, O_NONBLOCK));
+    istrue(fcntl(p[1], F_SETPIPE_SZ, 4096) >= 4096);
+    istrue(rendered > fcntl(p[1], F_GETPIPE_SZ));
+
+    /* reads it all after the pipe is full, and exits with the count */
+    reader = fork();
+    istrue(reader >= 0);
+    if (reader == 0) {
+        close(p[1]);
+        usleep(100000);
+        fcntl(p[0], F_SETFL, 0);
+        while ((bytes = read(p[0], buff, sizeof(buff))) > 0) {
+            received += bytes;
+        }
+        _exit(received == rendered? 0: 1);
+    }
+
+    close(p[0]);
+    stdoutfd = dup(STDOUT_FILENO);
+    dup2(p[1], STDOUT_FILENO);
+    close(p[1]);
+    yacap_help_print(&yacap);
+    dup2(stdoutfd, STDOUT_FILENO);
+    close(stdoutfd);
+
+    eqint(reader, waitpid(reader, &status, 0));
+    istrue(WIFEXITED(status));
+    eqint(0, WEXITSTATUS(status));
+    yacap_dispose(&yacap);
+}
+
+
+int
+main() {
+    test_sink_memory();
+    test_sink_file_callback();
+    test_sink_nonblocking();
+    test_sink_callback_partial();
+    test_sink_reentrant();
+    test_sink_print_nonblocking();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,214 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdlib.h>
+
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "helpers.h"
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap_command qux = {
+    .name = "qux",
+    .args = "[FILE]",
+    .eat = _eater,
+};
+
+
+static struct yacap_option options[] = {
+    {"foo", 'f', NULL, 0, "Foo flag"},
+    {"bar", 'b', "BAR", 0, "Bar option"},
+    {NULL}
+};
+
+
+struct calls {
+    unsigned int allocs;
+    unsigned int reallocs;
+};
+
+
+static void *
+_alloc(size_t size, void *userptr) {
+    struct calls *calls = userptr;
+
+    calls->allocs++;
+    return malloc(size);
+}
+
+
+static void *
+_realloc(void *ptr, size_t oldsize, size_t size, void *userptr) {
+    struct calls *calls = userptr;
+
+    calls->reallocs++;
+    return realloc(ptr, size);
+}
+
+
+static void
+_free(void *ptr, void *userptr) {
+    free(ptr);
+}
+
+
+static void
+test_stats() {
+    const struct yacap_stats *s;
+    const char *argv[] = {"foo", "-f", "--bar", "baz", "qux", "file"};
+    struct yacap yacap = {
+        .options = options,
+        .eat = _eater,
+        .flags = YACAP_NO_CLOG,
+        .commands = (struct yacap_command *const[]) {&qux, NULL},
+    };
+
+    isnull(yacap_stats(&yacap));
+    eqint(YACAP_OK, yacap_parse(&yacap, 6, argv, NULL));
+    s = yacap_stats(&yacap);
+    isnotnull(s);
+    eqint(6, s->tokens);
+    eqint(1, s->longlookups);
+    eqint(1, s->shortlookups);
+    eqint(2, s->commandlookups);
+
+    /* --help, --usage, --foo, --bar and qux */
+    eqint(5, s->comparisons);
+    eqint(1, s->depth);
+    istrue(s->allocations > 1);
+    istrue(s->allocated > 0);
+    istrue(s->totalns >= (s->setupns + s->parsens + s->pathcheckns));
+
+    yacap_dispose(&yacap);
+    isnull(yacap_stats(&yacap));
+}
+
+
+static void
+test_stats_allocator() {
+    const struct yacap_stats *s;
+    const char *argv[] = {"foo", "-fx", "qux"};
+    struct yacap_error error;
+    struct calls calls = {0, 0};
+    struct yacap_allocator allocator = {
+        .alloc = _alloc,
+        .realloc = _realloc,
+        .free = _free,
+        .userptr = &calls,
+    };
+    struct yacap yacap = {
+        .options = options,
+        .eat = _eater,
+        .flags = YACAP_NO_CLOG,
+        .allocator = &allocator,
+        .commands = (struct yacap_command *const[]) {&qux, NULL},
+    };
+
+    yacap.error = &error;
+    eqint(YACAP_USERERROR, yacap_parse(&yacap, 3, argv, NULL));
+    s = yacap_stats(&yacap);
+    eqint(calls.allocs, s->allocations);
+    eqint(calls.reallocs, s->reallocations);
+    eqint(3, s->tokens);
+    eqint(2, s->shortlookups);
+    eqint(0, s->depth);
+    yacap_dispose(&yacap);
+}
+
+
+static struct calls _innercalls;
+static struct yacap_allocator _innerallocator = {
+    .alloc = _alloc,
+    .realloc = _realloc,
+    .free = _free,
+    .userptr = &_innercalls,
+};
+static struct yacap _inner = {
+    .options = options,
+    .eat = _eater,
+    .flags = YACAP_NO_CLOG,
+    .allocator = &_innerallocator,
+};
+
+
+/* parses and renders another tree */
+static enum yacap_eatstatus
+_nestedeater(const struct yacap_option *opt, const char *value,
+        void *userptr) {
+    char buff[4096];
+    const char *argv[] = {"inner", "--bar=baz", "--foo"};
+    struct yacap_sink sink = {
+        .type = YACAP_SINK_MEMORY,
+        .memory = {buff, sizeof(buff), 0},
+    };
+
+    if (yacap_parse(&_inner, 3, argv, NULL) != YACAP_OK) {
+        return YACAP_EAT_UNRECOGNIZED;
+    }
+
+    yacap_help_render(&_inner, &sink);
+    yacap_dispose(&_inner);
+    return YACAP_EAT_OK;
+}
+
+
+/* the allocations of a parse started by an eater, and of it's renders,
+ * are not counted into the outer parse */
+static void
+test_stats_nested() {
+    const struct yacap_stats *s;
+    const char *argv[] = {"foo", "-f", "qux"};
+    struct calls calls = {0, 0};
+    struct yacap_allocator allocator = {
+        .alloc = _alloc,
+        .realloc = _realloc,
+        .free = _free,
+        .userptr = &calls,
+    };
+    struct yacap yacap = {
+        .options = options,
+        .eat = _nestedeater,
+        .flags = YACAP_NO_CLOG,
+        .allocator = &allocator,
+        .commands = (struct yacap_command *const[]) {&qux, NULL},
+    };
+
+    eqint(YACAP_OK, yacap_parse(&yacap, 3, argv, NULL));
+    istrue(_innercalls.allocs > 1);
+    s = yacap_stats(&yacap);
+    eqint(calls.allocs, s->allocations);
+    eqint(calls.reallocs, s->reallocations);
+    eqint(1, s->depth);
+    yacap_dispose(&yacap);
+}
+
+
+int
+main() {
+    test_stats();
+    test_stats_allocator();
+    test_stats_nested();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <cutest.h>
+
+#include "suggest.c"
+#include "helpers.h"
+
+
+static int
+_levenshtein(const char *a, int alen, const char *b, int blen) {
+    int i;
+    int j;
+    int d[alen + 1][blen + 1];
+
+    for (i = 0; i <= alen; i++) {
+        d[i][0] = i;
+    }
+
+    for (j = 0; j <= blen; j++) {
+        d[0][j] = j;
+    }
+
+    for (i = 1; i <= alen; i++) {
+        for (j = 1; j <= blen; j++) {
+            d[i][j] = MIN(MIN(d[i - 1][j] + 1, d[i][j - 1] + 1),
+                    d[i - 1][j - 1] + (a[i - 1] != b[j - 1]));
+        }
+    }
+
+    return d[alen][blen];
+}
+
+
+static void
+test_suggest_distance() {
+    int i;
+    int j;
+    int alen;
+    int blen;
+    int expected;
+    char a[SUGGEST_PATTERN_MAX];
+    char b[SUGGEST_PATTERN_MAX + 8];
+    struct suggest s;
+
+    suggest_init(&s, "kitten", 6);
+    eqint(3, suggest_distance(&s, "sitting", 7, 10));
+    eqint(0, suggest_distance(&s, "kitten", 6, 10));
+    eqint(6, suggest_distance(&s, "", 0, 10));
+    eqint(2, suggest_distance(&s, "sitting", 7, 1));
+    eqint(2, suggest_distance(&s, "kittenish", 9, 1));
+
+    /* against the textbook algorithm, the alphabet is small to have some
+     * matches */
+    srand(7);
+    for (i = 0; i < 2000; i++) {
+        alen = 1 + rand() % SUGGEST_PATTERN_MAX;
+        blen = rand() % sizeof(b);
+        for (j = 0; j < alen; j++) {
+            a[j] = 'a' + rand() % 4;
+        }
+        for (j = 0; j < blen; j++) {
+            b[j] = 'a' + rand() % 4;
+        }
+
+        expected = _levenshtein(a, alen, b, blen);
+        suggest_init(&s, a, alen);
+        eqint(expected, suggest_distance(&s, b, blen, 1000));
+        eqint(MIN(expected, 3), suggest_distance(&s, b, blen, 2));
+    }
+}
+
+
+static void
+test_suggest_feed() {
+    struct suggest s;
+
+    suggest_init(&s, "verbosty", 8);
+    suggest_feed(&s, "version");
+    suggest_feed(&s, "verbose");
+    suggest_feed(&s, NULL);
+    suggest_feed(&s, "verbosity");
+    suggest_feed(&s, "verbositx");
+    eqstr("verbosity", s.best);
+
+    /* the first of the nearest ones wins */
+    suggest_init(&s, "bat", 3);
+    suggest_feed(&s, "bar");
+    suggest_feed(&s, "baz");
+    eqstr("bar", s.best);
+
+    /* too far */
+    suggest_init(&s, "qux", 3);
+    suggest_feed(&s, "foo");
+    suggest_feed(&s, "quxquux");
+    isnull(s.best);
+
+    /* single characters are never near */
+    suggest_init(&s, "x", 1);
+    suggest_feed(&s, "y");
+    isnull(s.best);
+
+    suggest_init(&s, "", 0);
+    suggest_feed(&s, "");
+    isnull(s.best);
+}
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    return YACAP_EAT_OK;
+}
+
+
+static struct yacap_command add = {
+    .name = "add",
+    .eat = _eater,
+};
+
+
+static struct yacap_command delete = {
+    .name = "delete",
+    .eat = _eater,
+};
+
+
+static void
+test_suggest_parse() {
+    struct yacap_error e;
+    struct yacap yacap = {
+        .options = (const struct yacap_option[]) {
+            {"Group:", 0, NULL, 0, NULL},
+            {"foo", 'f', NULL, 0, NULL},
+            {"verbose", 'V', NULL, 0, NULL},
+            {NULL}
+        },
+        .commands = (struct yacap_command*[]) {
+            &add,
+            &delete,
+            NULL
+        },
+        .flags = YACAP_NO_CLOG,
+    };
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo --fop", NULL));
+    eqstr("", out);
+    eqstr("foo: invalid option -- '--fop'\n"
+        "Did you mean '--foo'?\n"
+        "Try `foo --help' or `foo --usage' for more information.\n", err);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo --usag", NULL));
+    eqstr("foo: invalid option -- '--usag'\n"
+        "Did you mean '--usage'?\n"
+        "Try `foo --help' or `foo --usage' for more information.\n", err);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo --qux", NULL));
+    eqstr("foo: invalid option -- '--qux'\n"
+        "Try `foo --help' or `foo --usage' for more information.\n", err);
+
+    /* sub-command options */
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo add --verbos=1",
+                NULL));
+    eqstr("foo add: invalid option -- '--verbos=1'\n"
+        "Did you mean '--verbose'?\n"
+        "Try `foo add --help' or `foo add --usage' for more information.\n",
+        err);
+
+    /* sub-commands */
+    eqint(YACAP_FATAL, yacap_parse_string(&yacap, "foo delet", NULL));
+    eqstr("foo: argument not eaten -- 'delet'\n"
+        "Did you mean 'delete'?\n", err);
+
+    yacap.error = &e;
+    eqint(YACAP_FATAL, yacap_parse_string(&yacap, "foo ad", NULL));
+    eqstr("", err);
+    eqint(YACAP_ERR_POSITIONAL_NOTEATEN, e.code);
+    eqstr("add", e.suggestion);
+
+    eqint(YACAP_USERERROR, yacap_parse_string(&yacap, "foo -x", NULL));
+    eqint(YACAP_ERR_OPTION_UNRECOGNIZED, e.code);
+    isnull(e.suggestion);
+}
+
+
+int
+main() {
+    test_suggest_distance();
+    test_suggest_feed();
+    test_suggest_parse();
+    return EXIT_SUCCESS;
+}
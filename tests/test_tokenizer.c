@@ -67,10 +67,10 @@ test_tokenizer() {
         "--foo",
     };
 
-    optiondb_init(&optdb);
+    optiondb_init(&optdb, NULL);
     optiondb_insertvector(&optdb, options1, NULL);
     optiondb_insertvector(&optdb, options2, NULL);
-    struct tokenizer *t = tokenizer_new(ARGVSIZE(argv), argv, &optdb);
+    struct tokenizer *t = tokenizer_new(ARGVSIZE(argv), argv, &optdb, NULL);
     isnotnull(t);
 
     /* foo */
@@ -212,10 +212,10 @@ test_tokenizer_error() {
         "foo",
     };
 
-    optiondb_init(&optdb);
+    optiondb_init(&optdb, NULL);
     optiondb_insertvector(&optdb, options1, NULL);
     optiondb_insertvector(&optdb, options2, NULL);
-    struct tokenizer *t = tokenizer_new(3, argv, &optdb);
+    struct tokenizer *t = tokenizer_new(3, argv, &optdb, NULL);
     isnotnull(t);
 
     /* foo */
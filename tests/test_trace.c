@@ -0,0 +1,130 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cutest.h>
+
+#include "include/yacap.h"
+#include "helpers.h"
+
+
+static enum yacap_eatstatus
+_eater(const struct yacap_option *opt, const char *value, void *userptr) {
+    return YACAP_EAT_OK;
+}
+
+
+static int
+_init(struct yacap_command *command) {
+    return 0;
+}
+
+
+static struct yacap_command qux = {
+    .name = "qux",
+    .args = "[FILE]",
+    .init = _init,
+    .eat = _eater,
+};
+
+
+static struct yacap_option options[] = {
+    {"foo", 'f', NULL, 0, "Foo flag"},
+    {"bar", 'b', "BAR", 0, "Bar option"},
+    {NULL}
+};
+
+
+static struct yacap yacap = {
+    .options = options,
+    .eat = _eater,
+    .flags = YACAP_NO_CLOG,
+    .commands = (struct yacap_command *const[]) {&qux, NULL},
+};
+
+
+static void
+test_trace_disabled() {
+    unsetenv("YACAP_TRACE");
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo -f qux file", NULL));
+    eqstr("", err);
+    yacap_dispose(&yacap);
+}
+
+
+static void
+test_trace_summary() {
+    setenv("YACAP_TRACE", "summary", 1);
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo -f -b bar qux file",
+                NULL));
+    unsetenv("YACAP_TRACE");
+    yacap_dispose(&yacap);
+
+    istrue(strncmp(err, "yacap trace of foo: ", 20) == 0);
+    isnotnull(strstr(err, "\n  yacap "));
+    isnotnull(strstr(err, "\n  init "));
+    isnotnull(strstr(err, "1 call(s), slowest: qux "));
+    isnotnull(strstr(err, "3 call(s), slowest: "));
+}
+
+
+static void
+test_trace_chrome() {
+    FILE *f;
+    char path[] = "/tmp/yacap-trace-XXXXXX";
+    char trace[2048];
+    size_t len;
+
+    close(mkstemp(path));
+    setenv("YACAP_TRACE", path, 1);
+    eqint(YACAP_OK, yacap_parse_string(&yacap, "foo -f -b bar qux file",
+                NULL));
+    unsetenv("YACAP_TRACE");
+    yacap_dispose(&yacap);
+    eqstr("", err);
+
+    f = fopen(path, "r");
+    isnotnull(f);
+    len = fread(trace, 1, sizeof(trace) - 1, f);
+    trace[len] = 0;
+    fclose(f);
+    unlink(path);
+
+    istrue(strncmp(trace, "{\"traceEvents\": [\n", 18) == 0);
+    isnotnull(strstr(trace, "{\"name\": \"parse\", \"cat\": \"parse\", "
+                "\"ph\": \"X\", \"ts\": "));
+    isnotnull(strstr(trace, "{\"name\": \"setup\", \"cat\": \"setup\""));
+    isnotnull(strstr(trace, "{\"name\": \"--foo\", \"cat\": \"eat\""));
+    isnotnull(strstr(trace, "{\"name\": \"--bar\", \"cat\": \"eat\""));
+    isnotnull(strstr(trace, "{\"name\": \"qux\", \"cat\": \"init\""));
+    isnotnull(strstr(trace, "{\"name\": \"positional\", \"cat\": \"eat\""));
+    isnotnull(strstr(trace, "{\"name\": \"pathcheck\""));
+    eqstr("}\n]}\n", trace + len - 5);
+}
+
+
+int
+main() {
+    test_trace_disabled();
+    test_trace_summary();
+    test_trace_chrome();
+    return EXIT_SUCCESS;
+}
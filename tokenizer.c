@@ -22,11 +22,14 @@
 #include <string.h>
 
 #include "config.h"
+#include "allocator.h"
 #include "option.h"
 #include "tokenizer.h"
+#include "probes.h"
 
 
 struct tokenizer {
+    const struct yacap_allocator *allocator;
     const struct optiondb *optiondb;
     int argc;
     const char **argv;
@@ -49,6 +52,8 @@ struct tokenizer {
         token->text = v; \
         token->len = l; \
         token->optioninfo = opt; \
+        token->argindex = t->w; \
+        token->offset = t->c; \
         return YACAP_TOK_OPTION; \
         case __LINE__:; \
     } while (0)
@@ -59,6 +64,8 @@ struct tokenizer {
         token->text = tok; \
         token->len = l; \
         token->optioninfo = NULL; \
+        token->argindex = t->w; \
+        token->offset = t->c; \
         return YACAP_TOK_UNKNOWN; \
         case __LINE__:; \
     } while (0)
@@ -69,6 +76,8 @@ struct tokenizer {
         token->text = v; \
         token->len = l; \
         token->optioninfo = NULL; \
+        token->argindex = t->w; \
+        token->offset = 0; \
         return YACAP_TOK_POSITIONAL; \
         case __LINE__:; \
     } while (0)
@@ -79,6 +88,8 @@ struct tokenizer {
     token->text = NULL; \
     token->len = 0; \
     token->optioninfo = NULL; \
+    token->argindex = t->w; \
+    token->offset = 0; \
     return YACAP_TOK_ERROR
 
 
@@ -87,6 +98,8 @@ struct tokenizer {
     token->text = NULL; \
     token->len = 0; \
     token->optioninfo = NULL; \
+    token->argindex = t->argc; \
+    token->offset = 0; \
     return YACAP_TOK_END
 
 
@@ -96,13 +109,16 @@ struct tokenizer {
 
 struct tokenizer *
 tokenizer_new(int argc, const char **argv,
-        const struct optiondb *optdb) {
-    struct tokenizer *t = malloc(sizeof(struct tokenizer));
+        const struct optiondb *optdb, const struct yacap_allocator *a) {
+    struct tokenizer *t = allocator_alloc(a, sizeof(struct tokenizer));
     if (t == NULL) {
         return NULL;
     }
 
+    t->allocator = a;
     t->line = 0;
+    t->w = 0;
+    t->c = 0;
     t->optiondb = optdb;
     t->argc = argc;
     t->argv = argv;
@@ -117,18 +133,19 @@ tokenizer_dispose(struct tokenizer *t) {
         return;
     }
 
-    free(t);
+    allocator_free(t->allocator, t);
 }
 
 
-enum tokenizer_status
-tokenizer_next(struct tokenizer *t, struct token *token) {
+static enum tokenizer_status
+_next(struct tokenizer *t, struct token *token) {
     const char *eq;
 
     START;
     for (t->w = 0; t->w < t->argc; t->w++) {
         t->tok = t->argv[t->w];
         t->optioninfo = NULL;
+        t->c = 0;
 
         if (t->tok == NULL) {
             REJECT;
@@ -186,7 +203,7 @@ tokenizer_next(struct tokenizer *t, struct token *token) {
                     YIELD_OPT_UNKNOWN(t->tok + t->c, 1);
                     break;
                 }
-                else if (YACAP_OPTION_ARGNEEDED(t->optioninfo->option) &&
+                else if (optioninfo_arg(t->optioninfo) &&
                         ((t->c + 1) < t->toklen)) {
                     YIELD_OPT(t->optioninfo, t->tok + t->c + 1,
                             strlen(t->tok + t->c + 1));
@@ -207,3 +224,13 @@ positional:
 
     END;
 }
+
+
+enum tokenizer_status
+tokenizer_next(struct tokenizer *t, struct token *token) {
+    enum tokenizer_status status = _next(t, token);
+
+    PROBE_TOKEN(status, token->argindex, token->offset,
+            token->optioninfo? optioninfo_key(token->optioninfo): 0);
+    return status;
+}
@@ -26,7 +26,11 @@
 struct token {
     const char *text;
     unsigned int len;
-    const struct optioninfo *optioninfo;
+    struct optioninfo *optioninfo;
+
+    /* argv index and byte offset of the token */
+    int argindex;
+    int offset;
 };
 
 
@@ -41,13 +45,15 @@ enum tokenizer_status {
 
 struct tokenizer *
 tokenizer_new(int argc, const char **argv,
-        const struct optiondb *optdb);
+        const struct optiondb *optdb, const struct yacap_allocator *a);
 
 
 void
 tokenizer_dispose(struct tokenizer *t);
 
 
+/* linear in the word length times the options of the command chain, a
+ * short option cluster looks each character up */
 enum tokenizer_status
 tokenizer_next(struct tokenizer *t, struct token *token);
 
@@ -0,0 +1,260 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "include/yacap.h"
+#include "helpers.h"
+#include "allocator.h"
+#include "buff.h"
+#include "trace.h"
+
+
+#define EVENTS_CHUNK 32
+#define SUMMARY_BUFFSIZE 512
+#define NAME_BUFFSIZE 64
+#define US(ns) ((ns) / 1000.0)
+
+/* an event is left open when the parse fails halfway */
+#define DURATION(e) (((e)->end > (e)->start)? (e)->end - (e)->start: 0)
+
+
+static const char *_kindnames[TRACE_KINDS] = {
+    "parse", "setup", "init", "eat", "pathcheck",
+};
+
+
+static uint64_t
+_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/* the option as given on the command line, or the command name */
+static const char *
+_name(const struct traceevent *e, char *buff, size_t size) {
+    const struct yacap_option *opt = e->subject;
+
+    switch (e->kind) {
+        case TRACE_INIT:
+            return ((const struct yacap_command *)e->subject)->name;
+
+        case TRACE_EAT:
+            if (opt == NULL) {
+                return "positional";
+            }
+
+            if (opt->name) {
+                snprintf(buff, size, "--%s", opt->name);
+            }
+            else {
+                snprintf(buff, size, "-%c", opt->key);
+            }
+            return buff;
+
+        default:
+            return _kindnames[e->kind];
+    }
+}
+
+
+struct trace *
+trace_new(const char *output, const struct yacap_allocator *a) {
+    struct trace *t;
+
+    if (output == NULL) {
+        return NULL;
+    }
+
+    t = allocator_alloc(a, sizeof(struct trace));
+    if (t == NULL) {
+        return NULL;
+    }
+
+    t->output = output;
+    t->allocator = a;
+    t->events = NULL;
+    t->count = 0;
+    t->size = 0;
+    t->origin = _now();
+    if (trace_begin(t, TRACE_PARSE, NULL)) {
+        trace_free(t);
+        return NULL;
+    }
+
+    return t;
+}
+
+
+void
+trace_free(struct trace *t) {
+    if (t == NULL) {
+        return;
+    }
+
+    allocator_free(t->allocator, t->events);
+    allocator_free(t->allocator, t);
+}
+
+
+int
+trace_begin(struct trace *t, enum tracekind kind, const void *subject) {
+    struct traceevent *new;
+    struct traceevent *e;
+
+    if (t->count == t->size) {
+        new = allocator_realloc(t->allocator, t->events,
+                t->count * sizeof(struct traceevent),
+                (t->size + EVENTS_CHUNK) * sizeof(struct traceevent));
+        if (new == NULL) {
+            return -1;
+        }
+        t->events = new;
+        t->size += EVENTS_CHUNK;
+    }
+
+    e = t->events + t->count;
+    e->kind = kind;
+    e->subject = subject;
+    e->end = 0;
+    e->start = _now() - t->origin;
+    return t->count++;
+}
+
+
+void
+trace_end(struct trace *t, int event) {
+    if (event < 0) {
+        return;
+    }
+
+    t->events[event].end = _now() - t->origin;
+}
+
+
+/* the time of the init hooks and the eaters, and the rest of the parse
+ * which is yacap's own */
+static int
+_summary(struct trace *t, const char *prog) {
+    int i;
+    enum tracekind k;
+    struct traceevent *e;
+    uint64_t total[TRACE_KINDS] = {0};
+    int count[TRACE_KINDS] = {0};
+    int slowest[TRACE_KINDS] = {0};
+    uint64_t longest[TRACE_KINDS] = {0};
+    uint64_t self;
+    char name[NAME_BUFFSIZE];
+    char tmp[SUMMARY_BUFFSIZE];
+    struct buff b;
+
+    for (i = 0; i < t->count; i++) {
+        e = t->events + i;
+        k = e->kind;
+        total[k] += DURATION(e);
+        if ((count[k]++ == 0) || (DURATION(e) > longest[k])) {
+            longest[k] = DURATION(e);
+            slowest[k] = i;
+        }
+    }
+
+    self = total[TRACE_PARSE] - total[TRACE_INIT] - total[TRACE_EAT];
+    buff_init(&b, tmp, sizeof(tmp));
+    buff_printf(&b, "yacap trace of %s: %.1fus\n", prog,
+            US(total[TRACE_PARSE]));
+    buff_printf(&b, "  yacap %10.1fus  setup %.1fus, pathcheck %.1fus\n",
+            US(self), US(total[TRACE_SETUP]), US(total[TRACE_PATHCHECK]));
+
+    for (k = TRACE_INIT; k <= TRACE_EAT; k++) {
+        buff_printf(&b, "  %-5s %10.1fus  %d call(s)", _kindnames[k],
+                US(total[k]), count[k]);
+        if (count[k]) {
+            e = t->events + slowest[k];
+            buff_printf(&b, ", slowest: %s %.1fus",
+                    _name(e, name, sizeof(name)), US(DURATION(e)));
+        }
+        buff_printf(&b, "\n");
+    }
+
+    return buff_flush(&b, STDERR_FILENO) == -1? -1: 0;
+}
+
+
+static void
+_jsonstring(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if ((*s == '"') || (*s == '\\')) {
+            fprintf(f, "\\%c", *s);
+        }
+        else if ((unsigned char)*s < 32) {
+            fprintf(f, "\\u%04x", *s);
+        }
+        else {
+            fputc(*s, f);
+        }
+    }
+    fputc('"', f);
+}
+
+
+/* complete events of the Chrome trace event format, which is loaded by
+ * chrome://tracing and Perfetto */
+static int
+_chrome(struct trace *t) {
+    int i;
+    struct traceevent *e;
+    char name[NAME_BUFFSIZE];
+    pid_t pid = getpid();
+    FILE *f = fopen(t->output, "w");
+
+    if (f == NULL) {
+        return -1;
+    }
+
+    fprintf(f, "{\"traceEvents\": [\n");
+    for (i = 0; i < t->count; i++) {
+        e = t->events + i;
+        fprintf(f, "  {\"name\": ");
+        _jsonstring(f, _name(e, name, sizeof(name)));
+        fprintf(f, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, "
+                "\"dur\": %.3f, \"pid\": %d, \"tid\": %d}%s\n",
+                _kindnames[e->kind], US(e->start), US(DURATION(e)),
+                pid, pid, (i + 1) < t->count? ",": "");
+    }
+    fprintf(f, "]}\n");
+
+    return fclose(f)? -1: 0;
+}
+
+
+int
+trace_write(struct trace *t, const char *prog) {
+    trace_end(t, 0);
+    if (STREQ(t->output, "summary")) {
+        return _summary(t, prog);
+    }
+
+    return _chrome(t);
+}
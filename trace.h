@@ -0,0 +1,102 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of yacap.
+ *  yacap is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  yacap is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with yacap. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef TRACE_H_
+#define TRACE_H_
+
+
+#include <stdint.h>
+
+#include "include/yacap.h"
+#include "config.h"
+
+
+/* the parse is traced when the YACAP_TRACE environment variable is set, to
+ * "summary" for a summary on the stderr, or to a file name to write a
+ * Chrome trace into. */
+enum tracekind {
+    TRACE_PARSE,
+    TRACE_SETUP,
+    TRACE_INIT,
+    TRACE_EAT,
+    TRACE_PATHCHECK,
+    TRACE_KINDS,
+};
+
+
+struct traceevent {
+    enum tracekind kind;
+
+    /* the command of TRACE_INIT, the option of TRACE_EAT or NULL for the
+     * positionals */
+    const void *subject;
+
+    /* nanoseconds since the start of the parse */
+    uint64_t start;
+    uint64_t end;
+};
+
+
+struct trace {
+    const char *output;
+    uint64_t origin;
+    struct traceevent *events;
+    int count;
+    int size;
+    const struct yacap_allocator *allocator;
+};
+
+
+/* a single branch per event when not tracing */
+#ifdef YACAP_USE_TRACE
+#define TRACE_BEGIN(s, k, x) ((s)->trace? trace_begin((s)->trace, k, x): -1)
+#define TRACE_END(s, e) do { \
+        if ((s)->trace) { \
+            trace_end((s)->trace, e); \
+        } \
+    } while (0)
+#else
+#define TRACE_BEGIN(s, k, x) (-1)
+#define TRACE_END(s, e) ((void)(e))
+#endif
+
+
+/* starts the TRACE_PARSE event, returns NULL when output is NULL */
+struct trace *
+trace_new(const char *output, const struct yacap_allocator *a);
+
+
+void
+trace_free(struct trace *t);
+
+
+/* returns the event index, or -1 when it's dropped */
+int
+trace_begin(struct trace *t, enum tracekind kind, const void *subject);
+
+
+void
+trace_end(struct trace *t, int event);
+
+
+/* ends the TRACE_PARSE event and writes the trace */
+int
+trace_write(struct trace *t, const char *prog);
+
+
+#endif  // TRACE_H_
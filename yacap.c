@@ -26,6 +26,7 @@
 #include "config.h"
 #include "state.h"
 #include "helpers.h"
+#include "allocator.h"
 #include "builtin.h"
 #include "arghint.h"
 #include "command.h"
@@ -33,60 +34,117 @@
 #include "help.h"
 #include "optiondb.h"
 #include "tokenizer.h"
+#include "pathcheck.h"
+#include "buff.h"
+#include "error.h"
+#include "prerender.h"
+#include "completion.h"
+#include "sink.h"
+#include "suggest.h"
+#include "stats.h"
+#include "probes.h"
+
+
+#define DIAG(s, ...) buff_printf(&(s)->diag, __VA_ARGS__)
+#define DIAG_CHAIN(s) cmdstack_format(&(s)->diag, &(s)->cmdstack)
+#define DIAG_FLUSH(s) buff_flush(&(s)->diag, STDERR_FILENO)
 
 
 #define TRYHELP(s) \
-    PERR("Try `"); \
-    cmdstack_print(STDERR_FILENO, &(s)->cmdstack); \
-    PERR(" --help' or `"); \
-    cmdstack_print(STDERR_FILENO, &(s)->cmdstack); \
-    PERR(" --usage' for more information.\n")
-
-#define REJECT_OPTION_MISSINGARGUMENT(s, o) \
-    cmdstack_print(STDERR_FILENO, &(s)->cmdstack); \
-    PERR(": option requires an argument -- '"); \
-    option_print(STDERR_FILENO, o); \
-    PERR("'\n")
-
-#define REJECT_OPTION_HASARGUMENT(s, o) \
-    cmdstack_print(STDERR_FILENO, &(s)->cmdstack); \
-    PERR(": no argument allowed for option -- '"); \
-    option_print(STDERR_FILENO, o); \
-    PERR("'\n")
-
-#define REJECT_OPTION_UNRECOGNIZED(s, name, len) \
-    cmdstack_print(STDERR_FILENO, &(s)->cmdstack); \
-    PERR(": invalid option -- '%s%.*s'\n", \
-        len == 1? "-": "", len, name)
-
-#define REJECT_OPTION_NOTEATEN(s, o) \
-    cmdstack_print(STDERR_FILENO, &(s)->cmdstack); \
-    PERR(": option not eaten -- '"); \
-    option_print(STDERR_FILENO, o); \
-    PERR("'\n")
-
-#define REJECT_OPTION_REDUNDANT(s, o) \
-    cmdstack_print(STDERR_FILENO, &(s)->cmdstack); \
-    PERR(": redundant option -- '"); \
-    option_print(STDERR_FILENO, o); \
-    PERR("'\n")
-
-#define REJECT_POSITIONAL_NOTEATEN(s, t) \
-    cmdstack_print(STDERR_FILENO, &(s)->cmdstack); \
-    PERR(": argument not eaten -- '%s'\n", t)
-
-#define REJECT_POSITIONAL(s, t) \
-    cmdstack_print(STDERR_FILENO, &(s)->cmdstack); \
-    PERR(": invalid argument -- '%s'\n", t)
-
-#define REJECT_POSITIONALCOUNT(s) \
-    cmdstack_print(STDERR_FILENO, &(s)->cmdstack); \
-    PERR(": invalid positional arguments count\n")
+    DIAG(s, "Try `"); \
+    DIAG_CHAIN(s); \
+    DIAG(s, " --help' or `"); \
+    DIAG_CHAIN(s); \
+    DIAG(s, " --usage' for more information.\n")
+
+#define REJECT(s, code, tok) _reject(s, code, (tok)->argindex, \
+        (tok)->offset, (tok)->optioninfo? (tok)->optioninfo->option: NULL, \
+        (tok)->text, (tok)->len)
+
+#define REJECT_PATH(s, i) _reject(s, pathcheck_errcode(i), (i)->argindex, \
+        0, (i)->option, (i)->path, strlen((i)->path))
+
+/* a broken option table, nothing to do on allocation failures */
+#define REJECT_OPTIONDB(s) do { \
+        if ((s)->optiondb.error != YACAP_ERR_NONE) { \
+            _reject(s, (s)->optiondb.error, 0, 0, (s)->optiondb.erroroption, \
+                    NULL, 0); \
+        } \
+    } while (0)
+
+
+/* record the first rejection of the parse, it will be reported (or handed
+ * over to the user via yacap->error) when yacap_parse() returns. */
+static void
+_reject(struct yacap_state *s, enum yacap_errcode code, int argindex,
+        int offset, const struct yacap_option *opt, const char *text,
+        int len) {
+    struct yacap_error *err = &s->error;
+
+    if (err->code != YACAP_ERR_NONE) {
+        return;
+    }
+
+    PROBE_ERROR(code, argindex, offset);
+    err->code = code;
+    err->argindex = argindex;
+    err->offset = offset;
+    err->option = opt;
+    err->text = text;
+    err->len = text? len: 0;
+    err->errnum = 0;
+    err->suggestion = NULL;
+}
+
+
+/* nearest known name for the unrecognized option or sub-command */
+static void
+_suggest(struct yacap_state *s) {
+    struct yacap_error *err = &s->error;
+    const struct yacap_command *cmd = cmdstack_last(&s->cmdstack);
+    struct yacap_command * const *sub;
+    struct suggest *sg = &s->scratch.suggest;
+    const char *eq;
+    int i;
+
+    switch (err->code) {
+        case YACAP_ERR_OPTION_UNRECOGNIZED:
+            /* long options only, there is no near for a single key */
+            if (err->len < 3) {
+                return;
+            }
+
+            eq = memchr(err->text, '=', err->len);
+            suggest_init(sg, err->text + 2,
+                    (eq? eq - err->text: err->len) - 2);
+            for (i = 0; i < s->optiondb.count; i++) {
+                suggest_feed(sg, optioninfo_name(s->optiondb.repo + i));
+            }
+            break;
+
+        case YACAP_ERR_POSITIONAL:
+        case YACAP_ERR_POSITIONAL_NOTEATEN:
+            if ((cmd == NULL) || (cmd->commands == NULL)) {
+                return;
+            }
+
+            suggest_init(sg, err->text, err->len);
+            for (sub = cmd->commands; *sub; sub++) {
+                suggest_feed(sg, (*sub)->name);
+            }
+            break;
+
+        default:
+            return;
+    }
+
+    err->suggestion = sg->best;
+}
 
 
 static int
 _optiondb_init(const struct yacap *c, struct optiondb *db) {
-    if (optiondb_init(db)) {
+    if (optiondb_init(db, STATE_ALLOCATOR(c->state))) {
         return -1;
     }
 
@@ -174,7 +232,7 @@ _clogverbosity(const char *value) {
 
 
 static enum yacap_eatstatus
-_eat(const struct yacap *c, const struct yacap_command *command,
+_dispatch(const struct yacap *c, const struct yacap_command *command,
         const struct yacap_option *opt, const char *value) {
     /* Try to solve it internaly */
     if (c->version && (opt == &opt_version)) {
@@ -183,7 +241,12 @@ _eat(const struct yacap *c, const struct yacap_command *command,
     }
 
     if ((!HASFLAG(c, YACAP_NO_HELP)) && (opt == &opt_help)) {
-        yacap_help_print(c);
+        if (value && value[0]) {
+            yacap_helpsearch_print(c, value);
+        }
+        else {
+            yacap_help_print(c);
+        }
         return YACAP_EAT_OK_EXIT;
     }
 
@@ -219,8 +282,47 @@ _eat(const struct yacap *c, const struct yacap_command *command,
 }
 
 
-/* Helper macro */
-#define NEXT(t, tok) tokenizer_next(t, tok)
+static enum yacap_eatstatus
+_eat(const struct yacap *c, const struct yacap_command *command,
+        const struct yacap_option *opt, const char *value) {
+    enum yacap_eatstatus status;
+    int event = TRACE_BEGIN(c->state, TRACE_EAT, opt);
+
+    PROBE_EAT_ENTRY(opt? opt->key: 0, opt? opt->name: NULL, value);
+    status = _dispatch(c, command, opt, value);
+    PROBE_EAT_RETURN(opt? opt->key: 0, status);
+    TRACE_END(c->state, event);
+    return status;
+}
+
+
+static int
+_init(struct yacap_state *state, struct yacap_command *cmd) {
+    int status;
+    int event;
+
+    if (cmd->init == NULL) {
+        return 0;
+    }
+
+    event = TRACE_BEGIN(state, TRACE_INIT, cmd);
+    status = cmd->init(cmd);
+    TRACE_END(state, event);
+    return status;
+}
+
+
+/* fetches the next token and counts it */
+static enum tokenizer_status
+_next(struct yacap_state *state, struct tokenizer *t, struct token *tok) {
+    enum tokenizer_status status = tokenizer_next(t, tok);
+
+    if ((status != YACAP_TOK_END) && (status != YACAP_TOK_ERROR)) {
+        state->stats.tokens++;
+    }
+
+    return status;
+}
 
 
 static enum yacap_status
@@ -228,23 +330,30 @@ _command_parse(struct yacap *c, struct tokenizer *t) {
     enum yacap_status status = YACAP_OK;
     enum tokenizer_status tokstatus;
     enum yacap_eatstatus eatstatus;
+    enum yacap_optionflags pathflags;
     struct token tok;
     struct token nexttok;
     struct yacap_state *state = c->state;
     const struct yacap_command *cmd = cmdstack_last(&state->cmdstack);
-    struct yacap_command *subcmd = NULL;
-    int arghint = arghint_parse(cmd->args);
-
-    if (optiondb_insertvector(&state->optiondb, cmd->options, cmd) == -1) {
+    struct yacap_command *subcmd;
+    struct arghint arghint;
+    enum arghint_status hintstatus;
+
+    /* sub-commands are entered by jumping back here, the chain is kept by
+     * the cmdstack on the heap, so the stack usage doesn't grow by the
+     * depth. */
+descend:
+    if (optiondb_insertcommand(&state->optiondb, cmd) == -1) {
+        REJECT_OPTIONDB(state);
         status = YACAP_FATAL;
         goto terminate;
     }
 
     do {
         /* fetch the next token */
-        if ((tokstatus = NEXT(t, &tok)) <= YACAP_TOK_END) {
+        if ((tokstatus = _next(state, t, &tok)) <= YACAP_TOK_END) {
             if (tokstatus == YACAP_TOK_UNKNOWN) {
-                REJECT_OPTION_UNRECOGNIZED(state, tok.text, tok.len);
+                REJECT(state, YACAP_ERR_OPTION_UNRECOGNIZED, &tok);
                 status = YACAP_USERERROR;
             }
             goto terminate;
@@ -253,20 +362,26 @@ _command_parse(struct yacap *c, struct tokenizer *t) {
         /* is this a positional? */
         if (tok.optioninfo == NULL) {
             /* is this a sub-command? */
-            subcmd = command_findbyname(cmd, tok.text);
+            subcmd = command_findbyname(cmd, tok.text, &state->stats);
             if (subcmd) {
-                if (subcmd->init && subcmd->init(subcmd)) {
+                if (state->cmdstack.len == state->cmdstack.max) {
+                    REJECT(state, YACAP_ERR_COMMAND_TOODEEP, &tok);
                     status = YACAP_FATAL;
                     goto terminate;
                 }
 
                 if (cmdstack_push(&state->cmdstack, tok.text, subcmd) == -1) {
                     status = YACAP_FATAL;
+                    goto terminate;
                 }
-                else {
-                    status = _command_parse(c, t);
+
+                if (_init(state, subcmd)) {
+                    status = YACAP_FATAL;
+                    goto terminate;
                 }
-                goto terminate;
+
+                cmd = subcmd;
+                goto descend;
             }
 
             /* it's positional */
@@ -275,10 +390,16 @@ _command_parse(struct yacap *c, struct tokenizer *t) {
             goto dessert;
         }
 
+        /* option table entries are unpacked when they are matched */
+        if (optiondb_unpack(&state->optiondb, tok.optioninfo)) {
+            status = YACAP_FATAL;
+            goto terminate;
+        }
+
         /* ensure option occureances */
         if ((!HASFLAG(tok.optioninfo->option, YACAP_OPTION_MULTIPLE)) &&
                 (tok.optioninfo->occurances > 1)) {
-            REJECT_OPTION_REDUNDANT(state, tok.optioninfo->option);
+            REJECT(state, YACAP_ERR_OPTION_REDUNDANT, &tok);
             status = YACAP_USERERROR;
             goto terminate;
         }
@@ -288,47 +409,59 @@ _command_parse(struct yacap *c, struct tokenizer *t) {
         if (YACAP_OPTION_ARGNEEDED(tok.optioninfo->option)) {
             if (tok.text == NULL) {
                 /* try the next token as value */
-                if ((tokstatus = NEXT(t, &nexttok))
+                if ((tokstatus = _next(state, t, &nexttok))
                         != YACAP_TOK_POSITIONAL) {
-                    REJECT_OPTION_MISSINGARGUMENT(state,
-                            tok.optioninfo->option);
+                    REJECT(state, YACAP_ERR_OPTION_MISSINGARGUMENT, &tok);
                     status = YACAP_USERERROR;
                     goto terminate;
                 }
 
                 tok.text = nexttok.text;
                 tok.len = nexttok.len;
+                tok.argindex = nexttok.argindex;
+                tok.offset = nexttok.offset;
             }
             eatstatus = _eat(c, tok.optioninfo->command,
                     tok.optioninfo->option, tok.text);
         }
         else {
-            if (tok.text) {
-                REJECT_OPTION_HASARGUMENT(state, tok.optioninfo->option);
+            /* --help=KEYWORD searches the whole sub-tree */
+            if (tok.text && (tok.optioninfo->option != &opt_help)) {
+                REJECT(state, YACAP_ERR_OPTION_HASARGUMENT, &tok);
                 status = YACAP_USERERROR;
                 goto terminate;
             }
             eatstatus = _eat(c, tok.optioninfo->command,
-                    tok.optioninfo->option, NULL);
+                    tok.optioninfo->option, tok.text);
         }
 
 dessert:
         switch (eatstatus) {
             case YACAP_EAT_OK:
+                /* defer path checks until the whole line is parsed */
+                pathflags = PATHCHECK_FLAGS(tok.optioninfo?
+                        tok.optioninfo->option->flags: cmd->argflags);
+                if (pathflags && pathcheck_append(&state->pathcheck, tok.text,
+                            tok.argindex,
+                            tok.optioninfo? tok.optioninfo->option: NULL,
+                            pathflags)) {
+                    status = YACAP_FATAL;
+                    goto terminate;
+                }
                 continue;
             case YACAP_EAT_OK_EXIT:
                 status = YACAP_OK_EXIT;
                 goto terminate;
             case YACAP_EAT_UNRECOGNIZED:
-                REJECT_POSITIONAL(state, tok.text);
+                REJECT(state, YACAP_ERR_POSITIONAL, &tok);
                 status = YACAP_USERERROR;
                 goto terminate;
             case YACAP_EAT_NOTEATEN:
                 if (tok.optioninfo) {
-                    REJECT_OPTION_NOTEATEN(state, tok.optioninfo->option);
+                    REJECT(state, YACAP_ERR_OPTION_NOTEATEN, &tok);
                 }
                 else {
-                    REJECT_POSITIONAL_NOTEATEN(state, tok.text);
+                    REJECT(state, YACAP_ERR_POSITIONAL_NOTEATEN, &tok);
                 }
             default:
                 status = YACAP_FATAL;
@@ -337,9 +470,23 @@ dessert:
     } while (tokstatus > YACAP_TOK_END);
 
 terminate:
-    if ((status == YACAP_OK) && (subcmd == NULL) &&
-            arghint_validate(state->positionals, arghint)) {
-        REJECT_POSITIONALCOUNT(state);
+    /* only the hint of the last command is checked, malformed hints are not
+     * enforced */
+    if (status != YACAP_OK) {
+        return status;
+    }
+
+    /* the commands are writable, see the init hook */
+    hintstatus = arghint_cached(&arghint,
+            &((struct yacap_command *)cmd)->arghint, cmd->args,
+            &state->scratch.nfa);
+    if (hintstatus == ARGHINT_TOOCOMPLEX) {
+        _reject(state, YACAP_ERR_ARGHINT_TOOCOMPLEX, 0, 0, NULL, NULL, 0);
+        status = YACAP_FATAL;
+    }
+    else if ((hintstatus == ARGHINT_OK) &&
+            arghint_validate(&arghint, state->positionals)) {
+        REJECT(state, YACAP_ERR_POSITIONALCOUNT, &tok);
         status = YACAP_USERERROR;
     }
 
@@ -347,46 +494,82 @@ terminate:
 }
 
 
-enum yacap_status
-yacap_parse(struct yacap *c, int argc, const char **argv,
+static enum yacap_status
+_parse(struct yacap *c, int argc, const char **argv,
         const struct yacap_command **command) {
     struct yacap_state *state;
     enum yacap_status status = YACAP_OK;
     enum tokenizer_status tokstatus;
     struct token tok;
-    struct tokenizer *t;
+    struct tokenizer *t = NULL;
+    struct pathinfo *rejected;
+    int event;
+    uint64_t start;
+    uint64_t mark;
+    struct yacap_stats stats = {0};
+    struct allocator_counter counter;
 
     if (argc < 1) {
         return YACAP_FATAL;
     }
 
-    /* allocate the context */
-    state = malloc(sizeof(struct yacap_state));
+#ifdef YACAP_USE_COMPLETION
+    /* dynamic completion, without the init hooks and the eaters */
+    if (completion_requested(c, argc, argv)) {
+        return completion_complete(c, argc, argv)? YACAP_FATAL:
+            YACAP_OK_EXIT;
+    }
+#endif
+
+    /* allocate the context, it's counted by a counter of it's own until
+     * the one of the state is in place */
+    start = stats_now();
+    allocator_counter_init(&counter, c->allocator, &stats);
+    state = allocator_alloc(&counter.allocator, sizeof(struct yacap_state));
     if (state == NULL) {
         return YACAP_FATAL;
     }
-    memset(state, 0, sizeof(struct yacap_state));
+    memset(state, 0, STATE_CLEARSIZE);
     state->positionals = 0;
+    state->stats = stats;
+    allocator_counter_init(&state->counter, c->allocator, &state->stats);
+    pathcheck_init(&state->pathcheck, STATE_ALLOCATOR(state));
+    cmdstack_init(&state->cmdstack, CMDSTACK_MAX(c), STATE_ALLOCATOR(state));
+    if (c->error) {
+        memset(c->error, 0, sizeof(struct yacap_error));
+    }
+    buff_initgrowable(&state->diag, state->diagbuff,
+            sizeof(state->diagbuff), STATE_ALLOCATOR(state));
     c->state = state;
 
+#ifdef YACAP_USE_TRACE
+    state->trace = trace_new(secure_getenv("YACAP_TRACE"),
+            STATE_ALLOCATOR(state));
+#endif
+    event = TRACE_BEGIN(state, TRACE_SETUP, NULL);
+
     /* create and initialize a database to index all (root & subcommand)
      * options. */
     if (_optiondb_init(c, &state->optiondb)) {
-        return YACAP_FATAL;
+        TRACE_END(state, event);
+        REJECT_OPTIONDB(state);
+        status = YACAP_FATAL;
+        goto terminate;
     }
+    state->optiondb.stats = &state->stats;
 
     /* create a tokenizer */
-    t = tokenizer_new(argc, argv, &state->optiondb);
+    t = tokenizer_new(argc, argv, &state->optiondb, STATE_ALLOCATOR(state));
     if (t == NULL) {
-        optiondb_dispose(&state->optiondb);
+        state->counter.stats = NULL;
         return YACAP_FATAL;
     }
-
-    /* initialize command stack */
-    cmdstack_init(&state->cmdstack);
+    TRACE_END(state, event);
+    mark = stats_now();
+    state->stats.setupns = mark - start;
 
     /* excecutable name */
-    if ((tokstatus = NEXT(t, &tok)) != YACAP_TOK_POSITIONAL) {
+    if ((tokstatus = _next(state, t, &tok)) != YACAP_TOK_POSITIONAL) {
         goto terminate;
     }
 
@@ -397,10 +580,24 @@ yacap_parse(struct yacap *c, int argc, const char **argv,
     c->name = tok.text;
 
     status = _command_parse(c, t);
+    state->stats.parsens = stats_now() - mark;
     if (status < YACAP_OK) {
         goto terminate;
     }
 
+    /* check all collected paths at once */
+    event = TRACE_BEGIN(state, TRACE_PATHCHECK, NULL);
+    mark = stats_now();
+    rejected = (status == YACAP_OK)? pathcheck_run(&state->pathcheck): NULL;
+    state->stats.pathcheckns = stats_now() - mark;
+    TRACE_END(state, event);
+    if (rejected) {
+        REJECT_PATH(state, rejected);
+        state->error.errnum = rejected->errnum;
+        status = YACAP_USERERROR;
+        goto terminate;
+    }
+
     /* commands */
     if (command) {
         *command = cmdstack_last(&state->cmdstack);
@@ -408,14 +605,110 @@ yacap_parse(struct yacap *c, int argc, const char **argv,
 
 terminate:
     tokenizer_dispose(t);
-    optiondb_dispose(&state->optiondb);
-    if (status == YACAP_USERERROR) {
-        TRYHELP(state);
+    if (state->error.code != YACAP_ERR_NONE) {
+        _suggest(state);
+        if (c->error) {
+            *c->error = state->error;
+        }
+        else {
+            /* the chain is empty when the root options are broken */
+            if (state->cmdstack.len) {
+                DIAG_CHAIN(state);
+            }
+            else {
+                DIAG(state, "%s", argv[0]? argv[0]: "yacap");
+            }
+            DIAG(state, ": ");
+            error_format(&state->diag, &state->error);
+            DIAG(state, "\n");
+            if (state->error.suggestion) {
+                DIAG(state, "Did you mean '%s%s'?\n",
+                        state->error.code == YACAP_ERR_OPTION_UNRECOGNIZED?
+                        "--": "", state->error.suggestion);
+            }
+            if (status == YACAP_USERERROR) {
+                TRYHELP(state);
+            }
+        }
     }
+    DIAG_FLUSH(state);
+
+    if (state->cmdstack.len) {
+        state->stats.depth = state->cmdstack.len - 1;
+    }
+    state->stats.totalns = stats_now() - start;
+
+    if (state->trace) {
+        trace_write(state->trace, c->name? c->name: "yacap");
+        trace_free(state->trace);
+        state->trace = NULL;
+    }
+
+    state->counter.stats = NULL;
+    return status;
+}
+
+
+enum yacap_status
+yacap_parse(struct yacap *c, int argc, const char **argv,
+        const struct yacap_command **command) {
+    enum yacap_status status;
+
+    PROBE_PARSE_ENTRY(argc, argv);
+    status = _parse(c, argc, argv, command);
+    PROBE_PARSE_RETURN(status);
     return status;
 }
 
 
+#ifdef YACAP_USE_PRERENDER
+/* argv: OUTPUT SYMBOL [compress] [search] [strip], the twin built by
+ * yacap_prerender_help() calls it instead of yacap_parse(). */
+enum yacap_status
+yacap_prerender_main(const struct yacap *c, int argc, const char **argv) {
+    int i;
+    int flags = 0;
+
+    if ((c == NULL) || (argc < 3)) {
+        return YACAP_FATAL;
+    }
+
+    for (i = 3; i < argc; i++) {
+        if (STREQ(argv[i], "compress")) {
+            flags |= PRERENDER_COMPRESS;
+        }
+        else if (STREQ(argv[i], "search")) {
+            flags |= PRERENDER_SEARCH;
+        }
+        else if (STREQ(argv[i], "strip")) {
+            flags |= PRERENDER_STRIP;
+        }
+        else {
+            return YACAP_FATAL;
+        }
+    }
+
+    return prerender_write(c, argv[1], argv[2], flags)? YACAP_FATAL:
+        YACAP_OK_EXIT;
+}
+#endif
+
+
+#ifdef YACAP_USE_COMPLETION
+/* argv: OUTPUT SHELL PROG, the twin built by yacap_completion() calls it
+ * instead of yacap_parse(). */
+enum yacap_status
+yacap_completion_main(const struct yacap *c, int argc, const char **argv) {
+    if ((c == NULL) || (argc != 4)) {
+        return YACAP_FATAL;
+    }
+
+    return completion_write(c, argv[3], argv[2], argv[1])? YACAP_FATAL:
+        YACAP_OK_EXIT;
+}
+#endif
+
+
 int
 yacap_dispose(struct yacap *c) {
     if (c == NULL) {
@@ -426,7 +719,18 @@ yacap_dispose(struct yacap *c) {
         return -1;
     }
 
-    free(c->state);
+    /* the matched entries of option tables are referenced by the error
+     * record and the eaters, so the db lives as long as the state. */
+    optiondb_dispose(&c->state->optiondb);
+    cmdstack_dispose(&c->state->cmdstack);
+    pathcheck_dispose(&c->state->pathcheck);
+    buff_free(&c->state->diag);
+    trace_free(c->state->trace);
+    if (c->state->search) {
+        search_dispose(c->state->search);
+        allocator_free(STATE_ALLOCATOR(c->state), c->state->search);
+    }
+    allocator_free(c->allocator, c->state);
     c->state = NULL;
     return 0;
 }
@@ -443,19 +747,72 @@ yacap_try_help(const struct yacap* c) {
     }
 
     TRYHELP(c->state);
+    DIAG_FLUSH(c->state);
     return 0;
 }
 
 
+int
+yacap_commandchain_render(const struct yacap *c, struct yacap_sink *sink) {
+    struct buff b;
+    int status;
+
+    if ((c == NULL) || (c->state == NULL) || (sink == NULL)) {
+        return -1;
+    }
+
+    help_scratch(&b, c);
+    if (cmdstack_format(&b, &c->state->cmdstack) == -1) {
+        help_scratchfree(&b, c);
+        return -1;
+    }
+
+    status = sink_write(sink, b.data, b.len);
+    help_scratchfree(&b, c);
+    return status;
+}
+
+
 int
 yacap_commandchain_print(int fd, const struct yacap *c) {
+    int status;
+    struct yacap_sink sink = SINK_FD(fd, c);
+
     if (fd < 0) {
         return -1;
     }
 
-    if (c == NULL) {
-        return -1;
+    status = yacap_commandchain_render(c, &sink);
+    if (sink_drain(&sink)) {
+        status = -1;
+    }
+    yacap_sink_dispose(&sink);
+    return status;
+}
+
+
+const struct yacap_stats *
+yacap_stats(const struct yacap *c) {
+    if ((c == NULL) || (c->state == NULL)) {
+        return NULL;
+    }
+
+    return &c->state->stats;
+}
+
+
+const struct stat *
+yacap_pathstat(const struct yacap *c, const char *path) {
+    const struct pathinfo *info;
+
+    if ((c == NULL) || (c->state == NULL)) {
+        return NULL;
+    }
+
+    info = pathcheck_find(&c->state->pathcheck, path);
+    if ((info == NULL) || info->errnum) {
+        return NULL;
     }
 
-    return cmdstack_print(fd, &c->state->cmdstack);
+    return &info->stat;
 }